@@ -14,6 +14,9 @@
 
 #include "PID.h"
 #include "logger.h"
+#include "constants.h"
+
+#include <math.h>
 
 PID::PID(PIDConstants *newConstants, float minError, float maxError) {
 	_constants.kp = newConstants->kp;
@@ -21,57 +24,102 @@ PID::PID(PIDConstants *newConstants, float minError, float maxError) {
 	_constants.kd = newConstants->kd;
 	_minError = minError;
 	_maxError = maxError;
-	// zero out integrator error
-	for (int i = 0; i < NUM_INTEGRATOR_VALUES; i++) {
-		_integratorValues[i] = 0.0;
-	}
+	_speeds = NULL;
+	_speedStride = 1;
+	flushPID();
 }
 
 /**************************************
  * Definition: Updates the PID control with a new value and
- *             returns the gain
+ *             returns the gain, assuming it's been one control
+ *             loop period since the last update
  *
  * Parameters: a float error
  *
  * Returns:    a float specifying gain
  **************************************/
 float PID::updatePID(float error) {
-	float prevError = lastError();
-	// add the error to the integrator list
-	addErrorToIntegrator(error);
-
-	/**
-	 * total term should = 1 at error = 10
-	 * 
-	 * pTerm should almost max out when error > 10
-	 * suggested value: 0.9
-	 * 
-	 * iTerm should max out at maxValue/minValue and should affect the speed by that much
-	 * 	i.e. if the sum is greater than 100 (the last 10 reads have been greater than 10)
-	 * then the value that we get should be maxValue for iTerm
-	 * suggested value: 0.5
-	 * 
-	 * dTerm shouldn't really do much, since the bot probably won't jump around too much 
-	 * and so the robot should not take too much of this into account
-	 * suggested value = 0.05
-	 */
+	return updatePID(error, CONTROL_LOOP_PERIOD);
+}
+
+/**************************************
+ * Definition: Updates the PID control with a new value and
+ *             returns the gain, with no feed-forward
+ *
+ * Parameters: a float error and the seconds since the last update
+ *
+ * Returns:    a float specifying gain
+ **************************************/
+float PID::updatePID(float error, float dt) {
+	return updatePID(error, dt, 0);
+}
+
+/**************************************
+ * Definition: Updates the PID control with a new value and
+ *             returns the gain (0 to 1). The gains are tuned for
+ *             updates a control loop period apart, so the integral
+ *             and derivative are scaled by how long it has really
+ *             been. The integral stops growing while the gain is
+ *             pinned at 0 or 1 and the error would only pin it
+ *             harder, so it doesn't wind up and overshoot once the
+ *             error finally comes down
+ *
+ * Parameters: a float error, the seconds since the last update,
+ *             and the speed we want to be going (for feed-forward,
+ *             see setFeedForward)
+ *
+ * Returns:    a float specifying gain
+ **************************************/
+float PID::updatePID(float error, float dt, float velocity) {
+	if (dt <= 0) {
+		dt = CONTROL_LOOP_PERIOD;
+	}
+	float periods = dt / CONTROL_LOOP_PERIOD;
 
 	// get proportional term of the PID control
-	float pTerm = _constants.kp * error;						
-	// get integral term of the PID control
-	float iTerm = _constants.ki * currentIntegratorError();	
-	// check that the integrator is not too high 
-	if (iTerm > _maxError * 0.10) {							
-		iTerm = 0.1;
-    }
-	else if (iTerm < _minError * 0.10) {
-		iTerm = -0.1;
-    }
-
-    // get differential term by multiplying by the change in error 
-	float dTerm = _constants.kd * (error - prevError);
-
-	float gain = pTerm + iTerm + dTerm;
+	float pTerm = _constants.kp * error;
+
+	// get differential term from the low-passed rate of change in
+	// error, leaving it alone on the first update so we don't kick
+	if (_hasLastError) {
+		float rate = (error - _lastError) / periods;
+		float alpha = dt / (PID_DERIVATIVE_TAU + dt);
+		_derivative += alpha * (rate - _derivative);
+	}
+	float dTerm = _constants.kd * _derivative;
+	_lastError = error;
+	_hasLastError = true;
+
+	float fTerm = feedForward(velocity);
+
+	// integrate the error (ignoring wild readings past what we expect)
+	float integrated = error;
+	if (integrated > _maxError) {
+		integrated = _maxError;
+	}
+	else if (integrated < _minError) {
+		integrated = _minError;
+	}
+	float integral = _integral + integrated * periods;
+
+	// get integral term of the PID control, never worth
+	// more than the whole gain on its own
+	float iTerm = _constants.ki * integral;
+	if (iTerm > 1.0) {
+		iTerm = 1.0;
+	}
+	else if (iTerm < -1.0) {
+		iTerm = -1.0;
+	}
+
+	float gain = fTerm + pTerm + iTerm + dTerm;
+
+	// only keep the new integral if it isn't pushing further into
+	// saturation (or we're not saturated at all)
+	if (!(gain > 1.0 && integrated > 0) && !(gain < 0.0 && integrated < 0)) {
+		_integral = integral;
+	}
+
 	if (gain > 1.0) {
 		gain = 1.0;
 	}
@@ -83,38 +131,65 @@ float PID::updatePID(float error) {
 }
 
 /**************************************
- * Definition: Clears integrator by zeroing it out. Useful when you have
- *             reached the destination and want to remove the error
+ * Definition: Sets the robot's speed at each integer robot speed,
+ *             so a speed we want to go can be turned into the gain
+ *             that gets it (like SPEED_FORWARD, or one column of
+ *             SPEED_TURN)
+ *
+ * Parameters: NUM_SPEEDS speeds every stride floats apart (NULL
+ *             for no feed-forward), and the stride
  **************************************/
-void PID::flushPID() {
-	for (int i = 0; i < NUM_INTEGRATOR_VALUES; i++) {
-		_integratorValues[i] = 0.0;
-	}
+void PID::setFeedForward(const float *speeds, int stride) {
+	_speeds = speeds;
+	_speedStride = stride;
 }
 
 /**************************************
- * Definition: Adds an error to the fixed-size integrator list 
+ * Definition: Finds the gain that gets the robot going at least
+ *             the given speed, the way Robot turns gains into robot
+ *             speeds (gain 1 is speed 1, the fastest, and gain 0 is
+ *             speed 10). The speed tables aren't in order, so this
+ *             takes the slowest robot speed that's fast enough
  *
- * Parameters: a float error
+ * Parameters: the speed we want (ignoring its sign)
+ *
+ * Returns:    a float gain from 0 to 1
  **************************************/
-void PID::addErrorToIntegrator(float error) {
-	for (int i = NUM_INTEGRATOR_VALUES-1; i > 0; i--) {
-		_integratorValues[i] = _integratorValues[i-1];
+float PID::feedForward(float velocity) {
+	velocity = fabs(velocity);
+	if (_speeds == NULL || velocity == 0) {
+		return 0;
+	}
+
+	int speed = 1;
+	for (int s = NUM_SPEEDS - 1; s > 0; s--) {
+		if (fabs(_speeds[s * _speedStride]) >= velocity) {
+			speed = s;
+			break;
+		}
 	}
-	_integratorValues[0] = error;
+	return (NUM_SPEEDS - 1 - speed) / (float)(NUM_SPEEDS - 2);
+}
+
+/**************************************
+ * Definition: Clears integrator by zeroing it out. Useful when you have
+ *             reached the destination and want to remove the error
+ **************************************/
+void PID::flushPID() {
+	_integral = 0.0;
+	_lastError = 0.0;
+	_hasLastError = false;
+	_derivative = 0.0;
 }
 
 /**************************************
- * Definition: Returns the current integrator error (sum of errors)
+ * Definition: Returns the current integrator error (the error
+ *             integrated over time, in control loop periods)
  *
- * Returns:    a float error representing the sum of integrator errors
+ * Returns:    a float error representing the integrated error
  **************************************/
 float PID::currentIntegratorError() {
-	float error = 0.0;
-	for (int i = 0; i < NUM_INTEGRATOR_VALUES; i++) {
-		error += _integratorValues[i];
-	}
-	return error;
+	return _integral;
 }
 
 /**************************************
@@ -123,7 +198,7 @@ float PID::currentIntegratorError() {
  * Returns:    a float error
  **************************************/
 float PID::lastError() {
-	return _integratorValues[0];
+	return _lastError;
 }
 
 /**************************************
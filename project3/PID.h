@@ -19,26 +19,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define NUM_INTEGRATOR_VALUES 10
-
 typedef struct {
-	float ki, kp, kd;
+	float kp, ki, kd;
 } PIDConstants;
 
 class PID {
 public:
 	PID(PIDConstants *constants, float minError, float maxError);
 	float updatePID(float error);
+	float updatePID(float error, float dt);
+	float updatePID(float error, float dt, float velocity);
+	void setFeedForward(const float *speeds, int stride);
+	float feedForward(float velocity);
 	void flushPID();
-	void addErrorToIntegrator(float error);
 	float currentIntegratorError();
 	float lastError();
 	void setConstants(PIDConstants *newConstants);
 private:
-	float _integratorValues[NUM_INTEGRATOR_VALUES];
+	// running integral of the error, in error control loop periods
+	float _integral;
+	float _lastError;
+	bool _hasLastError;
+	// low-passed derivative, in error per control loop period
+	float _derivative;
 	PIDConstants _constants;
 	float _minError;
 	float _maxError;
+	// robot speed (at each integer speed) to feed forward from,
+	// every stride floats, or NULL for none
+	const float *_speeds;
+	int _speedStride;
 };
 
 #endif
@@ -20,7 +20,7 @@
 
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
-#include <robot_if++.h>
+#include "robot_interface.h"
 #include <robot_color.h>
 
 #include "fir_filter.h"
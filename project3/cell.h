@@ -16,7 +16,7 @@
 #ifndef CS1567_CELL_H
 #define CS1567_CELL_H
 
-#include <robot_if++.h>
+#include "robot_interface.h"
 
 class Cell {
 public:
@@ -0,0 +1,246 @@
+/**
+ * command_layer.cpp
+ *
+ * @brief
+ *      Sits between the robot and its robot interface, cutting down on
+ *      round trips to the rovio. A drive command the same as the last
+ *      one, sent again before the last one has run out, is dropped, and
+ *      a burst of different drive commands faster than the rovio can
+ *      act on them is coalesced so only the newest is sent (though a
+ *      stop always lets the drive command before it out first). Failed
+ *      updates are retried with exponential backoff instead of back to
+ *      back. It also holds the lock every use of the interface needs,
+ *      since the pipeline's threads share it
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "command_layer.h"
+#include "constants.h"
+#include "utilities.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#ifdef USE_SIMULATOR
+#include "data/fakerobot/sim_clock.h"
+#endif
+
+CommandLayer::CommandLayer(RobotInterface *robotInterface)
+: _robotInterface(robotInterface), _hasLast(false), _lastCommand(RI_STOP),
+  _lastSpeed(0), _lastSent(0), _hasLastDrive(false), _lastDriveSent(0),
+  _hasPending(false), _pendingCommand(RI_STOP),
+  _pendingSpeed(0), _sent(0), _repeatsDropped(0), _coalesced(0),
+  _updates(0), _updateFailures(0), _backoffTime(0) {
+    pthread_mutex_init(&_lock, NULL);
+}
+
+CommandLayer::~CommandLayer() {
+    pthread_mutex_destroy(&_lock);
+}
+
+/**************************************
+ * Definition: Takes the interface lock. Everything else here (and
+ *             any other use of the robot interface) needs it held
+ **************************************/
+void CommandLayer::lock() {
+    pthread_mutex_lock(&_lock);
+}
+
+/**************************************
+ * Definition: Gives up the interface lock
+ **************************************/
+void CommandLayer::unlock() {
+    pthread_mutex_unlock(&_lock);
+}
+
+/**************************************
+ * Definition: Sends a command to the rovio, unless it's the same
+ *             as the last one and the last one hasn't run out yet
+ *             (COMMAND_REPEAT_INTERVAL). A drive command that comes
+ *             too soon after the last drive command sent
+ *             (COMMAND_MIN_INTERVAL) waits to be flushed, replacing
+ *             any drive command already waiting. Stops and head moves
+ *             always go now, and a stop sends the waiting drive
+ *             command first, since turns and strafes are a drive
+ *             command and a stop right after it
+ *
+ * Parameters: the command (RI_*) and speed
+ **************************************/
+void CommandLayer::move(int command, int speed) {
+    double now = _now();
+
+    if (_hasPending && _isDrive(command)) {
+        _hasPending = false;
+        _coalesced++;
+    }
+    else if (_hasPending && command == RI_STOP) {
+        _hasPending = false;
+        _send(_pendingCommand, _pendingSpeed, now);
+    }
+
+    if (_hasLast && command == _lastCommand && speed == _lastSpeed &&
+        now - _lastSent < COMMAND_REPEAT_INTERVAL) {
+        _repeatsDropped++;
+        return;
+    }
+
+    if (_isDrive(command) && _hasLastDrive &&
+        now - _lastDriveSent < COMMAND_MIN_INTERVAL) {
+        _hasPending = true;
+        _pendingCommand = command;
+        _pendingSpeed = speed;
+        return;
+    }
+
+    _send(command, speed, now);
+}
+
+/**************************************
+ * Definition: Updates the robot interface, retrying failures with
+ *             exponentially longer waits in between. The lock is
+ *             given up while waiting, so commands can still go out.
+ *             Any drive command that's done waiting gets sent too
+ *
+ * Parameters: how many times to retry
+ *
+ * Returns:    false if the interface never updated
+ **************************************/
+bool CommandLayer::update(int failLimit) {
+    _updates++;
+    bool success = (_robotInterface->update() == RI_RESP_SUCCESS);
+
+    long wait = UPDATE_BACKOFF_USEC;
+    for (int retry = 0; !success && retry < failLimit; retry++) {
+        _updateFailures++;
+
+        unlock();
+        Util::pause(wait / 1000000.0);
+        lock();
+        _backoffTime += wait / 1000000.0;
+
+        wait *= 2;
+        if (wait > UPDATE_BACKOFF_MAX_USEC) {
+            wait = UPDATE_BACKOFF_MAX_USEC;
+        }
+        success = (_robotInterface->update() == RI_RESP_SUCCESS);
+    }
+    if (!success) {
+        _updateFailures++;
+    }
+
+    flush();
+    return success;
+}
+
+/**************************************
+ * Definition: Sends the waiting drive command, if there is one and
+ *             it has waited long enough
+ **************************************/
+void CommandLayer::flush() {
+    if (!_hasPending) {
+        return;
+    }
+
+    double now = _now();
+    if (now - _lastDriveSent >= COMMAND_MIN_INTERVAL) {
+        _hasPending = false;
+        _send(_pendingCommand, _pendingSpeed, now);
+    }
+}
+
+/**************************************
+ * Definition: Returns how many commands were sent to the rovio
+ *
+ * Returns:    an int count
+ **************************************/
+int CommandLayer::getSent() {
+    return _sent;
+}
+
+/**************************************
+ * Definition: Returns how many repeated commands were dropped
+ *
+ * Returns:    an int count
+ **************************************/
+int CommandLayer::getRepeatsDropped() {
+    return _repeatsDropped;
+}
+
+/**************************************
+ * Definition: Returns how many drive commands were replaced by a
+ *             newer one before they were sent
+ *
+ * Returns:    an int count
+ **************************************/
+int CommandLayer::getCoalesced() {
+    return _coalesced;
+}
+
+/**************************************
+ * Definition: Returns how many times the interface was updated
+ *
+ * Returns:    an int count
+ **************************************/
+int CommandLayer::getUpdates() {
+    return _updates;
+}
+
+/**************************************
+ * Definition: Returns how many interface updates failed
+ *
+ * Returns:    an int count
+ **************************************/
+int CommandLayer::getUpdateFailures() {
+    return _updateFailures;
+}
+
+/**************************************
+ * Definition: Prints how many round trips were saved, and how the
+ *             interface updates went
+ *
+ * Parameters: a name for the printout
+ **************************************/
+void CommandLayer::printStats(const char *name) {
+    printf("%s: %d commands sent, %d round trips saved "
+           "(%d repeats, %d coalesced), %d updates, %d failed, "
+           "%.2f s backing off\n",
+           name, _sent, _repeatsDropped + _coalesced, _repeatsDropped,
+           _coalesced, _updates, _updateFailures, _backoffTime);
+}
+
+void CommandLayer::_send(int command, int speed, double now) {
+    _robotInterface->Move(command, speed);
+    _sent++;
+    _hasLast = true;
+    _lastCommand = command;
+    _lastSpeed = speed;
+    _lastSent = now;
+    if (_isDrive(command)) {
+        _hasLastDrive = true;
+        _lastDriveSent = now;
+    }
+}
+
+// drive commands only last a moment, so a newer one makes an
+// unsent one pointless. stops and head moves don't
+bool CommandLayer::_isDrive(int command) {
+    return command != RI_STOP &&
+           command != RI_HEAD_UP &&
+           command != RI_HEAD_DOWN &&
+           command != RI_HEAD_MIDDLE;
+}
+
+double CommandLayer::_now() {
+#ifdef USE_SIMULATOR
+    return SimClock::now();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+#endif
+}
@@ -0,0 +1,74 @@
+/**
+ * command_layer.h
+ *
+ * @brief
+ *      Sits between the robot and its robot interface, cutting down on
+ *      round trips to the rovio. A drive command the same as the last
+ *      one, sent again before the last one has run out, is dropped, and
+ *      a burst of different drive commands faster than the rovio can
+ *      act on them is coalesced so only the newest is sent (though a
+ *      stop always lets the drive command before it out first). Failed
+ *      updates are retried with exponential backoff instead of back to
+ *      back. It also holds the lock every use of the interface needs,
+ *      since the pipeline's threads share it
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_COMMANDLAYER_H
+#define CS1567_COMMANDLAYER_H
+
+#include "robot_interface.h"
+#include <pthread.h>
+
+class CommandLayer {
+public:
+    CommandLayer(RobotInterface *robotInterface);
+    ~CommandLayer();
+    void lock();
+    void unlock();
+    void move(int command, int speed);
+    bool update(int failLimit);
+    void flush();
+    int getSent();
+    int getRepeatsDropped();
+    int getCoalesced();
+    int getUpdates();
+    int getUpdateFailures();
+    void printStats(const char *name);
+private:
+    RobotInterface *_robotInterface;
+    pthread_mutex_t _lock;
+
+    // the last command actually sent, and when
+    bool _hasLast;
+    int _lastCommand;
+    int _lastSpeed;
+    double _lastSent;
+    // and the last drive command sent, which the next one is
+    // spaced out from
+    bool _hasLastDrive;
+    double _lastDriveSent;
+
+    // a drive command waiting out the minimum interval
+    bool _hasPending;
+    int _pendingCommand;
+    int _pendingSpeed;
+
+    int _sent;
+    int _repeatsDropped;
+    int _coalesced;
+    int _updates;
+    int _updateFailures;
+    double _backoffTime;
+
+    void _send(int command, int speed, double now);
+    static bool _isDrive(int command);
+    static double _now();
+};
+
+#endif
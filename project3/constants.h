@@ -32,6 +32,17 @@
 
 // max allowable fails to update robot interface
 #define MAX_UPDATE_FAILS 5 
+// wait this long (microseconds) before retrying a failed update,
+// doubling each time up to the max
+#define UPDATE_BACKOFF_USEC 20000
+#define UPDATE_BACKOFF_MAX_USEC 320000
+
+// a drive command keeps the rovio going for a moment, so the same
+// command again sooner than this (seconds) is dropped (0 sends them all)
+#define COMMAND_REPEAT_INTERVAL 0.25
+// drive commands closer together than this are coalesced, sending
+// only the newest once the interval is up
+#define COMMAND_MIN_INTERVAL 0.05
 
 /* Kalman uncertainties */
 // process uncertainties
@@ -49,22 +60,137 @@
 #define WE_Y_UNCERTAIN 0.025
 #define WE_THETA_UNCERTAIN 0.10
 
+// use the extended kalman filter (heading-aware motion model)
+// instead of the linear one
+#define USE_EXTENDED_KALMAN true
+
+// time step (in seconds) assumed for the first extended kalman
+// prediction, and the longest step we'll ever predict across
+#define EKF_DEFAULT_DT 0.2
+#define EKF_MAX_DT 1.0
+
+// rate (Hz) the move, turn, and center loops run at. each pass waits on
+// a north star/wheel encoder update (~0.2 s over the network), and turn
+// and strafe commands block for up to half a second, so faster than this
+// just piles up missed deadlines
+#define CONTROL_LOOP_RATE 5.0
+#define CONTROL_LOOP_PERIOD (1.0 / CONTROL_LOOP_RATE)
+
+// run the move and turn loops' sensing, estimation, and motion commands
+// on threads of their own, so one slow network call doesn't stall the
+// others. set to false to run them one after another on one thread
+#ifdef USE_SIMULATOR
+// threads would make simulated games come out differently every run,
+// and the simulator's clock only moves when the one thread waits, so
+// the threaded loops can't be run in the simulator (only on a rovio)
+#define USE_PIPELINE false
+#else
+#define USE_PIPELINE true
+#endif
+// how many samples can wait between the sense and estimate threads
+#define PIPELINE_QUEUE_SIZE 8
+// how long (microseconds) a thread sleeps when it has nothing to do
+#define PIPELINE_IDLE_USEC 1000
+
+// robot speeds run from 1 (fastest) to 10 (slowest), 0 is stopped
+#define NUM_SPEEDS 11
+
+const float TIME_DISTANCE = 116.0; // cm
+
+// average speed to move forward TIME_DISTANCE at integer robot speeds
+const float SPEED_FORWARD[NUM_SPEEDS] = {
+    0.0,
+    TIME_DISTANCE/2.8,
+    TIME_DISTANCE/2.8,
+    TIME_DISTANCE/2.8,
+    TIME_DISTANCE/3.0,
+    TIME_DISTANCE/3.0,
+    TIME_DISTANCE/3.2,
+    TIME_DISTANCE/3.9,
+    TIME_DISTANCE/3.9,
+    TIME_DISTANCE/4.1,
+    TIME_DISTANCE/4.2
+};
+
+// average speed for left and right turns at integer robot speeds
+// (radians per second, indexed by DIR_LEFT/DIR_RIGHT)
+const float SPEED_TURN[NUM_SPEEDS][2] = {
+    {0.0, 0.0},
+    {(2*PI)/2.75, -(2*PI)/2.81},
+    {(2*PI)/2.8, -(2*PI)/2.59},
+    {(2*PI)/3.75, -(2*PI)/3.75},
+    {(2*PI)/3.90, -(2*PI)/3.75},
+    {(2*PI)/5.80, -(2*PI)/6.05},
+    {(2*PI)/5.60, -(2*PI)/5.45},
+    {(2*PI)/4.50, -(2*PI)/4.39},
+    {(2*PI)/4.60, -(2*PI)/4.45},
+    {(2*PI)/5.00, -(2*PI)/5.02},
+    {(2*PI)/10.00, -(2*PI)/8.8}
+};
+
+// turns don't keep going until the next command: they turn for
+// TURN_PULSE_LENGTH seconds and stop. speeds slower than
+// TURN_PULSE_SPEED turn at that speed for TURN_PULSE_STEP less
+// for each step slower
+#define TURN_PULSE_LENGTH 0.3
+#define TURN_PULSE_STEP 0.05
+#define TURN_PULSE_SPEED 6
+
+// the PID gains are per control loop period (the integral is in error
+// periods and the derivative in error per period). the derivative is
+// smoothed with a low-pass filter with this time constant (seconds)
+#define PID_DERIVATIVE_TAU 0.4
+
+// the gains the robots were tuned with were for the old integral (the
+// last 10 errors, worth no more than 0.1), so these are retuned for
+// this one with data/tune_pid.out. check them on the robots
 // Distance PID
-#define PID_MOVE_KP 0.8
-#define PID_MOVE_KI 0.05
-#define PID_MOVE_KD 0.05
+#define PID_MOVE_KP 0.03
+#define PID_MOVE_KI 0.001
+#define PID_MOVE_KD 0.14
+// feed-forward aims for the speed that would cover the remaining
+// distance in this many seconds
+#define PID_MOVE_FF_TIME 2.0
 
 #define MIN_MOVE_ERROR 0
 #define MAX_MOVE_ERROR 65
 
 // Turn PID (based on theta error)
-#define PID_TURN_KP 0.8
-#define PID_TURN_KI 0.15
-#define PID_TURN_KD 0.05
+#define PID_TURN_KP 0.02
+#define PID_TURN_KI 0.011
+#define PID_TURN_KD 3.0
+// and the turn speed that would cover the remaining angle in this many
+#define PID_TURN_FF_TIME 1.0
 
 #define MIN_TURN_ERROR -3.14159
 #define MAX_TURN_ERROR 3.14159
 
+// pick move and turn speeds from trapezoidal speed profiles (ramping
+// up, cruising, and ramping down to stop where we want) instead of
+// straight from the PID gain. the profile plans the whole move on its
+// own, so the move and turn PIDs aren't run while it's on
+#define USE_MOTION_PROFILE true
+// how fast moves can speed up and slow down (cm/s/s)
+#define PROFILE_MOVE_ACCEL 60.0
+#define PROFILE_MOVE_DECEL 60.0
+// and turns (radians/s/s)
+#define PROFILE_TURN_ACCEL 6.0
+#define PROFILE_TURN_DECEL 6.0
+
+// follow whole paths from the map strategy with pure pursuit, instead
+// of stopping to turn and center in every cell
+#define USE_PATH_FOLLOWING true
+// how far ahead along the path (cm) to steer toward
+#define PURSUIT_LOOKAHEAD 40.0
+// turn in place when we're facing further than this from the path (or
+// from the lookahead point)
+#define PURSUIT_MAX_HEADING_ERROR DEGREE_30
+// drive diagonally when the lookahead point is further than this to
+// one side (pi/8, halfway to the diagonal)
+#define PURSUIT_DIAGONAL_ANGLE 0.392699082
+// give up on a path after this many control loop passes per cell
+#define PURSUIT_PASSES_PER_CELL 50
+
 // acceptable proximities from base
 #define MAX_DIST_ERROR 20.0 // in cm
 #define MAX_THETA_ERROR DEGREE_15
@@ -76,14 +202,51 @@
 // the largest filter size (used for prefilling data)
 #define MAX_FILTER_TAPS 7
 
+/* sensor filters */
+// what north star and the wheel encoders smooth their readings with.
+// FIR uses the .ffc files in filters/, the rest are IIR filters
+#define FILTER_FIR 0
+#define FILTER_ONE_POLE 1
+#define FILTER_BIQUAD 2
+#define FILTER_ALPHA_BETA 3
+
+#define NS_FILTER FILTER_FIR
+#define WE_FILTER FILTER_FIR
+
+// iir cutoffs, as a fraction of the update rate
+#define NS_IIR_CUTOFF 0.1
+#define WE_IIR_CUTOFF 0.15
+
 // north star room constants
 #define ROOM_2 0
 #define ROOM_3 1
 #define ROOM_4 2
 #define ROOM_5 3
+#define NUM_ROOMS 4
 
-// (avg) ticks per cm for wheel encoders
-#define WE_SCALE 4.0
+// (avg) ticks per cm a wheel rolls for wheel encoders. this was measured
+// as 4.0 when forward motion was taken as 0.433 of the left and right
+// wheels' ticks, and solving the wheels makes it 0.577 (1 / (2 sin 60)),
+// so it's scaled by 4/3 to keep measuring the same distances
+#define WE_SCALE (4.0 * 4.0 / 3.0)
+
+// which wheel encoders can be trusted on each robot {left, right, rear}.
+// a bad wheel is left out of the odometry, and the motion it would have
+// told us about is assumed (no strafing, then no turning)
+const bool WE_WHEEL_HEALTHY[6][3] = {
+	// Rosie (bad right encoder)
+	{true, false, true},
+	// Bender
+	{true, true, true},
+	// Johnny5
+	{true, true, true},
+	// Optimus (bad left encoder)
+	{false, true, true},
+	// WallE
+	{true, true, true},
+	// Gort
+	{true, true, true}
+};
 
 /* north star transformation constants */
 
@@ -181,6 +344,14 @@ const float NS_ROOM_ROTATION[6][4] = {
      1.6005}
 };
 
+// per robot calibration that overrides the tables above (see ns_calibration.h)
+#define NS_CALIBRATION_FILE "calibration/north_star.cal"
+
+// room 2's north star is skewed: x and y are each rotated by an
+// angle that grows with the raw reading (slope * reading + offset)
+#define NS_ROOM_2_SKEW_SLOPE 0.0000204488
+#define NS_ROOM_2_SKEW_OFFSET -0.0804
+
 // the distance of column top-right corner from base 0 in cm
 const float COL_OFFSET[2] = {193.0, 234.0};
 
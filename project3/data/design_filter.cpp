@@ -0,0 +1,425 @@
+/**
+ * design_filter.cpp
+ *
+ * @brief
+ * 		Designs low-pass FIR filters and evaluates them (or existing .ffc
+ *      files) so we can trade lag against smoothing. A design is either
+ *      a Hamming windowed sinc, or a least-squares fit to an ideal
+ *      low-pass with a chosen delay (less delay than half the taps gives
+ *      a filter that lags less but rings more). For every filter it
+ *      prints the frequency response and group delay, and, given a
+ *      log, prints the column's spectrum (what project1/matlab's
+ *      fastft*.m plotted, to pick the cutoff from), runs it over the
+ *      column with FIRFilter, and measures the actual lag and how much
+ *      it smooths.
+ *
+ *      FIRFilter pairs its first tap with the newest sample and tap i
+ *      with the sample (taps - i) steps old, so the taps written to the
+ *      .ffc are the impulse response in that order, not in time order.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <complex>
+#include <fstream>
+#include "../fir_filter.h"
+#include "../fft.h"
+#include "../constants.h"
+
+#define DEFAULT_TAPS 8
+#define DEFAULT_CUTOFF 0.1
+#define DEFAULT_TRANSITION 0.1
+#define DEFAULT_SECONDS_PER_SAMPLE 0.2
+// frequency points per tap for the least-squares fit
+#define GRID_PER_TAP 16
+// frequencies (as a fraction of the sample rate) in the response table
+#define RESPONSE_STEPS 10
+
+void usage(char *name) {
+	printf("usage: %s [options]\n", name);
+	printf("  -m sinc|ls     design method (default sinc)\n");
+	printf("  -n taps        number of taps (default %d)\n", DEFAULT_TAPS);
+	printf("  -c cutoff      cutoff as a fraction of the sample rate, 0 to 0.5 (default %g)\n", DEFAULT_CUTOFF);
+	printf("  -w width       ls transition band width, same units (default %g)\n", DEFAULT_TRANSITION);
+	printf("  -d delay       ls delay in samples (default half the taps, linear phase)\n");
+	printf("  -o name        write name.ffc and name.ffs\n");
+	printf("  -e file.ffc    evaluate an existing filter instead of designing one\n");
+	printf("  -l log         log to evaluate on (comma separated columns)\n");
+	printf("  -k column      column of the log to use, from 0 (default 0)\n");
+	printf("  -t seconds     seconds per sample in the log (default %g)\n", DEFAULT_SECONDS_PER_SAMPLE);
+	printf("  -h             show this\n");
+	exit(-1);
+}
+
+/**************************************
+ * Definition: Designs a Hamming windowed sinc, scaled to a DC gain of 1
+ *
+ * Parameters: number of taps, cutoff, and impulse response to fill
+ **************************************/
+void designSinc(int taps, float cutoff, std::vector<double> *h) {
+	double middle = (taps - 1) / 2.0;
+	double sum = 0;
+	for (int k = 0; k < taps; k++) {
+		double t = k - middle;
+		double sinc = (t == 0) ? 2 * cutoff : sin(2 * PI * cutoff * t) / (PI * t);
+		double window = (taps == 1) ? 1 : 0.54 - 0.46 * cos(2 * PI * k / (taps - 1));
+		(*h)[k] = sinc * window;
+		sum += (*h)[k];
+	}
+	for (int k = 0; k < taps; k++) {
+		(*h)[k] /= sum;
+	}
+}
+
+/**************************************
+ * Definition: Designs the filter closest (in least squares) to a
+ *             pure delay below the cutoff and zero above the
+ *             transition band, scaled to a DC gain of 1
+ *
+ * Parameters: number of taps, cutoff, transition width, delay in
+ *             samples, and impulse response to fill
+ **************************************/
+void designLeastSquares(int taps, float cutoff, float transition, float delay,
+                        std::vector<double> *h) {
+	// normal equations R h = p over a grid of frequencies
+	std::vector<double> R(taps * taps, 0);
+	std::vector<double> p(taps, 0);
+	int points = GRID_PER_TAP * taps;
+	for (int g = 0; g <= points; g++) {
+		double f = 0.5 * g / points;
+		bool pass = f <= cutoff;
+		if (!pass && f < cutoff + transition) {
+			continue; // don't care about the transition band
+		}
+		double w = 2 * PI * f;
+		for (int k = 0; k < taps; k++) {
+			for (int l = 0; l < taps; l++) {
+				R[k * taps + l] += cos(w * (k - l));
+			}
+			if (pass) {
+				p[k] += cos(w * (k - delay));
+			}
+		}
+	}
+
+	// gaussian elimination with partial pivoting
+	for (int col = 0; col < taps; col++) {
+		int pivot = col;
+		for (int row = col + 1; row < taps; row++) {
+			if (fabs(R[row * taps + col]) > fabs(R[pivot * taps + col])) {
+				pivot = row;
+			}
+		}
+		for (int j = 0; j < taps; j++) {
+			std::swap(R[col * taps + j], R[pivot * taps + j]);
+		}
+		std::swap(p[col], p[pivot]);
+		for (int row = col + 1; row < taps; row++) {
+			double factor = R[row * taps + col] / R[col * taps + col];
+			for (int j = col; j < taps; j++) {
+				R[row * taps + j] -= factor * R[col * taps + j];
+			}
+			p[row] -= factor * p[col];
+		}
+	}
+	double sum = 0;
+	for (int k = taps - 1; k >= 0; k--) {
+		double value = p[k];
+		for (int j = k + 1; j < taps; j++) {
+			value -= R[k * taps + j] * (*h)[j];
+		}
+		(*h)[k] = value / R[k * taps + k];
+		sum += (*h)[k];
+	}
+	for (int k = 0; k < taps; k++) {
+		(*h)[k] /= sum;
+	}
+}
+
+/**************************************
+ * Definition: Returns the frequency response at a frequency
+ *
+ * Parameters: impulse response and frequency as a fraction of
+ *             the sample rate
+ **************************************/
+std::complex<double> response(std::vector<double> *h, double f) {
+	std::complex<double> sum(0, 0);
+	for (unsigned int k = 0; k < h->size(); k++) {
+		sum += (*h)[k] * std::polar(1.0, -2 * PI * f * k);
+	}
+	return sum;
+}
+
+/**************************************
+ * Definition: Returns the group delay (in samples) at a frequency
+ *
+ * Parameters: impulse response and frequency as a fraction of
+ *             the sample rate
+ **************************************/
+double groupDelay(std::vector<double> *h, double f) {
+	std::complex<double> weighted(0, 0);
+	for (unsigned int k = 0; k < h->size(); k++) {
+		weighted += (double) k * (*h)[k] * std::polar(1.0, -2 * PI * f * k);
+	}
+	std::complex<double> H = response(h, f);
+	if (std::abs(H) < 1e-9) {
+		return 0;
+	}
+	return (weighted / H).real();
+}
+
+/**************************************
+ * Definition: Reads one column of a comma separated log
+ *
+ * Parameters: file name, column, and vector to fill
+ **************************************/
+void readColumn(std::string fileName, int column, std::vector<float> *values) {
+	std::ifstream f(fileName.c_str());
+	std::string line;
+	while (std::getline(f, line)) {
+		size_t start = 0;
+		for (int c = 0; c < column && start != std::string::npos; c++) {
+			start = line.find(',', start);
+			if (start != std::string::npos) {
+				start++;
+			}
+		}
+		if (start != std::string::npos && start < line.size()) {
+			values->push_back(atof(line.c_str() + start));
+		}
+	}
+}
+
+/**************************************
+ * Definition: Prints the response table, DC gain, cutoff and
+ *             delay of an impulse response
+ *
+ * Parameters: impulse response and seconds per sample
+ **************************************/
+void reportResponse(std::vector<double> *h, float secondsPerSample) {
+	printf("\nfrequency\tgain (dB)\tgroup delay (samples)\n");
+	for (int s = 0; s <= RESPONSE_STEPS; s++) {
+		double f = 0.5 * s / RESPONSE_STEPS;
+		double gain = std::abs(response(h, f));
+		printf("%.3f\t\t%8.2f\t%6.2f\n", f, 20 * log10(gain > 1e-12 ? gain : 1e-12),
+		       groupDelay(h, f));
+	}
+
+	double dc = std::abs(response(h, 0));
+	double halfPower = 0.5;
+	for (int g = 0; g <= 1000; g++) {
+		double f = 0.5 * g / 1000;
+		if (std::abs(response(h, f)) < dc / sqrt(2.0)) {
+			halfPower = f;
+			break;
+		}
+	}
+	double delay = groupDelay(h, 0);
+	printf("\nDC gain %.4f, -3 dB at %.3f of the sample rate\n", dc, halfPower);
+	printf("lag at DC: %.2f samples (%.3f s)\n", delay, delay * secondsPerSample);
+}
+
+/**************************************
+ * Definition: Prints a log column's amplitude spectrum, the way
+ *             fastft.m did (zero padded to a power of two, single
+ *             sided, scaled by the length), before and after the
+ *             filter. The column's mean is taken out first, or it
+ *             would swamp everything else. Each row is the biggest
+ *             amplitude in its band
+ *
+ * Parameters: impulse response and log values
+ **************************************/
+void reportSpectrum(std::vector<double> *h, std::vector<float> *raw) {
+	int n = raw->size();
+	int size = FFT::nextPowerOfTwo(n);
+	double mean = 0;
+	for (int i = 0; i < n; i++) {
+		mean += (*raw)[i];
+	}
+	mean /= n;
+
+	std::vector<std::complex<double> > data(size, std::complex<double>(0, 0));
+	for (int i = 0; i < n; i++) {
+		data[i] = (*raw)[i] - mean;
+	}
+	FFT::transform(&data[0], size, false);
+
+	printf("\nfrequency\tlog amplitude\tfiltered\n");
+	for (int s = 0; s < RESPONSE_STEPS; s++) {
+		double top = 0;
+		double topFiltered = 0;
+		for (int k = s * size / (2 * RESPONSE_STEPS);
+		     k <= (s + 1) * size / (2 * RESPONSE_STEPS); k++) {
+			double f = (double)k / size;
+			double amplitude = 2 * std::abs(data[k]) / n;
+			top = fmax(top, amplitude);
+			topFiltered = fmax(topFiltered, amplitude * std::abs(response(h, f)));
+		}
+		printf("%.3f-%.3f\t%10.4f\t%10.4f\n", 0.5 * s / RESPONSE_STEPS,
+		       0.5 * (s + 1) / RESPONSE_STEPS, top, topFiltered);
+	}
+}
+
+/**************************************
+ * Definition: Runs the filter over a log column with FIRFilter and
+ *             reports the measured lag and smoothing
+ *
+ * Parameters: .ffc file, log values, number of taps, and seconds
+ *             per sample
+ **************************************/
+void reportLog(std::string ffcName, std::vector<float> *raw, int taps, float secondsPerSample) {
+	int n = raw->size();
+	if (n <= 2 * taps) {
+		printf("\nlog is too short to evaluate on\n");
+		return;
+	}
+
+	FIRFilter filter(ffcName);
+	filter.seed((*raw)[0]);
+	std::vector<float> filtered(n);
+	filter.filter(&(*raw)[0], &filtered[0], n);
+
+	// the lag is the shift that best lines the output up with the input
+	int bestLag = 0;
+	double bestError = -1;
+	for (int lag = 0; lag <= taps; lag++) {
+		double error = 0;
+		for (int i = taps + lag; i < n; i++) {
+			double d = filtered[i] - (*raw)[i - lag];
+			error += d * d;
+		}
+		error /= n - taps - lag;
+		if (bestError < 0 || error < bestError) {
+			bestError = error;
+			bestLag = lag;
+		}
+	}
+
+	// how much sample to sample jitter is left
+	double rawJitter = 0;
+	double filteredJitter = 0;
+	for (int i = taps + 1; i < n; i++) {
+		rawJitter += pow((*raw)[i] - (*raw)[i - 1], 2);
+		filteredJitter += pow(filtered[i] - filtered[i - 1], 2);
+	}
+
+	printf("\non %d logged samples:\n", n);
+	printf("measured lag: %d samples (%.3f s), rms error after lining up %.3f\n",
+	       bestLag, bestLag * secondsPerSample, sqrt(bestError));
+	printf("jitter left: %.1f%% of the raw sample to sample change\n",
+	       rawJitter > 0 ? 100 * sqrt(filteredJitter / rawJitter) : 0);
+}
+
+int main(int argc, char *argv[]) {
+	std::string method("sinc");
+	int taps = DEFAULT_TAPS;
+	float cutoff = DEFAULT_CUTOFF;
+	float transition = DEFAULT_TRANSITION;
+	float delay = -1;
+	std::string outName;
+	std::string existing;
+	std::string logName;
+	int column = 0;
+	float secondsPerSample = DEFAULT_SECONDS_PER_SAMPLE;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:n:c:w:d:o:e:l:k:t:h")) != -1) {
+		switch (opt) {
+		case 'm': method = optarg; break;
+		case 'n': taps = atoi(optarg); break;
+		case 'c': cutoff = atof(optarg); break;
+		case 'w': transition = atof(optarg); break;
+		case 'd': delay = atof(optarg); break;
+		case 'o': outName = optarg; break;
+		case 'e': existing = optarg; break;
+		case 'l': logName = optarg; break;
+		case 'k': column = atoi(optarg); break;
+		case 't': secondsPerSample = atof(optarg); break;
+		case 'h':
+		default: usage(argv[0]);
+		}
+	}
+
+	std::vector<float> raw;
+	if (!logName.empty()) {
+		readColumn(logName, column, &raw);
+	}
+
+	std::vector<double> h;
+	std::string ffcName;
+	if (!existing.empty()) {
+		// the .ffc holds the taps in FIRFilter's order
+		std::vector<float> coefficients;
+		readColumn(existing, 0, &coefficients);
+		taps = coefficients.size();
+		if (taps == 0) {
+			printf("ERROR: no taps in %s\n", existing.c_str());
+			exit(-2);
+		}
+		h.resize(taps);
+		h[0] = coefficients[0];
+		for (int i = 1; i < taps; i++) {
+			h[taps - i] = coefficients[i];
+		}
+		ffcName = existing;
+		printf("%s: %d taps\n", existing.c_str(), taps);
+	}
+	else {
+		if (taps < 1 || cutoff <= 0 || cutoff >= 0.5 || outName.empty()) {
+			usage(argv[0]);
+		}
+		h.resize(taps);
+		if (method == "ls") {
+			if (delay < 0) {
+				delay = (taps - 1) / 2.0;
+			}
+			designLeastSquares(taps, cutoff, transition, delay, &h);
+		}
+		else {
+			designSinc(taps, cutoff, &h);
+		}
+
+		ffcName = outName + ".ffc";
+		FILE *ffc = fopen(ffcName.c_str(), "w");
+		FILE *ffs = fopen((outName + ".ffs").c_str(), "w");
+		if (ffc == NULL || ffs == NULL) {
+			printf("ERROR: could not write %s.ffc/.ffs\n", outName.c_str());
+			exit(-2);
+		}
+		// first tap for the newest sample, then oldest to second newest
+		fprintf(ffc, "%f\n", h[0]);
+		for (int i = 1; i < taps; i++) {
+			fprintf(ffc, "%f\n", h[taps - i]);
+		}
+		// seed with the start of the log if there is one
+		for (int i = 0; i < taps; i++) {
+			fprintf(ffs, "%g\n", i < (int)raw.size() ? raw[i] : 0.0);
+		}
+		fclose(ffc);
+		fclose(ffs);
+		printf("wrote %s.ffc and %s.ffs: %s, %d taps, cutoff %.3f\n",
+		       outName.c_str(), outName.c_str(), method.c_str(), taps, cutoff);
+	}
+
+	printf("\nimpulse response (newest sample first):\n");
+	for (int k = 0; k < taps; k++) {
+		printf("%f\n", h[k]);
+	}
+
+	reportResponse(&h, secondsPerSample);
+	if (!raw.empty()) {
+		reportSpectrum(&h, &raw);
+		reportLog(ffcName, &raw, taps, secondsPerSample);
+	}
+	return 0;
+}
@@ -1,13 +1,15 @@
 // Note: This file purposely does not abide by the style guidelines
-#include "fakerobotinterface.h"
+#include "fake_robot_interface.h"
 #include <robot_if++.h>
 #include <fstream>
+#include <sstream>
+#include <cstdlib>
 
 #define DEFAULT_ROOM 2
 
 FakeRobotInterface::FakeRobotInterface(std::string address, int id) {
-    _weSamples = _getWESamples();
-    _nsSamples = _getNSSamples();
+    _loadWESamples();
+    _loadNSSamples();
     _curSample = 0;
 }
 
@@ -18,8 +20,8 @@ void FakeRobotInterface::reset() {
 int FakeRobotInterface::update(void) {
     // move to the next sample point
     _curSample++;
-    if (_curSample > _weSamples.size()-1 ||
-        _curSample > _nsSamples.size()-1) {
+    if (_curSample >= (int)_weLeft.size() ||
+        _curSample >= (int)_nsX.size()) {
         return RI_RESP_FAILURE;
     }
     return RI_RESP_SUCCESS;
@@ -33,23 +35,13 @@ int FakeRobotInterface::Move(int movement, int speed) {
 }
 
 int FakeRobotInterface::getWheelEncoder(int wheel) {
-    std::string sample = _weSamples[_curSample];
-    std::stringstream sampleStream(sample);
-    std::string point;
-    // let control drop through to call right
-    // amount of getlines for each value
     switch (wheel) {
     case RI_WHEEL_REAR:
-        std::getline(sampleStream, point, ',');
+        return _weRear[_curSample];
     case RI_WHEEL_RIGHT:
-        std::getline(sampleStream, point, ',');
-    case RI_WHEEL_LEFT:
-        std::getline(sampleStream, point, ',');
-        break;
-    default:
-        std::getline(sampleStream, point, ',');
+        return _weRight[_curSample];
     }
-    return atoi(point.c_str());
+    return _weLeft[_curSample];
 }
 
 bool FakeRobotInterface::IR_Detected(void) {
@@ -57,53 +49,52 @@ bool FakeRobotInterface::IR_Detected(void) {
 }
 
 int FakeRobotInterface::X(void) {
-    std::string sample = _nsSamples[_curSample];
-    std::stringstream sampleStream(sample);
-    std::string point;
-    std::getline(sampleStream, point, ',');
-    return atoi(point.c_str());
+    return _nsX[_curSample];
 }
 
 int FakeRobotInterface::Y(void) {
-    std::string sample = _nsSamples[_curSample];
-    std::stringstream sampleStream(sample);
-    std::string point;
-    std::getline(sampleStream, point, ',');
-    std::getline(sampleStream, point, ',');
-    return atoi(point.c_str());
+    return _nsY[_curSample];
 }
 
 float FakeRobotInterface::Theta(void) {
-    std::string sample = _nsSamples[_curSample];
-    std::stringstream sampleStream(sample);
-    std::string point;
-    std::getline(sampleStream, point, ',');
-    std::getline(sampleStream, point, ',');
-    std::getline(sampleStream, point, ',');
-    return atof(point.c_str());
+    return _nsTheta[_curSample];
 }
 
 int FakeRobotInterface::RoomID(void) {
     return DEFAULT_ROOM;
 }
 
-std::vector<std::string> FakeRobotInterface::_getWESamples() {
+// we_samples.dat lines are left,right,rear
+void FakeRobotInterface::_loadWESamples() {
     std::ifstream f("we_samples.dat");
-    std::vector<std::string> samples;
     std::string line;
     while (std::getline(f, line)) {
-        samples.push_back(line);
+        std::vector<std::string> fields = _readFields(line);
+        _weLeft.push_back(atoi(fields[0].c_str()));
+        _weRight.push_back(atoi(fields[1].c_str()));
+        _weRear.push_back(atoi(fields[2].c_str()));
     }
-    return samples;
 }
-        
-std::vector<std::string> FakeRobotInterface::_getNSSamples() {
+
+// ns_samples.dat lines are x,y,theta
+void FakeRobotInterface::_loadNSSamples() {
     std::ifstream f("ns_samples.dat");
-    std::vector<std::string> samples;
     std::string line;
     while (std::getline(f, line)) {
-        samples.push_back(line);
+        std::vector<std::string> fields = _readFields(line);
+        _nsX.push_back(atoi(fields[0].c_str()));
+        _nsY.push_back(atoi(fields[1].c_str()));
+        _nsTheta.push_back(atof(fields[2].c_str()));
     }
-    return samples;
 }
 
+// splits a sample line on commas into its first three fields
+// (missing ones come back empty)
+std::vector<std::string> FakeRobotInterface::_readFields(std::string line) {
+    std::stringstream lineStream(line);
+    std::vector<std::string> fields(3);
+    for (int i = 0; i < 3; i++) {
+        std::getline(lineStream, fields[i], ',');
+    }
+    return fields;
+}
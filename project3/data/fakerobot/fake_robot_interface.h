@@ -20,11 +20,17 @@ public:
     int RoomID(void);
 private:
     int _curSample;
-    std::vector<std::string> _weSamples;
-    std::vector<std::string> _nsSamples;
+    // the samples, parsed once when loaded, one array per field
+    std::vector<int> _weLeft;
+    std::vector<int> _weRight;
+    std::vector<int> _weRear;
+    std::vector<int> _nsX;
+    std::vector<int> _nsY;
+    std::vector<float> _nsTheta;
 
-    std::vector<std::string> _getWESamples();
-    std::vector<std::string> _getNSSamples();
+    void _loadWESamples();
+    void _loadNSSamples();
+    static std::vector<std::string> _readFields(std::string line);
 };
 
 #endif
@@ -1,6 +1,6 @@
-#include "fakerobotinterface.h"
+#include "fake_robot_interface.h"
 #include "../../constants.h"
-#include "../../firfilter.h"
+#include "../../fir_filter.h"
 #include "../../utilities.h"
 
 #include <robot_if++.h>
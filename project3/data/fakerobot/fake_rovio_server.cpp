@@ -0,0 +1,577 @@
+/**
+ * fake_rovio_server.cpp
+ *
+ * @brief
+ *      Stands in for a rovio on the network, so the whole robot (robot_if
+ *      included) can be run and timed on one machine. It answers the
+ *      rovio's http api: the status report (north star), the MCU report
+ *      (wheel encoders, head, and IR), manual drive, and camera images,
+ *      and says OK to the camera settings. North star and wheel encoders
+ *      come either from a RovioModel driven by the drive commands it gets,
+ *      or replayed from ns_samples.dat and we_samples.dat (one row per
+ *      report, looping, with the room each north star row was taken in
+ *      as its fourth number or given with -R). Camera images are recorded jpegs, served in turn.
+ *      Every reply can be delayed and some dropped, to see how the robot
+ *      holds up on a bad network
+ *
+ *      Point robot_if at it by giving the machine the robot's address,
+ *      e.g. for bender: ip addr add 192.168.1.42/32 dev lo
+ *
+ *      usage: ./fake_rovio_server.out [-P port] [-n robot name]
+ *                 [-x x -y y -t theta] [-r] [-R room] [-i image directory]
+ *                 [-l latency ms] [-j jitter ms] [-p loss] [-s seed]
+ *                 [-N north star noise cm] [-W wheel noise]
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "rovio_model.h"
+#include "../../constants.h"
+#include "../../utilities.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define DEFAULT_PORT 80
+// the room replayed north star rows were taken in, if they don't say
+#define DEFAULT_REPLAY_ROOM 2
+#define REQUEST_SIZE 4096
+
+// the rovio http api's drive codes, where they differ from DRIVE_*
+#define API_HEAD_UP 11
+#define API_HEAD_DOWN 12
+#define API_HEAD_MIDDLE 13
+#define API_TURN_LEFT_20 17
+#define API_TURN_RIGHT_20 18
+
+// rev.cgi nav actions
+#define ACTION_REPORT 1
+#define ACTION_DRIVE 18
+#define ACTION_MCU_REPORT 20
+
+// MCU report bits: a wheel turning backward, and (in the status byte)
+// the IR seeing something
+#define MCU_BACKWARD 0x04
+#define MCU_IR_DETECTED 0x06
+// head positions and battery level as the MCU reports them
+#define MCU_HEAD_UP 204
+#define MCU_HEAD_MIDDLE 135
+#define MCU_HEAD_DOWN 65
+#define MCU_BATTERY 126
+
+struct Options {
+    int port;
+    int name;
+    float x;
+    float y;
+    float theta;
+    bool replay;
+    int room;
+    std::string images;
+    int latency;
+    int jitter;
+    float loss;
+    unsigned int seed;
+    float nsNoise;
+    float weNoise;
+};
+
+struct Stats {
+    int requests;
+    int dropped;
+    int reports;
+    int mcuReports;
+    int drives;
+    int images;
+    int other;
+};
+
+volatile bool running = true;
+
+void interrupt(int signal) {
+    running = false;
+}
+
+double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1000000000.0;
+}
+
+void usage() {
+    printf("usage: ./fake_rovio_server.out [-P port] [-n robot name]\n"
+           "           [-x x -y y -t theta] [-r] [-R room] [-i image directory]\n"
+           "           [-l latency ms] [-j jitter ms] [-p loss] [-s seed]\n"
+           "           [-N north star noise cm] [-W wheel noise]\n"
+           "  -P  port to listen on (default %d)\n"
+           "  -n  robot name or address, for its north star calibration\n"
+           "  -x, -y, -t  where the simulated robot starts (cm, radians)\n"
+           "  -r  replay ns_samples.dat and we_samples.dat instead\n"
+           "  -R  room the replayed north star rows without one were taken\n"
+           "      in (default %d)\n"
+           "  -i  serve the jpegs in this directory as camera images\n"
+           "  -l, -j  delay every reply this much, plus up to the jitter\n"
+           "  -p  fraction of requests to drop without replying\n"
+           "  -s  seed for the noise and drops\n"
+           "  -N, -W  north star noise (cm) and wheel tick noise (fraction)\n",
+           DEFAULT_PORT, DEFAULT_REPLAY_ROOM);
+}
+
+/**************************************
+ * Definition: Reads a samples file of comma separated numbers, one
+ *             sample of three per line, optionally followed by the
+ *             room it was taken in
+ *
+ * Parameters: the file's name, an array to append the numbers to, an
+ *             array (or NULL) to append each sample's room to, and the
+ *             room for samples that don't have one
+ *
+ * Returns:    the number of samples read
+ **************************************/
+int readSamples(const char *fileName, std::vector<float> *samples,
+                std::vector<int> *rooms, int defaultRoom) {
+    std::ifstream f(fileName);
+    std::string line;
+    int count = 0;
+    while (std::getline(f, line)) {
+        float a, b, c;
+        int room;
+        int read = sscanf(line.c_str(), "%f,%f,%f,%d", &a, &b, &c, &room);
+        if (read >= 3) {
+            samples->push_back(a);
+            samples->push_back(b);
+            samples->push_back(c);
+            if (rooms != NULL) {
+                rooms->push_back((read == 4) ? room : defaultRoom);
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+/**************************************
+ * Definition: Lists the jpegs in a directory, in name order
+ *
+ * Parameters: the directory and a list to fill with paths
+ **************************************/
+void listImages(std::string directory, std::vector<std::string> *images) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name(entry->d_name);
+        if (name.size() > 4 &&
+            (name.compare(name.size() - 4, 4, ".jpg") == 0 ||
+             name.compare(name.size() - 4, 4, ".JPG") == 0)) {
+            images->push_back(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(images->begin(), images->end());
+}
+
+/**************************************
+ * Definition: Finds a number in a request's query string
+ *
+ * Parameters: the request path, the parameter's name, and what
+ *             to return without it
+ *
+ * Returns:    the parameter's value
+ **************************************/
+int queryInt(const std::string &path, const char *name, int missing) {
+    size_t query = path.find('?');
+    if (query == std::string::npos) {
+        return missing;
+    }
+    std::string key = std::string(name) + "=";
+    size_t at = query;
+    while ((at = path.find(key, at + 1)) != std::string::npos) {
+        char before = path[at - 1];
+        if (before == '?' || before == '&') {
+            return atoi(path.c_str() + at + key.size());
+        }
+    }
+    return missing;
+}
+
+/**************************************
+ * Definition: Turns a drive code from the http api into a DRIVE_*
+ *
+ * Parameters: the api's drive code
+ *
+ * Returns:    the DRIVE_* code, or -1 if it isn't a move we know
+ **************************************/
+int fromApi(int drive) {
+    if (drive >= DRIVE_STOP && drive <= DRIVE_BACK_RIGHT) {
+        return drive;
+    }
+    switch (drive) {
+    case API_HEAD_UP:
+        return DRIVE_HEAD_UP;
+    case API_HEAD_DOWN:
+        return DRIVE_HEAD_DOWN;
+    case API_HEAD_MIDDLE:
+        return DRIVE_HEAD_MIDDLE;
+    case API_TURN_LEFT_20:
+        return DRIVE_TURN_LEFT_20;
+    case API_TURN_RIGHT_20:
+        return DRIVE_TURN_RIGHT_20;
+    }
+    return -1;
+}
+
+/**************************************
+ * Definition: Sends an http reply and closes the connection
+ *
+ * Parameters: the socket, the status line, content type, and body
+ **************************************/
+void reply(int client, const char *status, const char *type,
+           const char *body, size_t length) {
+    char header[256];
+    int headerLength = sprintf(header,
+                               "HTTP/1.1 %s\r\n"
+                               "Content-Type: %s\r\n"
+                               "Content-Length: %lu\r\n"
+                               "Connection: close\r\n\r\n",
+                               status, type, (unsigned long) length);
+    send(client, header, headerLength, MSG_NOSIGNAL);
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t n = send(client, body + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+}
+
+void replyText(int client, const std::string &body) {
+    reply(client, "200 OK", "text/plain", body.c_str(), body.size());
+}
+
+/**************************************
+ * Definition: Reads a request up to the end of its headers
+ *
+ * Parameters: the socket and a string to put the path in
+ *
+ * Returns:    false if it wasn't a request we can read
+ **************************************/
+bool readRequest(int client, std::string *path) {
+    char buffer[REQUEST_SIZE];
+    size_t length = 0;
+    while (length < sizeof(buffer) - 1) {
+        ssize_t n = recv(client, buffer + length, sizeof(buffer) - 1 - length, 0);
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+        buffer[length] = '\0';
+        if (strstr(buffer, "\r\n\r\n") != NULL || strstr(buffer, "\n\n") != NULL) {
+            break;
+        }
+    }
+    buffer[length] = '\0';
+
+    char method[16];
+    char target[REQUEST_SIZE];
+    if (sscanf(buffer, "%15s %4095s", method, target) != 2) {
+        return false;
+    }
+    *path = target;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    options.port = DEFAULT_PORT;
+    options.name = 1; // bender
+    options.x = COL_OFFSET[0];
+    options.y = COL_OFFSET[1];
+    options.theta = 0;
+    options.replay = false;
+    options.room = DEFAULT_REPLAY_ROOM;
+    options.latency = 0;
+    options.jitter = 0;
+    options.loss = 0;
+    options.seed = 1;
+    options.nsNoise = 0;
+    options.weNoise = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "P:n:x:y:t:rR:i:l:j:p:s:N:W:h")) != -1) {
+        switch (opt) {
+        case 'P':
+            options.port = atoi(optarg);
+            break;
+        case 'n':
+            options.name = Util::nameFrom(optarg);
+            break;
+        case 'x':
+            options.x = atof(optarg);
+            break;
+        case 'y':
+            options.y = atof(optarg);
+            break;
+        case 't':
+            options.theta = atof(optarg);
+            break;
+        case 'r':
+            options.replay = true;
+            break;
+        case 'R':
+            options.room = atoi(optarg);
+            break;
+        case 'i':
+            options.images = optarg;
+            break;
+        case 'l':
+            options.latency = atoi(optarg);
+            break;
+        case 'j':
+            options.jitter = atoi(optarg);
+            break;
+        case 'p':
+            options.loss = atof(optarg);
+            break;
+        case 's':
+            options.seed = (unsigned int) atoi(optarg);
+            break;
+        case 'N':
+            options.nsNoise = atof(optarg);
+            break;
+        case 'W':
+            options.weNoise = atof(optarg);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    RovioModel model(options.name, options.x, options.y, options.theta, options.seed);
+    model.setNoise(options.nsNoise, options.nsNoise / 100.0, options.weNoise, 0);
+
+    std::vector<float> nsSamples;
+    std::vector<float> weSamples;
+    std::vector<int> nsRooms;
+    int nsCount = 0;
+    int weCount = 0;
+    if (options.replay) {
+        nsCount = readSamples("ns_samples.dat", &nsSamples, &nsRooms,
+                              options.room);
+        weCount = readSamples("we_samples.dat", &weSamples, NULL, 0);
+        if (nsCount == 0 || weCount == 0) {
+            printf("no samples to replay in ns_samples.dat/we_samples.dat\n");
+            return 1;
+        }
+        printf("replaying %d north star and %d wheel encoder samples\n",
+               nsCount, weCount);
+    }
+
+    std::vector<std::string> images;
+    if (!options.images.empty()) {
+        listImages(options.images, &images);
+        printf("serving %lu camera images\n", (unsigned long) images.size());
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(options.port);
+    if (bind(server, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+        listen(server, 16) < 0) {
+        perror("couldn't listen");
+        return 1;
+    }
+
+    // stop accepting on ctrl-c (without restarting accept) to print stats
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = interrupt;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("fake rovio listening on port %d\n", options.port);
+
+    Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    int nsSample = 0;
+    int weSample = 0;
+    int image = 0;
+    double lastStep = now();
+
+    while (running) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+
+        std::string path;
+        if (!readRequest(client, &path)) {
+            close(client);
+            continue;
+        }
+        stats.requests++;
+
+        // the robot moves on in real time between requests
+        double time = now();
+        model.step(time - lastStep);
+        lastStep = time;
+
+        int delay = options.latency;
+        if (options.jitter > 0) {
+            delay += (int)(model.random() * options.jitter);
+        }
+        if (delay > 0) {
+            usleep(delay * 1000);
+        }
+        if (model.random() < options.loss) {
+            stats.dropped++;
+            close(client);
+            continue;
+        }
+
+        char body[512];
+        if (path.find("/rev.cgi") == 0) {
+            int action = queryInt(path, "action", -1);
+            if (action == ACTION_REPORT) {
+                int x, y, room, strength;
+                float theta;
+                if (options.replay) {
+                    x = (int) nsSamples[nsSample * 3];
+                    y = (int) nsSamples[nsSample * 3 + 1];
+                    theta = nsSamples[nsSample * 3 + 2];
+                    room = nsRooms[nsSample];
+                    strength = 10000;
+                    nsSample = (nsSample + 1) % nsCount;
+                }
+                else {
+                    model.readNorthStar(&x, &y, &theta, &room, &strength);
+                }
+                sprintf(body, "Cmd = nav\nresponses = 0|x=%d|y=%d|theta=%.3f"
+                        "|room=%d|ss=%d|beacon=0|beacon_x=0|next_room=-1"
+                        "|next_room_ss=0|state=0|ui_status=0|resistance=0"
+                        "|sm=15|pp=0|flags=0005|brightness=6|resolution=3"
+                        "|video_compression=1|frame_rate=20|privilege=0"
+                        "|user_check=1|speaker_volume=15|mic_volume=17"
+                        "|wifi_ss=233|show_time=0|ddns_state=0|email_state=0"
+                        "|battery=%d|charging=80|head_position=%d|ac_freq=2\n",
+                        x, y, theta, room, strength, MCU_BATTERY,
+                        MCU_HEAD_DOWN);
+                replyText(client, body);
+                stats.reports++;
+            }
+            else if (action == ACTION_MCU_REPORT) {
+                int ticks[3];
+                if (options.replay) {
+                    for (int w = 0; w < 3; w++) {
+                        ticks[w] = (int) weSamples[weSample * 3 + w];
+                    }
+                    weSample = (weSample + 1) % weCount;
+                }
+                else {
+                    model.takeWheelTicks(ticks);
+                }
+
+                int head = MCU_HEAD_DOWN;
+                if (model.getHeadPosition() == DRIVE_HEAD_UP) {
+                    head = MCU_HEAD_UP;
+                }
+                else if (model.getHeadPosition() == DRIVE_HEAD_MIDDLE) {
+                    head = MCU_HEAD_MIDDLE;
+                }
+
+                // replayed runs have no IR to report
+                int status = 0;
+                if (!options.replay && model.irDetected()) {
+                    status = MCU_IR_DETECTED;
+                }
+
+                // length, unused, then each wheel's direction and
+                // ticks (high byte first), unused, head, battery, status
+                int length = sprintf(body, "Cmd = nav\nresponses = 0E00");
+                for (int w = 0; w < 3; w++) {
+                    int count = abs(ticks[w]);
+                    if (count > 0xFFFF) {
+                        count = 0xFFFF;
+                    }
+                    length += sprintf(body + length, "%02X%04X",
+                                      ticks[w] < 0 ? MCU_BACKWARD : 0, count);
+                }
+                sprintf(body + length, "00%02X%02X%02X\n", head, MCU_BATTERY,
+                        status);
+                replyText(client, body);
+                stats.mcuReports++;
+            }
+            else if (action == ACTION_DRIVE) {
+                int drive = fromApi(queryInt(path, "drive", -1));
+                int speed = queryInt(path, "speed", 1);
+                if (drive >= 0 && !options.replay) {
+                    model.drive(drive, speed);
+                }
+                replyText(client, "Cmd = nav\nresponses = 0\n");
+                stats.drives++;
+            }
+            else {
+                replyText(client, "Cmd = nav\nresponses = 0\n");
+                stats.other++;
+            }
+        }
+        else if (path.find("/Jpeg/CamImg") == 0 && !images.empty()) {
+            std::ifstream f(images[image].c_str(), std::ios::binary);
+            std::string jpeg((std::istreambuf_iterator<char>(f)),
+                             std::istreambuf_iterator<char>());
+            reply(client, "200 OK", "image/jpeg", jpeg.data(), jpeg.size());
+            image = (image + 1) % images.size();
+            stats.images++;
+        }
+        else if (path.find("/Jpeg/CamImg") == 0) {
+            reply(client, "404 Not Found", "text/plain", "", 0);
+            stats.other++;
+        }
+        else {
+            // camera settings and anything else just succeed
+            replyText(client, "responses = 0\n");
+            stats.other++;
+        }
+        close(client);
+    }
+
+    close(server);
+    printf("\n%d requests (%d dropped): %d reports, %d MCU reports, "
+           "%d drives, %d images, %d other\n",
+           stats.requests, stats.dropped, stats.reports, stats.mcuReports,
+           stats.drives, stats.images, stats.other);
+    printf("robot ended at (%.1f, %.1f) facing %.3f\n",
+           model.getX(), model.getY(), model.getTheta());
+    return 0;
+}
@@ -0,0 +1,416 @@
+/**
+ * rovio_model.cpp
+ *
+ * @brief
+ *      A kinematic model of a rovio for testing without one. Drive
+ *      commands move it at the speeds measured in SPEED_FORWARD and
+ *      SPEED_TURN for as long as a real drive command lasts, and the
+ *      motion comes back out as omni wheel encoder ticks and north star
+ *      readings in the nearest room's coordinates (using the robot's
+ *      own calibration backwards). Noise on the speeds, ticks, and
+ *      readings all comes from one seeded generator, so a run can be
+ *      repeated exactly
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "rovio_model.h"
+#include "../../constants.h"
+
+#include <math.h>
+
+// how strong north star is right under a room's beacon, and how much
+// it drops off per cm away
+#define NS_STRENGTH_MAX 20000
+#define NS_STRENGTH_FALLOFF 40
+
+// SPEED_TURN's columns (DIR_LEFT and DIR_RIGHT in robot.h)
+#define TURN_LEFT_COLUMN 0
+#define TURN_RIGHT_COLUMN 1
+
+/**************************************
+ * Definition: Puts a rovio at rest somewhere on the field with no
+ *             noise (see setNoise)
+ *
+ * Parameters: the robot's name (for its north star calibration),
+ *             its global x and y (cm) and theta, and the seed for
+ *             its noise
+ **************************************/
+RovioModel::RovioModel(int name, float x, float y, float theta, unsigned int seed)
+: _x(x), _y(y), _theta(theta), _driveLeft(0), _headPosition(DRIVE_HEAD_DOWN),
+  _nsNoise(0), _nsThetaNoise(0), _weNoise(0), _slip(0), _seed(seed) {
+    for (int i = 0; i < 3; i++) {
+        _velocity[i] = 0;
+        _ticks[i] = 0;
+    }
+
+    _calibration = new NSCalibration(name);
+    for (int room = 0; room < NUM_ROOMS; room++) {
+        _transforms[room].set(room, _calibration->getRoom(room));
+    }
+}
+
+RovioModel::~RovioModel() {
+    delete _calibration;
+}
+
+/**************************************
+ * Definition: Sets how noisy the rovio is
+ *
+ * Parameters: the north star x and y noise (cm) and theta noise
+ *             (radians), the wheel tick noise (a fraction of the
+ *             ticks), and how far off each drive command's speed
+ *             is (a fraction of the speed)
+ **************************************/
+void RovioModel::setNoise(float nsNoise, float nsThetaNoise, float weNoise, float slip) {
+    _nsNoise = nsNoise;
+    _nsThetaNoise = nsThetaNoise;
+    _weNoise = weNoise;
+    _slip = slip;
+}
+
+/**************************************
+ * Definition: Replaces the north star calibration with a robot's
+ *             entries from a calibration file (like NorthStar does)
+ *
+ * Parameters: the calibration file's name
+ **************************************/
+void RovioModel::loadCalibration(std::string fileName) {
+    _calibration->load(fileName);
+    for (int room = 0; room < NUM_ROOMS; room++) {
+        _transforms[room].set(room, _calibration->getRoom(room));
+    }
+}
+
+/**************************************
+ * Definition: Moves the rovio somewhere without rolling its wheels
+ *             (like being stopped by a wall)
+ *
+ * Parameters: its new global x and y (cm)
+ **************************************/
+void RovioModel::place(float x, float y) {
+    _x = x;
+    _y = y;
+}
+
+/**************************************
+ * Definition: Starts carrying out a drive command, replacing the
+ *             one going
+ *
+ * Parameters: the drive code (DRIVE_*) and speed (1 fastest to 10)
+ **************************************/
+void RovioModel::drive(int drive, int speed) {
+    if (speed < 1) {
+        speed = 1;
+    }
+    else if (speed >= NUM_SPEEDS) {
+        speed = NUM_SPEEDS - 1;
+    }
+
+    float forward = SPEED_FORWARD[speed];
+    float diagonal = forward * sin(DEGREE_45);
+    float strafe = 0;
+    float move = 0;
+    float turn = 0;
+    float time = DRIVE_COMMAND_TIME;
+
+    switch (drive) {
+    case DRIVE_FORWARD:
+        move = forward;
+        break;
+    case DRIVE_BACKWARD:
+        move = -forward;
+        break;
+    case DRIVE_LEFT:
+        strafe = -forward;
+        break;
+    case DRIVE_RIGHT:
+        strafe = forward;
+        break;
+    case DRIVE_TURN_LEFT:
+        turn = SPEED_TURN[speed][TURN_LEFT_COLUMN];
+        break;
+    case DRIVE_TURN_RIGHT:
+        turn = SPEED_TURN[speed][TURN_RIGHT_COLUMN];
+        break;
+    case DRIVE_FWD_LEFT:
+        strafe = -diagonal;
+        move = diagonal;
+        break;
+    case DRIVE_FWD_RIGHT:
+        strafe = diagonal;
+        move = diagonal;
+        break;
+    case DRIVE_BACK_LEFT:
+        strafe = -diagonal;
+        move = -diagonal;
+        break;
+    case DRIVE_BACK_RIGHT:
+        strafe = diagonal;
+        move = -diagonal;
+        break;
+    case DRIVE_TURN_LEFT_20:
+        turn = SPEED_TURN[speed][TURN_LEFT_COLUMN];
+        time = DEGREE_20 / fabs(turn);
+        break;
+    case DRIVE_TURN_RIGHT_20:
+        turn = SPEED_TURN[speed][TURN_RIGHT_COLUMN];
+        time = DEGREE_20 / fabs(turn);
+        break;
+    case DRIVE_HEAD_UP:
+    case DRIVE_HEAD_DOWN:
+    case DRIVE_HEAD_MIDDLE:
+        _headPosition = drive;
+        return;
+    default:
+        time = 0;
+    }
+
+    float slip = 1 + gaussian(_slip);
+    _velocity[0] = strafe * slip;
+    _velocity[1] = move * slip;
+    _velocity[2] = turn * slip;
+    _driveLeft = time;
+}
+
+/**************************************
+ * Definition: Moves the rovio along for some time, rolling its
+ *             wheels as it goes
+ *
+ * Parameters: the seconds to move for
+ **************************************/
+void RovioModel::step(float dt) {
+    // cm each wheel rolls per cm of {strafe right, forward} and
+    // radian of turn (the same as WheelEncoders' kinematics)
+    float radius = ROBOT_DIAMETER / 2.0;
+    float wheels[3][3] = {
+        {(float) cos(DEGREE_60), (float) sin(DEGREE_60), -radius},
+        {(float) -cos(DEGREE_60), (float) sin(DEGREE_60), radius},
+        {-1, 0, -radius}
+    };
+
+    while (dt > 0 && _driveLeft > 0) {
+        float h = fmin(fmin(dt, _driveLeft), MODEL_STEP);
+        float strafe = _velocity[0] * h;
+        float forward = _velocity[1] * h;
+        float turn = _velocity[2] * h;
+
+        // forward is along theta, and strafing is to its right
+        _x += forward * cos(_theta) + strafe * sin(_theta);
+        _y += forward * sin(_theta) - strafe * cos(_theta);
+        _theta += turn;
+        while (_theta > PI) {
+            _theta -= 2 * PI;
+        }
+        while (_theta <= -PI) {
+            _theta += 2 * PI;
+        }
+
+        for (int w = 0; w < 3; w++) {
+            _ticks[w] += WE_SCALE * (wheels[w][0] * strafe +
+                                     wheels[w][1] * forward +
+                                     wheels[w][2] * turn);
+        }
+
+        dt -= h;
+        _driveLeft -= h;
+    }
+}
+
+/**************************************
+ * Definition: Reads the wheel encoders: the whole ticks each wheel
+ *             has rolled since the last read, with noise
+ *
+ * Parameters: an array to put the left, right, and rear ticks in
+ **************************************/
+void RovioModel::takeWheelTicks(int *ticks) {
+    for (int w = 0; w < 3; w++) {
+        float noisy = _ticks[w] * (1 + gaussian(_weNoise));
+        ticks[w] = (int) noisy;
+        _ticks[w] -= ticks[w];
+    }
+}
+
+/**************************************
+ * Definition: Reads north star from the nearest room's beacon,
+ *             with noise
+ *
+ * Parameters: pointers to put the x and y (ticks), theta, room
+ *             (2-5, like RoomID), and signal strength in
+ **************************************/
+void RovioModel::readNorthStar(int *x, int *y, float *theta, int *room, int *strength) {
+    int nearest = _nearestRoom();
+    RoomCalibration *calibration = _calibration->getRoom(nearest);
+
+    float nsX = _x + gaussian(_nsNoise);
+    float nsY = _y + gaussian(_nsNoise);
+    _transforms[nearest].toRoom(&nsX, &nsY);
+    if (nearest == ROOM_2) {
+        _unskew(&nsX, &nsY);
+    }
+    *x = (int) nsX;
+    *y = (int) nsY;
+
+    float nsTheta = _theta + calibration->rotation + calibration->thetaShift +
+                    gaussian(_nsThetaNoise);
+    while (nsTheta > PI) {
+        nsTheta -= 2 * PI;
+    }
+    while (nsTheta <= -PI) {
+        nsTheta += 2 * PI;
+    }
+    *theta = nsTheta;
+
+    *room = nearest + 2;
+
+    float dx = _x - (COL_OFFSET[0] + calibration->originX);
+    float dy = _y - (COL_OFFSET[1] + calibration->originY);
+    int signal = NS_STRENGTH_MAX - (int)(NS_STRENGTH_FALLOFF * sqrt(dx * dx + dy * dy));
+    *strength = (signal > 0) ? signal : 0;
+}
+
+/**************************************
+ * Definition: Checks for a wall just in front of the rovio. The model
+ *             doesn't know where the posts are, so only the field's
+ *             outer walls count
+ *
+ * Returns:    true if the field ends within SIM_IR_RANGE
+ **************************************/
+bool RovioModel::irDetected() {
+    float reach = ROBOT_DIAMETER / 2.0 + SIM_IR_RANGE;
+    float x = _x + reach * cos(_theta);
+    float y = _y + reach * sin(_theta);
+    return x > SIM_FIELD_X0 + SIM_CELL_SIZE / 2 ||
+           x < SIM_FIELD_X0 - (SIM_MAP_WIDTH - 0.5) * SIM_CELL_SIZE ||
+           y < SIM_FIELD_Y0 - SIM_CELL_SIZE / 2 ||
+           y > SIM_FIELD_Y0 + (SIM_MAP_HEIGHT - 0.5) * SIM_CELL_SIZE;
+}
+
+/**************************************
+ * Definition: Returns where the head is
+ *
+ * Returns:    DRIVE_HEAD_UP, DRIVE_HEAD_DOWN, or DRIVE_HEAD_MIDDLE
+ **************************************/
+int RovioModel::getHeadPosition() {
+    return _headPosition;
+}
+
+/**************************************
+ * Definition: Returns where the rovio really is
+ *
+ * Returns:    its global x (cm)
+ **************************************/
+float RovioModel::getX() {
+    return _x;
+}
+
+/**************************************
+ * Definition: Returns where the rovio really is
+ *
+ * Returns:    its global y (cm)
+ **************************************/
+float RovioModel::getY() {
+    return _y;
+}
+
+/**************************************
+ * Definition: Returns which way the rovio is really facing
+ *
+ * Returns:    its global theta (radians)
+ **************************************/
+float RovioModel::getTheta() {
+    return _theta;
+}
+
+/**************************************
+ * Definition: Draws from the seeded generator (a linear
+ *             congruential one, so runs repeat on any machine)
+ *
+ * Returns:    a float in [0, 1)
+ **************************************/
+float RovioModel::random() {
+    _seed = _seed * 1664525u + 1013904223u;
+    return (_seed >> 8) / 16777216.0;
+}
+
+/**************************************
+ * Definition: Draws normally distributed noise (Box-Muller)
+ *
+ * Parameters: the standard deviation
+ *
+ * Returns:    the noise (0 if sigma is)
+ **************************************/
+float RovioModel::gaussian(float sigma) {
+    if (sigma <= 0) {
+        return 0;
+    }
+    float u = random();
+    float v = random();
+    return sigma * sqrt(-2 * log(1 - u)) * cos(2 * PI * v);
+}
+
+int RovioModel::_nearestRoom() {
+    int nearest = 0;
+    float nearestDistance = 0;
+    for (int room = 0; room < NUM_ROOMS; room++) {
+        RoomCalibration *calibration = _calibration->getRoom(room);
+        float dx = _x - (COL_OFFSET[0] + calibration->originX);
+        float dy = _y - (COL_OFFSET[1] + calibration->originY);
+        float distance = dx * dx + dy * dy;
+        if (room == 0 || distance < nearestDistance) {
+            nearest = room;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+/**************************************
+ * Definition: Undoes room 2's skew (see RoomTransform::toGlobal),
+ *             finding the reading the skew turns into the given
+ *             x and y. The skew's angles depend on the reading, so
+ *             it's solved with a few steps of Newton's method
+ *
+ * Parameters: pointers to the skewed x and y, which get the
+ *             reading
+ **************************************/
+void RovioModel::_unskew(float *x, float *y) {
+    double skewX = *x;
+    double skewY = *y;
+    double rawX = skewX;
+    double rawY = skewY;
+    for (int i = 0; i < 10; i++) {
+        double xAngle = NS_ROOM_2_SKEW_SLOPE * rawX + NS_ROOM_2_SKEW_OFFSET;
+        double yAngle = NS_ROOM_2_SKEW_SLOPE * rawY + NS_ROOM_2_SKEW_OFFSET;
+        double cx = cos(xAngle);
+        double sx = sin(xAngle);
+        double cy = cos(yAngle);
+        double sy = sin(yAngle);
+
+        // how far the skewed guess is off, and its jacobian
+        double fx = rawX * cx - rawY * sx - skewX;
+        double fy = rawX * sy + rawY * cy - skewY;
+        double a = cx - NS_ROOM_2_SKEW_SLOPE * (rawX * sx + rawY * cx);
+        double b = -sx;
+        double c = sy;
+        double d = cy + NS_ROOM_2_SKEW_SLOPE * (rawX * cy - rawY * sy);
+        double det = a * d - b * c;
+        if (fabs(det) < 1e-9) {
+            break;
+        }
+
+        double stepX = (d * fx - b * fy) / det;
+        double stepY = (a * fy - c * fx) / det;
+        rawX -= stepX;
+        rawY -= stepY;
+        if (fabs(stepX) < 1e-3 && fabs(stepY) < 1e-3) {
+            break;
+        }
+    }
+    *x = rawX;
+    *y = rawY;
+}
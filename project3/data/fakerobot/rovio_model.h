@@ -0,0 +1,112 @@
+/**
+ * rovio_model.h
+ *
+ * @brief
+ *      A kinematic model of a rovio for testing without one. Drive
+ *      commands move it at the speeds measured in SPEED_FORWARD and
+ *      SPEED_TURN for as long as a real drive command lasts, and the
+ *      motion comes back out as omni wheel encoder ticks and north star
+ *      readings in the nearest room's coordinates (using the robot's
+ *      own calibration backwards, room 2's skew included). The IR sees
+ *      the field's outer walls. Noise on the speeds, ticks, and readings
+ *      all comes from one seeded generator, so a run can be repeated
+ *      exactly
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_ROVIOMODEL_H
+#define CS1567_ROVIOMODEL_H
+
+#include "../../room_transform.h"
+#include "../../ns_calibration.h"
+
+#include <string>
+
+// what a drive command does (the same order as robot_if's RI_* moves,
+// which aren't the numbers the rovio's http api uses for all of them)
+#define DRIVE_STOP 0
+#define DRIVE_FORWARD 1
+#define DRIVE_BACKWARD 2
+#define DRIVE_LEFT 3
+#define DRIVE_RIGHT 4
+#define DRIVE_TURN_LEFT 5
+#define DRIVE_TURN_RIGHT 6
+#define DRIVE_FWD_LEFT 7
+#define DRIVE_FWD_RIGHT 8
+#define DRIVE_BACK_LEFT 9
+#define DRIVE_BACK_RIGHT 10
+#define DRIVE_TURN_LEFT_20 11
+#define DRIVE_TURN_RIGHT_20 12
+#define DRIVE_HEAD_UP 13
+#define DRIVE_HEAD_DOWN 14
+#define DRIVE_HEAD_MIDDLE 15
+
+// the field, in cells (the same as MAP_WIDTH and MAP_HEIGHT in map.h)
+// and cm (CELL_SIZE in robot.h)
+#define SIM_MAP_WIDTH 7
+#define SIM_MAP_HEIGHT 5
+#define SIM_CELL_SIZE 65.0
+// where the center of cell (0, 0) is globally. cells further along in
+// x are to the west (-x globally), and further along in y to the north
+#define SIM_FIELD_X0 422.5
+#define SIM_FIELD_Y0 32.5
+
+// the IR sees anything closer than this (cm) in front of the robot
+#define SIM_IR_RANGE 20.0
+
+// how long (seconds) the rovio keeps carrying out one drive command
+#define DRIVE_COMMAND_TIME 0.5
+// how finely (seconds) motion is integrated
+#define MODEL_STEP 0.01
+
+class RovioModel {
+public:
+    RovioModel(int name, float x, float y, float theta, unsigned int seed);
+    ~RovioModel();
+    void setNoise(float nsNoise, float nsThetaNoise, float weNoise, float slip);
+    void loadCalibration(std::string fileName);
+    void place(float x, float y);
+    void drive(int drive, int speed);
+    void step(float dt);
+    void takeWheelTicks(int *ticks);
+    void readNorthStar(int *x, int *y, float *theta, int *room, int *strength);
+    bool irDetected();
+    int getHeadPosition();
+    float getX();
+    float getY();
+    float getTheta();
+    float random();
+    float gaussian(float sigma);
+private:
+    float _x;
+    float _y;
+    float _theta;
+
+    // what the current drive command does: strafe right and forward
+    // (cm/s) and turn counter-clockwise (radians/s), and for how long
+    float _velocity[3];
+    float _driveLeft;
+    int _headPosition;
+
+    // ticks rolled since the last read, not yet whole
+    float _ticks[3];
+
+    float _nsNoise;
+    float _nsThetaNoise;
+    float _weNoise;
+    float _slip;
+    unsigned int _seed;
+
+    NSCalibration *_calibration;
+    RoomTransform _transforms[NUM_ROOMS];
+
+    int _nearestRoom();
+    static void _unskew(float *x, float *y);
+};
+
+#endif
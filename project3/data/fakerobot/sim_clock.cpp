@@ -0,0 +1,41 @@
+/**
+ * sim_clock.cpp
+ *
+ * @brief
+ *      The simulator's clock. Simulated time only moves when the robot
+ *      waits (a control loop period, or a pause), so the simulated world
+ *      runs as fast as the code does and comes out the same every time
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "sim_clock.h"
+
+namespace SimClock {
+    // seconds since the simulation started
+    static double simulatedTime = 0;
+
+    /**************************************
+     * Definition: Returns the simulated time
+     *
+     * Returns:    seconds since the simulation started
+     **************************************/
+    double now() {
+        return simulatedTime;
+    }
+
+    /**************************************
+     * Definition: Moves simulated time on
+     *
+     * Parameters: the seconds to move it by
+     **************************************/
+    void advance(double seconds) {
+        if (seconds > 0) {
+            simulatedTime += seconds;
+        }
+    }
+};
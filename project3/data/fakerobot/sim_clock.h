@@ -0,0 +1,24 @@
+/**
+ * sim_clock.h
+ *
+ * @brief
+ *      The simulator's clock. Simulated time only moves when the robot
+ *      waits (a control loop period, or a pause), so the simulated world
+ *      runs as fast as the code does and comes out the same every time
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_SIMCLOCK_H
+#define CS1567_SIMCLOCK_H
+
+namespace SimClock {
+    double now();
+    void advance(double seconds);
+};
+
+#endif
@@ -0,0 +1,563 @@
+/**
+ * sim_robot_interface.cpp
+ *
+ * @brief
+ *      Simulates a rovio and the game field behind the same calls the
+ *      robot makes on robot_if's RobotInterface, so whole games can be
+ *      run without a robot (building with USE_SIMULATOR swaps it in, see
+ *      robot_interface.h). The rovio is a RovioModel, moved along on the
+ *      simulator's clock, and kept out of the posts and the field's
+ *      walls. The game server's map, reserving, and occupying are played
+ *      out on a field of posts and pellets, with the other robot sitting
+ *      at its start. Camera images are drawn from the robot's pose, with
+ *      a pink tag on every wall in sight. Everything random comes from
+ *      one seed (the SIM_SEED environment variable), so a game can be
+ *      repeated exactly
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "sim_robot_interface.h"
+#include "sim_clock.h"
+#include "../../constants.h"
+#include "../../utilities.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// how finely (cm) to look along a line of sight for walls
+#define SIGHT_STEP 5.0
+
+// the colors drawn: the walls, the floor, and the tags (BGR)
+const unsigned char WALL_COLOR[3] = {170, 170, 170};
+const unsigned char FLOOR_COLOR[3] = {90, 90, 90};
+const unsigned char TAG_COLOR[3] = {147, 20, 255};
+
+/**************************************
+ * Definition: Sets up the field and puts our robot at its start
+ *
+ * Parameters: the robot's name or address (for its north star
+ *             calibration), and which robot we are in the game (1 or 2)
+ **************************************/
+SimRobotInterface::SimRobotInterface(std::string address, int id) {
+    _id = (id == 2) ? 2 : 1;
+
+    unsigned int seed = 1;
+    const char *seedVariable = getenv("SIM_SEED");
+    if (seedVariable != NULL) {
+        seed = (unsigned int) atoi(seedVariable);
+    }
+
+    // posts every other cell in from the edges, pellets everywhere else
+    for (int x = 0; x < SIM_MAP_WIDTH; x++) {
+        for (int y = 0; y < SIM_MAP_HEIGHT; y++) {
+            _types[x][y] = MAP_OBJ_PELLET;
+            _points[x][y] = SIM_PELLET_POINTS;
+            if (x % 2 == 1 && y % 2 == 1) {
+                _types[x][y] = MAP_OBJ_POST;
+                _points[x][y] = 0;
+            }
+            else if ((x == 0 || x == SIM_MAP_WIDTH - 1) &&
+                     (y == 0 || y == SIM_MAP_HEIGHT - 1)) {
+                _points[x][y] = SIM_POWER_PELLET_POINTS;
+            }
+        }
+    }
+    _types[SIM_ROBOT_1_X][SIM_ROBOT_1_Y] = MAP_OBJ_ROBOT_1;
+    _points[SIM_ROBOT_1_X][SIM_ROBOT_1_Y] = 0;
+    _types[SIM_ROBOT_2_X][SIM_ROBOT_2_Y] = MAP_OBJ_ROBOT_2;
+    _points[SIM_ROBOT_2_X][SIM_ROBOT_2_Y] = 0;
+    _score[0] = 0;
+    _score[1] = 0;
+
+    // robot 1 starts on the east end facing west, robot 2 the other way
+    float theta;
+    if (_id == 1) {
+        _cellX = SIM_ROBOT_1_X;
+        _cellY = SIM_ROBOT_1_Y;
+        theta = PI;
+    }
+    else {
+        _cellX = SIM_ROBOT_2_X;
+        _cellY = SIM_ROBOT_2_Y;
+        theta = 0;
+    }
+
+    int name = Util::nameFrom(address);
+    _model = new RovioModel(name, _centerX(_cellX), _centerY(_cellY), theta, seed);
+    _model->setNoise(SIM_NS_NOISE, SIM_NS_THETA_NOISE, SIM_WE_NOISE, SIM_SLIP);
+    _model->loadCalibration(NS_CALIBRATION_FILE);
+    _lastStep = SimClock::now();
+
+    for (int w = 0; w < 3; w++) {
+        _ticks[w] = 0;
+    }
+    _model->readNorthStar(&_nsX, &_nsY, &_nsTheta, &_room, &_strength);
+
+    printf("simulating robot %d (seed %u)\n", _id, seed);
+}
+
+SimRobotInterface::~SimRobotInterface() {
+    printf("simulated %.1f s: scores %d to %d, robot ended at (%.1f, %.1f) facing %.3f\n",
+           SimClock::now(), _score[0], _score[1],
+           _model->getX(), _model->getY(), _model->getTheta());
+    delete _model;
+}
+
+/**************************************
+ * Definition: Reads the sensors, as of the simulated time
+ *
+ * Returns:    RI_RESP_SUCCESS
+ **************************************/
+int SimRobotInterface::update(void) {
+    _step();
+    _model->takeWheelTicks(_ticks);
+    _model->readNorthStar(&_nsX, &_nsY, &_nsTheta, &_room, &_strength);
+    return RI_RESP_SUCCESS;
+}
+
+void SimRobotInterface::reset_state(void) {
+}
+
+/**************************************
+ * Definition: Starts the rovio carrying out a move
+ *
+ * Parameters: the move (RI_*) and speed
+ *
+ * Returns:    RI_RESP_SUCCESS, or RI_RESP_FAILURE for a move the
+ *             rovio doesn't have
+ **************************************/
+int SimRobotInterface::Move(int movement, int speed) {
+    int drive = _toDrive(movement);
+    if (drive < 0) {
+        return RI_RESP_FAILURE;
+    }
+
+    // finish the last move up to now before starting this one
+    _step();
+    _model->drive(drive, speed);
+    return RI_RESP_SUCCESS;
+}
+
+/**************************************
+ * Definition: Returns a wheel's ticks from the last update
+ *
+ * Parameters: the wheel (RI_WHEEL_*)
+ *
+ * Returns:    the ticks it rolled between the last two updates
+ **************************************/
+int SimRobotInterface::getWheelEncoder(int wheel) {
+    switch (wheel) {
+    case RI_WHEEL_LEFT:
+        return _ticks[0];
+    case RI_WHEEL_RIGHT:
+        return _ticks[1];
+    case RI_WHEEL_REAR:
+        return _ticks[2];
+    }
+    return 0;
+}
+
+/**************************************
+ * Definition: Checks for anything just in front of the robot
+ *
+ * Returns:    true if there's a wall or post within SIM_IR_RANGE
+ **************************************/
+bool SimRobotInterface::IR_Detected(void) {
+    float reach = ROBOT_DIAMETER / 2.0 + SIM_IR_RANGE;
+    return _isWallAt(_model->getX() + reach * cos(_model->getTheta()),
+                     _model->getY() + reach * sin(_model->getTheta()));
+}
+
+/**************************************
+ * Definition: Returns north star's x from the last update
+ *
+ * Returns:    x in the room's ticks
+ **************************************/
+int SimRobotInterface::X(void) {
+    return _nsX;
+}
+
+/**************************************
+ * Definition: Returns north star's y from the last update
+ *
+ * Returns:    y in the room's ticks
+ **************************************/
+int SimRobotInterface::Y(void) {
+    return _nsY;
+}
+
+/**************************************
+ * Definition: Returns north star's theta from the last update
+ *
+ * Returns:    theta in the room's radians
+ **************************************/
+float SimRobotInterface::Theta(void) {
+    return _nsTheta;
+}
+
+/**************************************
+ * Definition: Returns which room's beacon north star read at the
+ *             last update
+ *
+ * Returns:    the room (2-5)
+ **************************************/
+int SimRobotInterface::RoomID(void) {
+    return _room;
+}
+
+/**************************************
+ * Definition: Returns the battery level (always full)
+ *
+ * Returns:    the battery level
+ **************************************/
+int SimRobotInterface::Battery(void) {
+    return 126;
+}
+
+/**************************************
+ * Definition: Returns north star's signal strength from the last
+ *             update
+ *
+ * Returns:    the raw strength
+ **************************************/
+int SimRobotInterface::NavStrengthRaw(void) {
+    return _strength;
+}
+
+/**************************************
+ * Definition: Returns the game map, like the game server. Once the
+ *             game is over, every pellet is gone
+ *
+ * Parameters: pointers to put each robot's score in
+ *
+ * Returns:    a list of every cell (ours until the next call)
+ **************************************/
+map_obj_t* SimRobotInterface::getMap(int *score1, int *score2) {
+    bool over = SimClock::now() > SIM_GAME_TIME;
+
+    int i = 0;
+    for (int x = 0; x < SIM_MAP_WIDTH; x++) {
+        for (int y = 0; y < SIM_MAP_HEIGHT; y++) {
+            map_obj_t *cell = &_map[i];
+            cell->x = x;
+            cell->y = y;
+            cell->type = _types[x][y];
+            cell->points = _points[x][y];
+            if (over && cell->type == MAP_OBJ_PELLET) {
+                cell->type = MAP_OBJ_EMPTY;
+                cell->points = 0;
+            }
+            cell->next = (i + 1 < SIM_MAP_WIDTH * SIM_MAP_HEIGHT) ? &_map[i + 1] : NULL;
+            i++;
+        }
+    }
+
+    *score1 = _score[0];
+    *score2 = _score[1];
+    return _map;
+}
+
+/**************************************
+ * Definition: Moves our robot to a cell on the map, eating its
+ *             pellet. Only cells next to ours that aren't posts or
+ *             the other robot's can be moved to
+ *
+ * Parameters: the cell's x and y
+ *
+ * Returns:    RI_RESP_SUCCESS, or RI_RESP_FAILURE if we can't
+ **************************************/
+int SimRobotInterface::updateMap(int x, int y) {
+    if (x < 0 || x >= SIM_MAP_WIDTH || y < 0 || y >= SIM_MAP_HEIGHT ||
+        abs(x - _cellX) + abs(y - _cellY) > 1) {
+        return RI_RESP_FAILURE;
+    }
+
+    int type = _types[x][y];
+    int otherRobot = (_id == 1) ? MAP_OBJ_ROBOT_2 : MAP_OBJ_ROBOT_1;
+    int otherReserve = (_id == 1) ? MAP_OBJ_RESERVE_2 : MAP_OBJ_RESERVE_1;
+    if (type == MAP_OBJ_POST || type == otherRobot || type == otherReserve) {
+        return RI_RESP_FAILURE;
+    }
+
+    _types[_cellX][_cellY] = MAP_OBJ_EMPTY;
+    _score[_id - 1] += _points[x][y];
+    _points[x][y] = 0;
+    _types[x][y] = (_id == 1) ? MAP_OBJ_ROBOT_1 : MAP_OBJ_ROBOT_2;
+    _cellX = x;
+    _cellY = y;
+    return RI_RESP_SUCCESS;
+}
+
+/**************************************
+ * Definition: Reserves a cell on the map for our robot
+ *
+ * Parameters: the cell's x and y
+ *
+ * Returns:    RI_RESP_SUCCESS, or RI_RESP_FAILURE if it's a post
+ *             or already the other robot's
+ **************************************/
+int SimRobotInterface::reserveMap(int x, int y) {
+    if (x < 0 || x >= SIM_MAP_WIDTH || y < 0 || y >= SIM_MAP_HEIGHT) {
+        return RI_RESP_FAILURE;
+    }
+
+    int type = _types[x][y];
+    int otherRobot = (_id == 1) ? MAP_OBJ_ROBOT_2 : MAP_OBJ_ROBOT_1;
+    int otherReserve = (_id == 1) ? MAP_OBJ_RESERVE_2 : MAP_OBJ_RESERVE_1;
+    if (type == MAP_OBJ_POST || type == otherRobot || type == otherReserve) {
+        return RI_RESP_FAILURE;
+    }
+
+    // the cell we're in stays ours
+    if (x != _cellX || y != _cellY) {
+        _types[x][y] = (_id == 1) ? MAP_OBJ_RESERVE_1 : MAP_OBJ_RESERVE_2;
+    }
+    return RI_RESP_SUCCESS;
+}
+
+/**************************************
+ * Definition: Draws what the camera sees: walls above the horizon,
+ *             floor below, and a pink tag in the middle of every wall
+ *             facing us that isn't hidden behind a post
+ *
+ * Parameters: a BGR image (of the camera's resolution) to draw in
+ *
+ * Returns:    RI_RESP_SUCCESS
+ **************************************/
+int SimRobotInterface::getImage(IplImage *image) {
+    _step();
+
+    for (int row = 0; row < image->height; row++) {
+        const unsigned char *color = (row < image->height / 2) ? WALL_COLOR : FLOOR_COLOR;
+        unsigned char *pixel = (unsigned char *)(image->imageData + row * image->widthStep);
+        for (int col = 0; col < image->width; col++) {
+            for (int c = 0; c < 3; c++) {
+                pixel[col * image->nChannels + c] = color[c];
+            }
+        }
+    }
+
+    float cameraHeight = SIM_CAMERA_HEIGHT_DOWN;
+    if (_model->getHeadPosition() == DRIVE_HEAD_MIDDLE) {
+        cameraHeight = SIM_CAMERA_HEIGHT_MIDDLE;
+    }
+    else if (_model->getHeadPosition() == DRIVE_HEAD_UP) {
+        cameraHeight = SIM_CAMERA_HEIGHT_UP;
+    }
+
+    float x = _model->getX();
+    float y = _model->getY();
+    float theta = _model->getTheta();
+    // the global way each direction goes from a cell: +x is west
+    // in cells, so it's -x globally
+    int stepX[4] = {1, -1, 0, 0};
+    int stepY[4] = {0, 0, 1, -1};
+
+    for (int cellX = 0; cellX < SIM_MAP_WIDTH; cellX++) {
+        for (int cellY = 0; cellY < SIM_MAP_HEIGHT; cellY++) {
+            if (_isWall(cellX, cellY)) {
+                continue;
+            }
+            for (int d = 0; d < 4; d++) {
+                if (!_isWall(cellX + stepX[d], cellY + stepY[d])) {
+                    continue;
+                }
+                // the tag's in the middle of the wall, facing into the cell
+                float outX = -stepX[d] * SIM_CELL_SIZE / 2;
+                float outY = stepY[d] * SIM_CELL_SIZE / 2;
+                float tagX = _centerX(cellX) + outX;
+                float tagY = _centerY(cellY) + outY;
+                if ((x - tagX) * outX + (y - tagY) * outY >= 0) {
+                    continue;
+                }
+                if (!_canSee(x, y, tagX, tagY)) {
+                    continue;
+                }
+
+                float forward = (tagX - x) * cos(theta) + (tagY - y) * sin(theta);
+                float left = -(tagX - x) * sin(theta) + (tagY - y) * cos(theta);
+                _drawTag(image, forward, left, SIM_TAG_HEIGHT - cameraHeight);
+            }
+        }
+    }
+
+    return RI_RESP_SUCCESS;
+}
+
+/**************************************
+ * Definition: Takes the camera settings (the drawn image doesn't
+ *             change with them)
+ *
+ * Returns:    0 for success, like robot_if
+ **************************************/
+int SimRobotInterface::CameraCfg(int brightness, int contrast, int frameRate,
+                                 int resolution, int quality) {
+    return 0;
+}
+
+// moves the rovio along to the simulated time
+void SimRobotInterface::_step() {
+    double now = SimClock::now();
+    while (_lastStep < now) {
+        double dt = fmin(now - _lastStep, MODEL_STEP);
+        _model->step(dt);
+        _keepOutOfWalls();
+        _lastStep += dt;
+    }
+}
+
+// pushes the rovio back out of any post or outside wall it's run
+// into, the shortest way out
+void SimRobotInterface::_keepOutOfWalls() {
+    float radius = ROBOT_DIAMETER / 2.0;
+    float x = _model->getX();
+    float y = _model->getY();
+
+    // the field's edges, globally (cell 0 is the east end)
+    float east = _centerX(0) + SIM_CELL_SIZE / 2 - radius;
+    float west = _centerX(SIM_MAP_WIDTH - 1) - SIM_CELL_SIZE / 2 + radius;
+    float south = _centerY(0) - SIM_CELL_SIZE / 2 + radius;
+    float north = _centerY(SIM_MAP_HEIGHT - 1) + SIM_CELL_SIZE / 2 - radius;
+    x = fmax(west, fmin(east, x));
+    y = fmax(south, fmin(north, y));
+
+    for (int cellX = 0; cellX < SIM_MAP_WIDTH; cellX++) {
+        for (int cellY = 0; cellY < SIM_MAP_HEIGHT; cellY++) {
+            if (_types[cellX][cellY] != MAP_OBJ_POST) {
+                continue;
+            }
+            float dx = x - _centerX(cellX);
+            float dy = y - _centerY(cellY);
+            float reach = SIM_CELL_SIZE / 2 + radius;
+            if (fabs(dx) >= reach || fabs(dy) >= reach) {
+                continue;
+            }
+            if (reach - fabs(dx) < reach - fabs(dy)) {
+                x = _centerX(cellX) + ((dx < 0) ? -reach : reach);
+            }
+            else {
+                y = _centerY(cellY) + ((dy < 0) ? -reach : reach);
+            }
+        }
+    }
+
+    if (x != _model->getX() || y != _model->getY()) {
+        _model->place(x, y);
+    }
+}
+
+// whether a cell is a post or off the field
+bool SimRobotInterface::_isWall(int x, int y) {
+    if (x < 0 || x >= SIM_MAP_WIDTH || y < 0 || y >= SIM_MAP_HEIGHT) {
+        return true;
+    }
+    return _types[x][y] == MAP_OBJ_POST;
+}
+
+// whether a global point is in a post or off the field
+bool SimRobotInterface::_isWallAt(float x, float y) {
+    return _isWall(_toCellX(x), _toCellY(y));
+}
+
+// whether there's a clear line from one point to another, stopping
+// just short of the end (which is on a wall)
+bool SimRobotInterface::_canSee(float fromX, float fromY, float toX, float toY) {
+    float dx = toX - fromX;
+    float dy = toY - fromY;
+    float length = sqrt(dx * dx + dy * dy);
+    for (float along = SIGHT_STEP; along < length - 1; along += SIGHT_STEP) {
+        if (_isWallAt(fromX + dx * along / length, fromY + dy * along / length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// draws a tag centered some way in front of the camera, to its left
+// and above it (cm), if it's in view
+void SimRobotInterface::_drawTag(IplImage *image, float forward, float left, float height) {
+    if (forward < ROBOT_DIAMETER / 2.0) {
+        return;
+    }
+
+    float focal = (image->width / 2.0) / tan(SIM_CAMERA_FOV / 2);
+    float u = image->width / 2.0 - focal * left / forward;
+    float v = image->height / 2.0 - focal * height / forward;
+    float half = focal * SIM_TAG_SIZE / (2 * forward);
+
+    int left0 = (int) fmax(0, u - half);
+    int right0 = (int) fmin(image->width - 1, u + half);
+    int top = (int) fmax(0, v - half);
+    int bottom = (int) fmin(image->height - 1, v + half);
+    for (int row = top; row <= bottom; row++) {
+        unsigned char *pixel = (unsigned char *)(image->imageData + row * image->widthStep);
+        for (int col = left0; col <= right0; col++) {
+            for (int c = 0; c < 3; c++) {
+                pixel[col * image->nChannels + c] = TAG_COLOR[c];
+            }
+        }
+    }
+}
+
+// robot_if's moves as the rovio model's drive codes
+int SimRobotInterface::_toDrive(int movement) {
+    switch (movement) {
+    case RI_STOP:
+        return DRIVE_STOP;
+    case RI_MOVE_FORWARD:
+        return DRIVE_FORWARD;
+    case RI_MOVE_BACKWARD:
+        return DRIVE_BACKWARD;
+    case RI_MOVE_LEFT:
+        return DRIVE_LEFT;
+    case RI_MOVE_RIGHT:
+        return DRIVE_RIGHT;
+    case RI_TURN_LEFT:
+        return DRIVE_TURN_LEFT;
+    case RI_TURN_RIGHT:
+        return DRIVE_TURN_RIGHT;
+    case RI_MOVE_FWD_LEFT:
+        return DRIVE_FWD_LEFT;
+    case RI_MOVE_FWD_RIGHT:
+        return DRIVE_FWD_RIGHT;
+    case RI_MOVE_BACK_LEFT:
+        return DRIVE_BACK_LEFT;
+    case RI_MOVE_BACK_RIGHT:
+        return DRIVE_BACK_RIGHT;
+    case RI_TURN_LEFT_20DEG:
+        return DRIVE_TURN_LEFT_20;
+    case RI_TURN_RIGHT_20DEG:
+        return DRIVE_TURN_RIGHT_20;
+    case RI_HEAD_UP:
+        return DRIVE_HEAD_UP;
+    case RI_HEAD_DOWN:
+        return DRIVE_HEAD_DOWN;
+    case RI_HEAD_MIDDLE:
+        return DRIVE_HEAD_MIDDLE;
+    }
+    return -1;
+}
+
+// the global center of a cell
+float SimRobotInterface::_centerX(int x) {
+    return SIM_FIELD_X0 - x * SIM_CELL_SIZE;
+}
+
+float SimRobotInterface::_centerY(int y) {
+    return SIM_FIELD_Y0 + y * SIM_CELL_SIZE;
+}
+
+// the cell a global point is in
+int SimRobotInterface::_toCellX(float x) {
+    return (int) floor((SIM_FIELD_X0 - x) / SIM_CELL_SIZE + 0.5);
+}
+
+int SimRobotInterface::_toCellY(float y) {
+    return (int) floor((y - SIM_FIELD_Y0) / SIM_CELL_SIZE + 0.5);
+}
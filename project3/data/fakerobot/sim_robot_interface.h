@@ -0,0 +1,116 @@
+/**
+ * sim_robot_interface.h
+ *
+ * @brief
+ *      Simulates a rovio and the game field behind the same calls the
+ *      robot makes on robot_if's RobotInterface, so whole games can be
+ *      run without a robot (building with USE_SIMULATOR swaps it in, see
+ *      robot_interface.h). The rovio is a RovioModel, moved along on the
+ *      simulator's clock, and kept out of the posts and the field's
+ *      walls. The game server's map, reserving, and occupying are played
+ *      out on a field of posts and pellets, with the other robot sitting
+ *      at its start. Camera images are drawn from the robot's pose, with
+ *      a pink tag on every wall in sight. Everything random comes from
+ *      one seed (the SIM_SEED environment variable), so a game can be
+ *      repeated exactly
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_SIMROBOTINTERFACE_H
+#define CS1567_SIMROBOTINTERFACE_H
+
+#include "rovio_model.h"
+
+#include <robot_if++.h>
+#include <string>
+
+// the field and the IR's range are in rovio_model.h
+
+// where each robot starts (cells), facing into the field
+#define SIM_ROBOT_1_X 0
+#define SIM_ROBOT_1_Y 2
+#define SIM_ROBOT_2_X 6
+#define SIM_ROBOT_2_Y 2
+
+// pellets are worth this much, and the corners' power pellets more
+#define SIM_PELLET_POINTS 1
+#define SIM_POWER_PELLET_POINTS 5
+
+// the game ends (the map comes back empty) after this long (seconds)
+#define SIM_GAME_TIME 600.0
+
+// how noisy the simulated rovio is (see RovioModel::setNoise)
+#define SIM_NS_NOISE 3.0
+#define SIM_NS_THETA_NOISE 0.05
+#define SIM_WE_NOISE 0.05
+#define SIM_SLIP 0.05
+
+// the camera: its field of view (radians), its height (cm) with the
+// head down, middle, and up, and the tags' size and height (cm)
+#define SIM_CAMERA_FOV 0.872664626
+#define SIM_CAMERA_HEIGHT_DOWN 8.0
+#define SIM_CAMERA_HEIGHT_MIDDLE 12.0
+#define SIM_CAMERA_HEIGHT_UP 20.0
+#define SIM_TAG_SIZE 10.0
+#define SIM_TAG_HEIGHT 15.0
+
+class SimRobotInterface {
+public:
+    SimRobotInterface(std::string address, int id);
+    ~SimRobotInterface();
+    int update(void);
+    void reset_state(void);
+    int Move(int movement, int speed);
+    int getWheelEncoder(int wheel);
+    bool IR_Detected(void);
+    int X(void);
+    int Y(void);
+    float Theta(void);
+    int RoomID(void);
+    int Battery(void);
+    int NavStrengthRaw(void);
+    map_obj_t* getMap(int *score1, int *score2);
+    int updateMap(int x, int y);
+    int reserveMap(int x, int y);
+    int getImage(IplImage *image);
+    int CameraCfg(int brightness, int contrast, int frameRate,
+                  int resolution, int quality);
+private:
+    int _id;
+    RovioModel *_model;
+    double _lastStep;
+
+    // what the last update read
+    int _ticks[3];
+    int _nsX;
+    int _nsY;
+    float _nsTheta;
+    int _room;
+    int _strength;
+
+    int _types[SIM_MAP_WIDTH][SIM_MAP_HEIGHT];
+    int _points[SIM_MAP_WIDTH][SIM_MAP_HEIGHT];
+    int _score[2];
+    int _cellX;
+    int _cellY;
+    map_obj_t _map[SIM_MAP_WIDTH * SIM_MAP_HEIGHT];
+
+    void _step();
+    void _keepOutOfWalls();
+    bool _isWall(int x, int y);
+    bool _isWallAt(float x, float y);
+    bool _canSee(float fromX, float fromY, float toX, float toY);
+    void _drawTag(IplImage *image, float forward, float left, float height);
+    static int _toDrive(int movement);
+    static float _centerX(int x);
+    static float _centerY(int y);
+    static int _toCellX(float x);
+    static int _toCellY(float y);
+};
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * fit_calibration.cpp
+ *
+ * @brief
+ * 		Fits a robot's north star calibration for one room by least
+ *      squares. The samples file has one line per spot the robot was
+ *      parked at:
+ *
+ *          rawX,rawY,rawTheta,globalX,globalY,globalTheta
+ *
+ *      with the raw north star reading and where the robot really was
+ *      (in cm and radians, in the global coordinate system). It prints
+ *      the error of the current calibration and of the fitted one, and
+ *      the line to add to calibration/north_star.cal
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "../ns_calibration.h"
+#include "../room_transform.h"
+#include "../utilities.h"
+
+// the room number north star reports for ROOM_2
+#define FIRST_ROOM_ID 2
+// fewest samples that pin down the six parameters
+#define MIN_SAMPLES 3
+
+struct Sample {
+	float raw[3];
+	float global[3];
+};
+
+/**************************************
+ * Definition: Solves a 3x3 system by Cramer's rule
+ *
+ * Parameters: the matrix (row major), right hand side, and solution
+ *
+ * Returns:    false if the matrix is singular
+ **************************************/
+bool solve3(double *A, double *b, double *x) {
+	double det = A[0] * (A[4] * A[8] - A[5] * A[7])
+	           - A[1] * (A[3] * A[8] - A[5] * A[6])
+	           + A[2] * (A[3] * A[7] - A[4] * A[6]);
+	if (fabs(det) < 1e-12) {
+		return false;
+	}
+	for (int col = 0; col < 3; col++) {
+		double M[9];
+		for (int i = 0; i < 9; i++) {
+			M[i] = (i % 3 == col) ? b[i / 3] : A[i];
+		}
+		x[col] = (M[0] * (M[4] * M[8] - M[5] * M[7])
+		        - M[1] * (M[3] * M[8] - M[5] * M[6])
+		        + M[2] * (M[3] * M[7] - M[4] * M[6])) / det;
+	}
+	return true;
+}
+
+/**************************************
+ * Definition: Fits one axis of the samples' global position as a
+ *             line in that axis of the reading, by least squares
+ *
+ * Parameters: the readings' values on the axis, the samples, which
+ *             axis (0 for x, 1 for y), and where to put the slope
+ *             and intercept
+ *
+ * Returns:    false if the readings are all the same
+ **************************************/
+bool fitLine(std::vector<float> *raw, std::vector<Sample> *samples, int axis,
+             double *slope, double *intercept) {
+	double n = samples->size();
+	double sumRaw = 0, sumGlobal = 0, sumRawRaw = 0, sumRawGlobal = 0;
+	for (unsigned int i = 0; i < samples->size(); i++) {
+		double r = (*raw)[i];
+		double g = (*samples)[i].global[axis];
+		sumRaw += r;
+		sumGlobal += g;
+		sumRawRaw += r * r;
+		sumRawGlobal += r * g;
+	}
+	double det = n * sumRawRaw - sumRaw * sumRaw;
+	if (fabs(det) < 1e-12) {
+		return false;
+	}
+	*slope = (n * sumRawGlobal - sumRaw * sumGlobal) / det;
+	*intercept = (sumGlobal - *slope * sumRaw) / n;
+	return true;
+}
+
+/**************************************
+ * Definition: Returns the rms position and theta error of a
+ *             calibration over the samples
+ *
+ * Parameters: the room, its calibration, the samples, and where to
+ *             put the theta error
+ *
+ * Returns:    the rms position error in cm
+ **************************************/
+float rmsError(int room, RoomCalibration *calibration, std::vector<Sample> *samples,
+               float *thetaError) {
+	RoomTransform transform;
+	transform.set(room, calibration);
+	double position = 0;
+	double theta = 0;
+	for (unsigned int i = 0; i < samples->size(); i++) {
+		Sample *s = &(*samples)[i];
+		float x = s->raw[0];
+		float y = s->raw[1];
+		float t = s->raw[2];
+		transform.toGlobal(&x, &y, &t);
+		position += pow(x - s->global[0], 2) + pow(y - s->global[1], 2);
+		theta += pow(Util::normalizeThetaError(t - s->global[2]), 2);
+	}
+	*thetaError = sqrt(theta / samples->size());
+	return sqrt(position / samples->size());
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 4) {
+		printf("usage: %s [robot name] [room 2-5] [samples file]\n", argv[0]);
+		exit(-1);
+	}
+	int name = Util::nameFrom(argv[1]);
+	int room = atoi(argv[2]) - FIRST_ROOM_ID;
+	if (name < 0 || name >= NUM_ROBOTS || room < 0 || room >= NUM_ROOMS) {
+		printf("ERROR: unknown robot or room\n");
+		exit(-1);
+	}
+
+	std::vector<Sample> samples;
+	std::ifstream f(argv[3]);
+	std::string line;
+	while (std::getline(f, line)) {
+		Sample s;
+		if (sscanf(line.c_str(), "%f,%f,%f,%f,%f,%f", &s.raw[0], &s.raw[1], &s.raw[2],
+		           &s.global[0], &s.global[1], &s.global[2]) == 6) {
+			samples.push_back(s);
+		}
+	}
+	if (samples.size() < MIN_SAMPLES) {
+		printf("ERROR: need at least %d samples, found %d\n", MIN_SAMPLES, (int)samples.size());
+		exit(-2);
+	}
+
+	// the reading that goes into the affine part (room 2's skew comes first)
+	std::vector<float> px(samples.size());
+	std::vector<float> py(samples.size());
+	for (unsigned int i = 0; i < samples.size(); i++) {
+		RoomCalibration identity = {1, 1, 0, -COL_OFFSET[0], -COL_OFFSET[1], 0};
+		RoomTransform skew;
+		skew.set(room, &identity);
+		float t = 0;
+		px[i] = samples[i].raw[0];
+		py[i] = samples[i].raw[1];
+		skew.toGlobal(&px[i], &py[i], &t);
+	}
+
+	NSCalibration current(name);
+	RoomCalibration fitted;
+	if (room == ROOM_2) {
+		// room 2's skew stands in for the rotation on x and y, so
+		// each axis is only a scale and an offset. its rotation only
+		// turns theta, the same as the theta shift, so the current
+		// rotation is kept and the theta shift is fit around it
+		double slopeX, slopeY, offsetX, offsetY;
+		if (!fitLine(&px, &samples, 0, &slopeX, &offsetX) ||
+		    !fitLine(&py, &samples, 1, &slopeY, &offsetY)) {
+			printf("ERROR: samples are all in a line, spread them out\n");
+			exit(-2);
+		}
+		fitted.scaleX = 1 / slopeX;
+		fitted.scaleY = 1 / slopeY;
+		fitted.rotation = current.getRoom(room)->rotation;
+		fitted.originX = offsetX - COL_OFFSET[0];
+		fitted.originY = offsetY - COL_OFFSET[1];
+	}
+	else {
+		// least squares for global = [a b c; d e f] [x y 1]
+		double normal[9] = {0};
+		double rhsX[3] = {0};
+		double rhsY[3] = {0};
+		for (unsigned int i = 0; i < samples.size(); i++) {
+			double row[3] = {px[i], py[i], 1};
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 3; k++) {
+					normal[j * 3 + k] += row[j] * row[k];
+				}
+				rhsX[j] += row[j] * samples[i].global[0];
+				rhsY[j] += row[j] * samples[i].global[1];
+			}
+		}
+		double rowX[3];
+		double rowY[3];
+		if (!solve3(normal, rhsX, rowX) || !solve3(normal, rhsY, rowY)) {
+			printf("ERROR: samples are all in a line, spread them out\n");
+			exit(-2);
+		}
+
+		// pull the rotation and scales out of the affine fit. each row
+		// gives its own estimate of the rotation, so average them
+		fitted.scaleX = 1 / sqrt(rowX[0] * rowX[0] + rowX[1] * rowX[1]);
+		fitted.scaleY = 1 / sqrt(rowY[0] * rowY[0] + rowY[1] * rowY[1]);
+		double rotationX = atan2(-rowX[1], rowX[0]);
+		double rotationY = atan2(rowY[0], rowY[1]);
+		fitted.rotation = atan2(sin(rotationX) + sin(rotationY), cos(rotationX) + cos(rotationY));
+		fitted.originX = rowX[2] - COL_OFFSET[0];
+		fitted.originY = rowY[2] - COL_OFFSET[1];
+	}
+
+	// global theta = raw theta - rotation - theta shift
+	double sumSin = 0;
+	double sumCos = 0;
+	for (unsigned int i = 0; i < samples.size(); i++) {
+		double shift = samples[i].raw[2] - fitted.rotation - samples[i].global[2];
+		sumSin += sin(shift);
+		sumCos += cos(shift);
+	}
+	fitted.thetaShift = atan2(sumSin, sumCos);
+
+	float currentTheta, fittedTheta;
+	float currentError = rmsError(room, current.getRoom(room), &samples, &currentTheta);
+	float fittedError = rmsError(room, &fitted, &samples, &fittedTheta);
+
+	printf("%d samples of %s in room %d\n", (int)samples.size(), argv[1], room + FIRST_ROOM_ID);
+	printf("current: %s\n", NSCalibration::format(name, room, current.getRoom(room)).c_str());
+	printf("         rms error %.1f cm, %.3f rad\n", currentError, currentTheta);
+	printf("fitted:  %s\n", NSCalibration::format(name, room, &fitted).c_str());
+	printf("         rms error %.1f cm, %.3f rad\n", fittedError, fittedTheta);
+	return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * smooth_track.cpp
+ *
+ * @brief
+ * 		Reads a logged run in the same layout as the bender-*.csv files
+ *      (<prefix>-NS.csv and <prefix>-WE.csv, one x,y,theta per line),
+ *      runs it through the extended Kalman filter with the robot's
+ *      uncertainties, smooths it, and writes <prefix>-SM.csv in the
+ *      same layout, one row for each row read (the first is where the
+ *      filter starts). With a lag it writes the fixed-lag (online)
+ *      estimates instead of the fixed-interval ones.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../kalman_smoother.h"
+#include "../utilities.h"
+#include "../constants.h"
+
+void writePose(FILE *file, Pose *pose) {
+	fprintf(file, "%f,%f,%f\n", pose->getX(), pose->getY(),
+	        Util::normalizeThetaError(pose->getTheta()));
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("usage: %s [filename prefix] [lag, 0 for the whole run] [seconds per sample]\n", argv[0]);
+		exit(-1);
+	}
+	int lag = argc > 2 ? atoi(argv[2]) : 0;
+	float dt = argc > 3 ? atof(argv[3]) : EKF_DEFAULT_DT;
+
+	char filename[256];
+	sprintf(filename, "%s-NS.csv", argv[1]);
+	FILE *nsFile = fopen(filename, "r");
+	sprintf(filename, "%s-WE.csv", argv[1]);
+	FILE *weFile = fopen(filename, "r");
+	sprintf(filename, "%s-SM.csv", argv[1]);
+	FILE *outFile = fopen(filename, "w");
+	if (nsFile == NULL || weFile == NULL || outFile == NULL) {
+		printf("ERROR: could not open the files for %s\n", argv[1]);
+		exit(-2);
+	}
+
+	float ns[3];
+	float we[3];
+	Pose *pose = NULL;
+	ExtendedKalmanFilter *filter = NULL;
+	KalmanSmoother *smoother = NULL;
+	int samples = 0;
+
+	while (fscanf(nsFile, "%f,%f,%f", &ns[0], &ns[1], &ns[2]) == 3 &&
+	       fscanf(weFile, "%f,%f,%f", &we[0], &we[1], &we[2]) == 3) {
+		Pose nsPose(ns[0], ns[1], Util::normalizeTheta(ns[2]));
+		Pose wePose(we[0], we[1], Util::normalizeTheta(we[2]));
+
+		if (samples++ == 0) {
+			// start halfway between the two, like the filter test
+			pose = new Pose((ns[0] + we[0]) / 2, (ns[1] + we[1]) / 2,
+			                Util::normalizeTheta(ns[2] + Util::normalizeThetaError(we[2] - ns[2]) / 2));
+			filter = new ExtendedKalmanFilter(pose);
+			filter->setUncertainty(PROC_X_UNCERTAIN, PROC_Y_UNCERTAIN, PROC_THETA_UNCERTAIN,
+			                       NS_X_UNCERTAIN, NS_Y_UNCERTAIN, NS_THETA_UNCERTAIN,
+			                       WE_X_UNCERTAIN, WE_Y_UNCERTAIN, WE_THETA_UNCERTAIN);
+			smoother = new KalmanSmoother(filter, lag);
+			// the start has no step of its own to smooth, so it goes
+			// out as it is
+			writePose(outFile, pose);
+			continue;
+		}
+
+		filter->setTimeStep(dt);
+		smoother->filter(&nsPose, &wePose);
+
+		Pose lagged(0, 0, 0);
+		if (smoother->getLagged(&lagged)) {
+			writePose(outFile, &lagged);
+		}
+	}
+
+	if (smoother != NULL) {
+		// everything still held gets the full backward pass. with a lag,
+		// the oldest step held was already written above
+		smoother->smooth();
+		int first = (lag > 0 && smoother->getNumSteps() == lag + 1) ? 1 : 0;
+		for (int i = first; i < smoother->getNumSteps(); i++) {
+			Pose smoothed(0, 0, 0);
+			smoother->getSmoothed(i, &smoothed);
+			writePose(outFile, &smoothed);
+		}
+	}
+
+	printf("smoothed %d samples into %s\n", samples, filename);
+
+	delete smoother;
+	delete filter;
+	delete pose;
+	fclose(nsFile);
+	fclose(weFile);
+	fclose(outFile);
+	return 0;
+}
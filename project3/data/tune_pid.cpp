@@ -0,0 +1,788 @@
+/**
+ * tune_pid.cpp
+ *
+ * @brief
+ * 		Tunes the move and turn PIDs against a simulated rovio instead of
+ *      the real one. The plant moves at the measured speed for whatever
+ *      robot speed the PID's gain turns into (from the tables in
+ *      constants.h, or data/speeds.txt with -s), getting there with a
+ *      first order lag, and the PID sees its position a control period
+ *      late with some north star noise. The loops are run the way
+ *      Robot::moveToUntil and Robot::turnTo run them, using the real
+ *      PID class.
+ *
+ *      A relay test finds where the plant starts to oscillate, and the
+ *      Ziegler-Nichols rules turn that into a first guess. From there
+ *      several Nelder-Mead searches (each from a different multiple of
+ *      the guess, each on its own thread) look for the gains with the
+ *      lowest cost, which is the settle time plus a penalty for every
+ *      cm or radian of overshoot. It reports settle time and overshoot
+ *      for the current constants, the first guess, and the best gains,
+ *      and prints the best as #defines for constants.h
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include <string>
+#include <fstream>
+#include "../PID.h"
+#include "../constants.h"
+#include "../utilities.h"
+
+#define LOOP_MOVE 0
+#define LOOP_TURN 1
+
+// SPEED_TURN's columns (DIR_LEFT and DIR_RIGHT in robot.h)
+#define TURN_LEFT 0
+#define TURN_RIGHT 1
+
+/* plant model */
+// seconds for the robot to get (most of the way) to a new speed
+#define PLANT_LAG 0.25
+// control periods between when the robot is somewhere and when the
+// filtered pose says so
+#define PLANT_DELAY 1
+// north star noise (standard deviation) in cm and radians
+#define PLANT_NOISE_CM 2.0
+#define PLANT_NOISE_RAD 0.03
+// integration steps per control period
+#define PLANT_SUBSTEPS 20
+// the robot counts as stopped under this fraction of its slowest speed
+#define PLANT_STOPPED 0.05
+// longest we'll let it coast after stopping (seconds)
+#define PLANT_MAX_COAST 3.0
+
+/* cost */
+// a loop that hasn't finished after this many passes has failed
+#define MAX_PASSES 150
+#define TIMEOUT_COST 60.0
+// seconds of cost per cm and per radian of overshoot
+#define MOVE_OVERSHOOT_COST 0.2
+#define TURN_OVERSHOOT_COST 10.0
+// runs of each start with different noise
+#define NUM_SEEDS 4
+
+/* relay test */
+#define RELAY_GAIN 0.5
+#define RELAY_PASSES 200
+// zero crossings to skip while it settles into oscillating
+#define RELAY_SKIP 4
+
+/* search */
+#define DEFAULT_THREADS 4
+#define DEFAULT_ITERATIONS 80
+#define NUM_PARAMS 3
+
+// distances (cm) and angles (radians) the loops start from
+const float MOVE_STARTS[] = {40.0, 65.0, 90.0, 130.0};
+const float TURN_STARTS[] = {DEGREE_30, -DEGREE_30, DEGREE_90, -DEGREE_90,
+                             DEGREE_150, -DEGREE_150};
+#define NUM_MOVE_STARTS (int)(sizeof(MOVE_STARTS) / sizeof(float))
+#define NUM_TURN_STARTS (int)(sizeof(TURN_STARTS) / sizeof(float))
+
+struct Plant {
+	// cm per second at each robot speed
+	float forward[NUM_SPEEDS];
+	// radians per second at each robot speed, left then right
+	float turn[NUM_SPEEDS][2];
+};
+
+struct Result {
+	float settle;
+	float overshoot;
+	float finalError;
+	int passes;
+	bool timedOut;
+};
+
+struct Summary {
+	float cost;
+	float meanSettle;
+	float worstSettle;
+	float meanOvershoot;
+	float worstOverShoot;
+	float meanPasses;
+	int timeouts;
+};
+
+struct TuneJob {
+	Plant *plant;
+	int loop;
+	float start[NUM_PARAMS];
+	int iterations;
+	float best[NUM_PARAMS];
+	float bestCost;
+	int evaluations;
+};
+
+void usage(char *name) {
+	printf("usage: %s [options]\n", name);
+	printf("  -l move|turn|both  which PID to tune (default both)\n");
+	printf("  -s file            measured speeds (like data/speeds.txt) instead\n");
+	printf("                     of the tables in constants.h\n");
+	printf("  -t threads         parallel searches (default %d)\n", DEFAULT_THREADS);
+	printf("  -n iterations      iterations per search (default %d)\n", DEFAULT_ITERATIONS);
+	printf("  -h                 print this message\n");
+	exit(1);
+}
+
+/**************************************
+ * Definition: Fills the plant's speeds from the tables in constants.h
+ *
+ * Parameters: the plant
+ **************************************/
+void defaultSpeeds(Plant *plant) {
+	for (int s = 0; s < NUM_SPEEDS; s++) {
+		plant->forward[s] = SPEED_FORWARD[s];
+		plant->turn[s][TURN_LEFT] = SPEED_TURN[s][TURN_LEFT];
+		plant->turn[s][TURN_RIGHT] = SPEED_TURN[s][TURN_RIGHT];
+	}
+}
+
+/**************************************
+ * Definition: Reads measured speeds in the format of data/speeds.txt:
+ *             a "forward" section with seconds per 1.16 m and "turn
+ *             right"/"turn left" sections with seconds per turn, each
+ *             line "speed ==> seconds". Speeds the file doesn't have
+ *             keep their old values
+ *
+ * Parameters: the file name and the plant
+ *
+ * Returns:    how many speeds were read
+ **************************************/
+int loadSpeeds(std::string fileName, Plant *plant) {
+	std::ifstream f(fileName.c_str());
+	std::string line;
+	int section = -1;
+	int count = 0;
+	while (std::getline(f, line)) {
+		if (line.find("forward") == 0) {
+			section = 0;
+		}
+		else if (line.find("turn right") == 0) {
+			section = 1;
+		}
+		else if (line.find("turn left") == 0) {
+			section = 2;
+		}
+
+		int speed;
+		float seconds;
+		if (section < 0 ||
+		    sscanf(line.c_str(), "%d ==> %f", &speed, &seconds) != 2 ||
+		    speed < 1 || speed >= NUM_SPEEDS || seconds <= 0) {
+			continue;
+		}
+		if (section == 0) {
+			plant->forward[speed] = TIME_DISTANCE / seconds;
+		}
+		else if (section == 1) {
+			plant->turn[speed][TURN_RIGHT] = -(2 * PI) / seconds;
+		}
+		else {
+			plant->turn[speed][TURN_LEFT] = (2 * PI) / seconds;
+		}
+		count++;
+	}
+	return count;
+}
+
+/**************************************
+ * Definition: Returns normally distributed noise
+ *
+ * Parameters: the standard deviation and the random state
+ *
+ * Returns:    a float
+ **************************************/
+float noise(float sigma, unsigned int *seed) {
+	float u1 = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+	float u2 = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+	return sigma * sqrt(-2 * log(u1)) * cos(2 * PI * u2);
+}
+
+/**************************************
+ * Definition: Turns a PID gain into a robot speed the way the move
+ *             and turn loops do
+ *
+ * Parameters: the gain
+ *
+ * Returns:    an int speed from 1 to 10
+ **************************************/
+int speedFor(float gain) {
+	return Util::capSpeed((int)(10 - 9 * gain), 10);
+}
+
+/**************************************
+ * Definition: Runs the plant toward a speed for a while
+ *
+ * Parameters: the position and velocity to update, the speed it's
+ *             heading for, how long, the goal position and which
+ *             side of it we started on, the largest overshoot so far,
+ *             and the clock
+ **************************************/
+void advance(float *position, float *velocity, float target, float seconds,
+             float goal, float side, float *overshoot, float *time) {
+	int steps = (int)ceil(seconds / CONTROL_LOOP_PERIOD * PLANT_SUBSTEPS);
+	if (steps <= 0) {
+		return;
+	}
+	float h = seconds / steps;
+	for (int i = 0; i < steps; i++) {
+		*velocity += (target - *velocity) * (1 - exp(-h / PLANT_LAG));
+		*position += *velocity * h;
+		float past = (*position - goal) * side;
+		if (past > *overshoot) {
+			*overshoot = past;
+		}
+	}
+	*time += seconds;
+}
+
+/**************************************
+ * Definition: Lets the plant coast to a stop
+ *
+ * Parameters: as for advance, plus the speed that counts as stopped
+ **************************************/
+void coast(float *position, float *velocity, float goal, float side,
+           float *overshoot, float *time, float stopped) {
+	float coasted = 0;
+	while (fabs(*velocity) > stopped && coasted < PLANT_MAX_COAST) {
+		advance(position, velocity, 0, CONTROL_LOOP_PERIOD, goal, side, overshoot, time);
+		coasted += CONTROL_LOOP_PERIOD;
+	}
+}
+
+/**************************************
+ * Definition: Simulates Robot::moveToUntil driving toward a point
+ *             straight ahead, then stopping
+ *
+ * Parameters: the plant, the gains, how far away the point starts,
+ *             a noise seed, and where to put the result
+ **************************************/
+void simulateMove(Plant *plant, PIDConstants *constants, float distance,
+                  unsigned int seed, Result *result) {
+	PID pid(constants, MIN_MOVE_ERROR, MAX_MOVE_ERROR);
+	pid.setFeedForward(plant->forward, 1);
+
+	float position = 0;
+	float velocity = 0;
+	float time = 0;
+	float overshoot = 0;
+	float past[PLANT_DELAY + 1];
+	for (int i = 0; i <= PLANT_DELAY; i++) {
+		past[i] = position;
+	}
+
+	result->timedOut = false;
+	result->passes = 0;
+	while (true) {
+		float measured = past[PLANT_DELAY] + noise(PLANT_NOISE_CM, &seed);
+		float distError = fabs(distance - measured);
+		if (distError <= MAX_DIST_ERROR) {
+			break;
+		}
+		if (result->passes >= MAX_PASSES) {
+			result->timedOut = true;
+			break;
+		}
+
+		float gain = pid.updatePID(distError, CONTROL_LOOP_PERIOD,
+		                           distError / PID_MOVE_FF_TIME);
+		advance(&position, &velocity, plant->forward[speedFor(gain)],
+		        CONTROL_LOOP_PERIOD, distance, 1, &overshoot, &time);
+		result->passes++;
+
+		for (int i = PLANT_DELAY; i > 0; i--) {
+			past[i] = past[i - 1];
+		}
+		past[0] = position;
+	}
+
+	coast(&position, &velocity, distance, 1, &overshoot, &time,
+	      PLANT_STOPPED * plant->forward[NUM_SPEEDS - 1]);
+
+	result->settle = time;
+	result->overshoot = overshoot;
+	result->finalError = fabs(distance - position);
+}
+
+/**************************************
+ * Definition: Simulates Robot::turnTo turning back to heading 0.
+ *             Each turn command is a short pulse, and a pass takes
+ *             the longer of the pulse and the control period
+ *
+ * Parameters: the plant, the gains, the heading to start at, a noise
+ *             seed, and where to put the result
+ **************************************/
+void simulateTurn(Plant *plant, PIDConstants *constants, float heading,
+                  unsigned int seed, Result *result) {
+	PID pid(constants, MIN_TURN_ERROR, MAX_TURN_ERROR);
+
+	float velocity = 0;
+	float time = 0;
+	float overshoot = 0;
+	// which side of the goal we start on
+	float side = (heading > 0) ? -1 : 1;
+	float dt = CONTROL_LOOP_PERIOD;
+	int lastDirection = -1;
+	float past[PLANT_DELAY + 1];
+	for (int i = 0; i <= PLANT_DELAY; i++) {
+		past[i] = heading;
+	}
+
+	result->timedOut = false;
+	result->passes = 0;
+	while (true) {
+		float measured = past[PLANT_DELAY] + noise(PLANT_NOISE_RAD, &seed);
+		float thetaError = Util::normalizeThetaError(-measured);
+		if (fabs(thetaError) <= MAX_THETA_ERROR) {
+			break;
+		}
+		if (result->passes >= MAX_PASSES) {
+			result->timedOut = true;
+			break;
+		}
+
+		int direction = (thetaError < 0) ? TURN_RIGHT : TURN_LEFT;
+		// turnTo starts the PID over when it turns back the other way
+		if (direction != lastDirection) {
+			pid.flushPID();
+			lastDirection = direction;
+		}
+		pid.setFeedForward(&plant->turn[0][direction], 2);
+		float gain = pid.updatePID(fabs(thetaError), dt,
+		                           thetaError / PID_TURN_FF_TIME);
+		int speed = speedFor(gain);
+
+		// the same pulse Robot::_turnPulse picks for this speed
+		float pulse = TURN_PULSE_LENGTH;
+		if (speed > TURN_PULSE_SPEED) {
+			pulse -= TURN_PULSE_STEP * (speed - TURN_PULSE_SPEED);
+			speed = TURN_PULSE_SPEED;
+		}
+		advance(&heading, &velocity, plant->turn[speed][direction], pulse,
+		        0, side, &overshoot, &time);
+		dt = pulse;
+		if (pulse < CONTROL_LOOP_PERIOD) {
+			advance(&heading, &velocity, 0, CONTROL_LOOP_PERIOD - pulse,
+			        0, side, &overshoot, &time);
+			dt = CONTROL_LOOP_PERIOD;
+		}
+		result->passes++;
+
+		for (int i = PLANT_DELAY; i > 0; i--) {
+			past[i] = past[i - 1];
+		}
+		past[0] = heading;
+	}
+
+	float slowest = fmin(fabs(plant->turn[NUM_SPEEDS - 1][TURN_LEFT]),
+	                     fabs(plant->turn[NUM_SPEEDS - 1][TURN_RIGHT]));
+	coast(&heading, &velocity, 0, side, &overshoot, &time,
+	      PLANT_STOPPED * slowest);
+
+	result->settle = time;
+	result->overshoot = overshoot;
+	result->finalError = fabs(heading);
+}
+
+/**************************************
+ * Definition: Runs a loop from every start with every noise seed
+ *             and sums up how it did
+ *
+ * Parameters: the plant, which loop, the gains (negative gains are
+ *             taken as positive), and where to put the summary
+ **************************************/
+void evaluate(Plant *plant, int loop, const float *gains, Summary *summary) {
+	PIDConstants constants = {fabs(gains[0]), fabs(gains[1]), fabs(gains[2])};
+	int numStarts = (loop == LOOP_MOVE) ? NUM_MOVE_STARTS : NUM_TURN_STARTS;
+	float overshootCost = (loop == LOOP_MOVE) ? MOVE_OVERSHOOT_COST : TURN_OVERSHOOT_COST;
+
+	summary->cost = 0;
+	summary->meanSettle = 0;
+	summary->worstSettle = 0;
+	summary->meanOvershoot = 0;
+	summary->worstOverShoot = 0;
+	summary->meanPasses = 0;
+	summary->timeouts = 0;
+
+	int runs = 0;
+	for (int i = 0; i < numStarts; i++) {
+		for (int s = 0; s < NUM_SEEDS; s++) {
+			// the same noise for every set of gains
+			unsigned int seed = 1567 + 100 * i + s;
+			Result result;
+			if (loop == LOOP_MOVE) {
+				simulateMove(plant, &constants, MOVE_STARTS[i], seed, &result);
+			}
+			else {
+				simulateTurn(plant, &constants, TURN_STARTS[i], seed, &result);
+			}
+
+			summary->cost += result.settle + overshootCost * result.overshoot;
+			if (result.timedOut) {
+				summary->cost += TIMEOUT_COST;
+				summary->timeouts++;
+			}
+			summary->meanSettle += result.settle;
+			summary->worstSettle = fmax(summary->worstSettle, result.settle);
+			summary->meanOvershoot += result.overshoot;
+			summary->worstOverShoot = fmax(summary->worstOverShoot, result.overshoot);
+			summary->meanPasses += result.passes;
+			runs++;
+		}
+	}
+	summary->cost /= runs;
+	summary->meanSettle /= runs;
+	summary->meanOvershoot /= runs;
+	summary->meanPasses /= runs;
+}
+
+/**************************************
+ * Definition: Runs a relay test: full steam one way at RELAY_GAIN
+ *             while the (late) error is positive, the other way while
+ *             it's negative, and measures the oscillation that sets
+ *             up. The Ziegler-Nichols rules turn the ultimate gain
+ *             and period into PID gains in our units (the integral
+ *             in error periods and the derivative per period)
+ *
+ * Parameters: the plant, which loop, and where to put the gains
+ *
+ * Returns:    false if the plant never oscillated
+ **************************************/
+bool relayTune(Plant *plant, int loop, float *gains) {
+	float position = (loop == LOOP_MOVE) ? -MOVE_STARTS[0] : TURN_STARTS[0];
+	float velocity = 0;
+	float time = 0;
+	float overshoot = 0;
+	float past[PLANT_DELAY + 1];
+	for (int i = 0; i <= PLANT_DELAY; i++) {
+		past[i] = position;
+	}
+
+	int crossings = 0;
+	float firstCrossing = 0;
+	float lastCrossing = 0;
+	float highest = 0;
+	float lowest = 0;
+	float lastError = 0;
+	int speed = speedFor(RELAY_GAIN);
+
+	for (int pass = 0; pass < RELAY_PASSES; pass++) {
+		float error = -past[PLANT_DELAY];
+		if (pass > 0 && (error > 0) != (lastError > 0)) {
+			crossings++;
+			if (crossings == RELAY_SKIP) {
+				firstCrossing = time;
+				highest = error;
+				lowest = error;
+			}
+			lastCrossing = time;
+		}
+		if (crossings >= RELAY_SKIP) {
+			highest = fmax(highest, error);
+			lowest = fmin(lowest, error);
+		}
+		lastError = error;
+
+		float target;
+		if (loop == LOOP_MOVE) {
+			target = (error > 0) ? plant->forward[speed] : -plant->forward[speed];
+		}
+		else {
+			target = plant->turn[speed][(error > 0) ? TURN_LEFT : TURN_RIGHT];
+		}
+		advance(&position, &velocity, target, CONTROL_LOOP_PERIOD,
+		        0, 1, &overshoot, &time);
+
+		for (int i = PLANT_DELAY; i > 0; i--) {
+			past[i] = past[i - 1];
+		}
+		past[0] = position;
+	}
+
+	int cycles = crossings - RELAY_SKIP;
+	float amplitude = (highest - lowest) / 2;
+	if (cycles < 2 || amplitude <= 0) {
+		return false;
+	}
+	// two crossings per cycle
+	float period = 2 * (lastCrossing - firstCrossing) / cycles;
+	float ultimateGain = 4 * RELAY_GAIN / (PI * amplitude);
+	printf("relay test: amplitude %f, period %f s, ultimate gain %f\n",
+	       amplitude, period, ultimateGain);
+
+	float kp = 0.6 * ultimateGain;
+	float integralTime = period / 2;
+	float derivativeTime = period / 8;
+	gains[0] = kp;
+	gains[1] = kp * CONTROL_LOOP_PERIOD / integralTime;
+	gains[2] = kp * derivativeTime / CONTROL_LOOP_PERIOD;
+	return true;
+}
+
+/**************************************
+ * Definition: Minimizes the cost of a loop's gains with the
+ *             Nelder-Mead simplex method, starting from the job's
+ *             gains
+ *
+ * Parameters: the job (a TuneJob), which gets the best gains
+ **************************************/
+void *nelderMead(void *tuneJob) {
+	TuneJob *job = (TuneJob *)tuneJob;
+	const int n = NUM_PARAMS;
+	float simplex[n + 1][NUM_PARAMS];
+	float cost[n + 1];
+	Summary summary;
+
+	for (int v = 0; v <= n; v++) {
+		for (int p = 0; p < n; p++) {
+			simplex[v][p] = job->start[p];
+		}
+		if (v > 0) {
+			float step = 0.5 * fabs(job->start[v - 1]);
+			simplex[v][v - 1] += (step > 0.01) ? step : 0.05;
+		}
+		evaluate(job->plant, job->loop, simplex[v], &summary);
+		cost[v] = summary.cost;
+	}
+	job->evaluations = n + 1;
+
+	for (int iteration = 0; iteration < job->iterations; iteration++) {
+		// order the vertices best to worst
+		for (int i = 1; i <= n; i++) {
+			for (int j = i; j > 0 && cost[j] < cost[j - 1]; j--) {
+				float c = cost[j];
+				cost[j] = cost[j - 1];
+				cost[j - 1] = c;
+				for (int p = 0; p < n; p++) {
+					float g = simplex[j][p];
+					simplex[j][p] = simplex[j - 1][p];
+					simplex[j - 1][p] = g;
+				}
+			}
+		}
+
+		float centroid[NUM_PARAMS];
+		for (int p = 0; p < n; p++) {
+			centroid[p] = 0;
+			for (int v = 0; v < n; v++) {
+				centroid[p] += simplex[v][p] / n;
+			}
+		}
+
+		float reflected[NUM_PARAMS];
+		for (int p = 0; p < n; p++) {
+			reflected[p] = centroid[p] + (centroid[p] - simplex[n][p]);
+		}
+		evaluate(job->plant, job->loop, reflected, &summary);
+		float reflectedCost = summary.cost;
+		job->evaluations++;
+
+		float *replacement = NULL;
+		float replacementCost = 0;
+		float candidate[NUM_PARAMS];
+
+		if (reflectedCost < cost[0]) {
+			// try going further the same way
+			for (int p = 0; p < n; p++) {
+				candidate[p] = centroid[p] + 2 * (centroid[p] - simplex[n][p]);
+			}
+			evaluate(job->plant, job->loop, candidate, &summary);
+			job->evaluations++;
+			if (summary.cost < reflectedCost) {
+				replacement = candidate;
+				replacementCost = summary.cost;
+			}
+			else {
+				replacement = reflected;
+				replacementCost = reflectedCost;
+			}
+		}
+		else if (reflectedCost < cost[n - 1]) {
+			replacement = reflected;
+			replacementCost = reflectedCost;
+		}
+		else {
+			// contract toward the centroid
+			for (int p = 0; p < n; p++) {
+				candidate[p] = centroid[p] + 0.5 * (simplex[n][p] - centroid[p]);
+			}
+			evaluate(job->plant, job->loop, candidate, &summary);
+			job->evaluations++;
+			if (summary.cost < cost[n]) {
+				replacement = candidate;
+				replacementCost = summary.cost;
+			}
+		}
+
+		if (replacement != NULL) {
+			for (int p = 0; p < n; p++) {
+				simplex[n][p] = replacement[p];
+			}
+			cost[n] = replacementCost;
+		}
+		else {
+			// shrink everything toward the best
+			for (int v = 1; v <= n; v++) {
+				for (int p = 0; p < n; p++) {
+					simplex[v][p] = simplex[0][p] + 0.5 * (simplex[v][p] - simplex[0][p]);
+				}
+				evaluate(job->plant, job->loop, simplex[v], &summary);
+				cost[v] = summary.cost;
+				job->evaluations++;
+			}
+		}
+	}
+
+	int best = 0;
+	for (int v = 1; v <= n; v++) {
+		if (cost[v] < cost[best]) {
+			best = v;
+		}
+	}
+	for (int p = 0; p < n; p++) {
+		job->best[p] = fabs(simplex[best][p]);
+	}
+	job->bestCost = cost[best];
+	return NULL;
+}
+
+/**************************************
+ * Definition: Prints how a set of gains does on the plant
+ *
+ * Parameters: a label, the plant, which loop, and the gains
+ **************************************/
+void report(const char *label, Plant *plant, int loop, const float *gains) {
+	Summary summary;
+	evaluate(plant, loop, gains, &summary);
+	const char *units = (loop == LOOP_MOVE) ? "cm" : "rad";
+	printf("%-10s kp %.4f ki %.4f kd %.4f\n", label, gains[0], gains[1], gains[2]);
+	printf("           settle %.2f s (worst %.2f), overshoot %.3f %s (worst %.3f), "
+	       "%.1f passes, %d timeouts, cost %.3f\n",
+	       summary.meanSettle, summary.worstSettle, summary.meanOvershoot, units,
+	       summary.worstOverShoot, summary.meanPasses, summary.timeouts, summary.cost);
+}
+
+/**************************************
+ * Definition: Tunes one loop's PID and prints the results
+ *
+ * Parameters: the plant, which loop, and how many searches
+ *             and iterations to run
+ **************************************/
+void tune(Plant *plant, int loop, int threads, int iterations) {
+	const char *name = (loop == LOOP_MOVE) ? "MOVE" : "TURN";
+	float current[NUM_PARAMS];
+	if (loop == LOOP_MOVE) {
+		current[0] = PID_MOVE_KP;
+		current[1] = PID_MOVE_KI;
+		current[2] = PID_MOVE_KD;
+	}
+	else {
+		current[0] = PID_TURN_KP;
+		current[1] = PID_TURN_KI;
+		current[2] = PID_TURN_KD;
+	}
+
+	printf("\n%s PID\n", name);
+	float guess[NUM_PARAMS];
+	if (!relayTune(plant, loop, guess)) {
+		printf("relay test didn't oscillate, starting from the current gains\n");
+		for (int p = 0; p < NUM_PARAMS; p++) {
+			guess[p] = current[p];
+		}
+	}
+
+	// search from the guess, half of it, twice it, a quarter...
+	TuneJob *jobs = new TuneJob[threads];
+	pthread_t *ids = new pthread_t[threads];
+	for (int t = 0; t < threads; t++) {
+		float scale = pow(2.0, ((t + 1) / 2) * ((t % 2) ? -1 : 1));
+		jobs[t].plant = plant;
+		jobs[t].loop = loop;
+		jobs[t].iterations = iterations;
+		for (int p = 0; p < NUM_PARAMS; p++) {
+			jobs[t].start[p] = guess[p] * scale;
+		}
+		if (pthread_create(&ids[t], NULL, nelderMead, &jobs[t]) != 0) {
+			// do it here instead
+			nelderMead(&jobs[t]);
+			ids[t] = pthread_self();
+		}
+	}
+
+	int best = 0;
+	int evaluations = 0;
+	for (int t = 0; t < threads; t++) {
+		if (!pthread_equal(ids[t], pthread_self())) {
+			pthread_join(ids[t], NULL);
+		}
+		evaluations += jobs[t].evaluations;
+		if (jobs[t].bestCost < jobs[best].bestCost) {
+			best = t;
+		}
+	}
+	printf("%d searches, %d evaluations\n", threads, evaluations);
+
+	report("current", plant, loop, current);
+	report("relay/ZN", plant, loop, guess);
+	report("tuned", plant, loop, jobs[best].best);
+
+	printf("#define PID_%s_KP %.4f\n", name, jobs[best].best[0]);
+	printf("#define PID_%s_KI %.4f\n", name, jobs[best].best[1]);
+	printf("#define PID_%s_KD %.4f\n", name, jobs[best].best[2]);
+
+	delete[] jobs;
+	delete[] ids;
+}
+
+int main(int argc, char *argv[]) {
+	std::string loops("both");
+	std::string speedsName;
+	int threads = DEFAULT_THREADS;
+	int iterations = DEFAULT_ITERATIONS;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:s:t:n:h")) != -1) {
+		switch (opt) {
+		case 'l': loops = optarg; break;
+		case 's': speedsName = optarg; break;
+		case 't': threads = atoi(optarg); break;
+		case 'n': iterations = atoi(optarg); break;
+		case 'h': usage(argv[0]); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (threads < 1 || iterations < 0 ||
+	    (loops != "move" && loops != "turn" && loops != "both")) {
+		usage(argv[0]);
+	}
+
+	Plant plant;
+	defaultSpeeds(&plant);
+	if (!speedsName.empty()) {
+		int count = loadSpeeds(speedsName, &plant);
+		if (count == 0) {
+			printf("couldn't read any speeds from %s\n", speedsName.c_str());
+			return 1;
+		}
+		printf("read %d speeds from %s\n", count, speedsName.c_str());
+	}
+
+	if (loops != "turn") {
+		tune(&plant, LOOP_MOVE, threads, iterations);
+	}
+	if (loops != "move") {
+		tune(&plant, LOOP_TURN, threads, iterations);
+	}
+	return 0;
+}
@@ -0,0 +1,341 @@
+/**
+ * extended_kalman_filter.cpp
+ *
+ * @brief
+ * 		This class is an extended Kalman filter that fuses the north star
+ *      and wheel encoder poses using a nonlinear motion model. Velocities
+ *      are given in the robot's frame and rotated by the estimated theta
+ *      on every prediction, and all theta math is wrapped properly.
+ *      It can be used anywhere a KalmanFilter is expected.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include "extended_kalman_filter.h"
+#include "utilities.h"
+#include "constants.h"
+#include <math.h>
+#include <string.h>
+
+#define RC(i, j) ((i) * EKF_SIZE + (j))
+
+ExtendedKalmanFilter::ExtendedKalmanFilter(Pose *initialPose)
+: KalmanFilter(initialPose), _deltaT(0), _hasFiltered(false) {
+	// start the state at the given pose, standing still
+	initialPose->toArray(_state);
+	_control[0] = 0;
+	_control[1] = 0;
+	_control[2] = 0;
+
+	// we trust the initial pose about as much as one model step
+	memset(_covariance, 0, sizeof(_covariance));
+	for (int i = 0; i < EKF_SIZE; i++) {
+		_covariance[RC(i, i)] = _uncertainties[i];
+	}
+
+	// until the first prediction, the prediction is the start
+	memcpy(_predictedState, _state, sizeof(_state));
+	memcpy(_predictedCovariance, _covariance, sizeof(_covariance));
+	memset(_jacobian, 0, sizeof(_jacobian));
+	for (int i = 0; i < EKF_SIZE; i++) {
+		_jacobian[RC(i, i)] = 1;
+	}
+
+	memset(&_health, 0, sizeof(_health));
+}
+
+ExtendedKalmanFilter::~ExtendedKalmanFilter() {}
+
+/**************************************
+ * Definition: Predicts forward to now and then corrects with the
+ *             north star and wheel encoder poses, updating the
+ *             stored pose with the new estimate
+ *
+ * Parameters: a North Star pose and a Wheel Encoders Pose
+ **************************************/
+void ExtendedKalmanFilter::filter(Pose *nsPose, Pose *wePose) {
+	float dt = _elapsedTime();
+	if (_deltaT > 0) {
+		// an explicit time step overrides the measured one
+		dt = _deltaT;
+		_deltaT = 0;
+	}
+	predict(dt);
+
+	float nsPoseArr[3];
+	float wePoseArr[3];
+	nsPose->toArray(nsPoseArr);
+	wePose->toArray(wePoseArr);
+
+	correct(nsPoseArr, &_uncertainties[3]);
+	correct(wePoseArr, &_uncertainties[6]);
+	_checkHealth();
+
+	// update the stored pose to its new estimate
+	_pose->setX(_state[0]);
+	_pose->setY(_state[1]);
+	_pose->setTheta(_state[2]);
+}
+
+/**************************************
+ * Definition: Sets the velocity from global x and y speeds by
+ *             rotating them into the robot's frame
+ *
+ * Parameters: x, y, and theta speeds as floats
+ **************************************/
+void ExtendedKalmanFilter::setVelocity(float x, float y, float theta) {
+	float heading = _state[2];
+	float forward = x * cos(heading) + y * sin(heading);
+	float strafe = -x * sin(heading) + y * cos(heading);
+
+	setBodyVelocity(forward, strafe, theta);
+}
+
+/**************************************
+ * Definition: Sets the velocity used by the motion model, in the
+ *             robot's frame
+ *
+ * Parameters: forward (cm/s), strafe left (cm/s), and theta (rad/s)
+ *             speeds as floats
+ **************************************/
+void ExtendedKalmanFilter::setBodyVelocity(float forward, float strafe, float theta) {
+	_control[0] = forward;
+	_control[1] = strafe;
+	_control[2] = theta;
+}
+
+/**************************************
+ * Definition: Forces the time step (in seconds) used by the next
+ *             call to filter, instead of the measured one
+ *
+ * Parameters: time step as a float
+ **************************************/
+void ExtendedKalmanFilter::setTimeStep(float dt) {
+	_deltaT = dt;
+}
+
+/**************************************
+ * Definition: Propagates the state and covariance dt seconds forward
+ *             with the current velocity
+ *
+ * Parameters: time step in seconds as a float
+ **************************************/
+void ExtendedKalmanFilter::predict(float dt) {
+	float forward = _control[0];
+	float strafe = _control[1];
+
+	// rotate by the heading halfway through the step so
+	// moving while turning follows the arc more closely
+	float heading = _state[2] + _control[2] * dt / 2.0;
+	float c = cos(heading);
+	float s = sin(heading);
+
+	_state[0] += (forward * c - strafe * s) * dt;
+	_state[1] += (forward * s + strafe * c) * dt;
+	_state[2] = Util::normalizeTheta(_state[2] + _control[2] * dt);
+
+	// jacobian of the motion model with respect to the state
+	kfcov *F = _jacobian;
+	memset(F, 0, sizeof(_jacobian));
+	F[RC(0, 0)] = 1;
+	F[RC(1, 1)] = 1;
+	F[RC(2, 2)] = 1;
+	F[RC(0, 2)] = (-forward * s - strafe * c) * dt;
+	F[RC(1, 2)] = (forward * c - strafe * s) * dt;
+
+	// P = F * P * F' + Q, with Q (given per EKF_DEFAULT_DT step)
+	// scaled to how long this step actually was
+	kfcov temp[EKF_SIZE * EKF_SIZE];
+	multiply3(F, _covariance, temp, false);
+	multiply3(temp, F, _covariance, true);
+	float noiseScale = dt / EKF_DEFAULT_DT;
+	for (int i = 0; i < EKF_SIZE; i++) {
+		_covariance[RC(i, i)] += _uncertainties[i] * noiseScale;
+	}
+
+	memcpy(_predictedState, _state, sizeof(_state));
+	memcpy(_predictedCovariance, _covariance, sizeof(_covariance));
+}
+
+/**************************************
+ * Definition: Corrects the state with a direct pose measurement
+ *
+ * Parameters: 3-element measurement (x, y, theta) and
+ *             3-element measurement noise array
+ **************************************/
+void ExtendedKalmanFilter::correct(float *measurement, float *noise) {
+	float residual[EKF_SIZE];
+	for (int i = 0; i < EKF_SIZE; i++) {
+		residual[i] = measurement[i] - _state[i];
+	}
+	// 0 and 2PI are the same heading
+	residual[2] = Util::normalizeThetaError(residual[2]);
+
+	// S = P + R
+	kfcov innovation[EKF_SIZE * EKF_SIZE];
+	memcpy(innovation, _covariance, sizeof(innovation));
+	for (int i = 0; i < EKF_SIZE; i++) {
+		innovation[RC(i, i)] += noise[i];
+	}
+
+	kfcov innovationInv[EKF_SIZE * EKF_SIZE];
+	if (!invert3(innovation, innovationInv)) {
+		// nothing sensible to do with this measurement
+		_health.inversionFailures++;
+		return;
+	}
+
+	// K = P * S^-1
+	kfcov gain[EKF_SIZE * EKF_SIZE];
+	multiply3(_covariance, innovationInv, gain, false);
+
+	for (int i = 0; i < EKF_SIZE; i++) {
+		for (int j = 0; j < EKF_SIZE; j++) {
+			_state[i] += gain[RC(i, j)] * residual[j];
+		}
+	}
+	_state[2] = Util::normalizeTheta(_state[2]);
+
+	// P = (I - K) * P * (I - K)' + K * R * K' keeps P symmetric
+	kfcov IminusK[EKF_SIZE * EKF_SIZE];
+	for (int i = 0; i < EKF_SIZE * EKF_SIZE; i++) {
+		IminusK[i] = -gain[i];
+	}
+	for (int i = 0; i < EKF_SIZE; i++) {
+		IminusK[RC(i, i)] += 1;
+	}
+
+	kfcov temp[EKF_SIZE * EKF_SIZE];
+	multiply3(IminusK, _covariance, temp, false);
+	multiply3(temp, IminusK, _covariance, true);
+	for (int i = 0; i < EKF_SIZE; i++) {
+		for (int j = 0; j < EKF_SIZE; j++) {
+			kfcov sum = 0;
+			for (int k = 0; k < EKF_SIZE; k++) {
+				sum += gain[RC(i, k)] * noise[k] * gain[RC(j, k)];
+			}
+			_covariance[RC(i, j)] += sum;
+		}
+	}
+}
+
+/**************************************
+ * Definition: Copies the current state (x, y, theta)
+ *
+ * Parameters: 3-element array to copy into
+ **************************************/
+void ExtendedKalmanFilter::getState(float *state) {
+	memcpy(state, _state, sizeof(_state));
+}
+
+/**************************************
+ * Definition: Copies the current 3x3 covariance (row major)
+ *
+ * Parameters: 9-element array to copy into
+ **************************************/
+void ExtendedKalmanFilter::getCovariance(float *covariance) {
+	for (int i = 0; i < EKF_SIZE * EKF_SIZE; i++) {
+		covariance[i] = _covariance[i];
+	}
+}
+
+/**************************************
+ * Definition: Copies the state and covariance from the last
+ *             prediction (before it was corrected), along with the
+ *             jacobian used to make it. A smoother needs all three
+ *
+ * Parameters: 3-element state array, 9-element covariance array,
+ *             and 9-element jacobian array to copy into
+ **************************************/
+void ExtendedKalmanFilter::getPrediction(float *state, float *covariance, float *jacobian) {
+	memcpy(state, _predictedState, sizeof(_predictedState));
+	for (int i = 0; i < EKF_SIZE * EKF_SIZE; i++) {
+		covariance[i] = _predictedCovariance[i];
+		jacobian[i] = _jacobian[i];
+	}
+}
+
+/**************************************
+ * Definition: Copies out counters describing the numerical health
+ *             of the covariance
+ *
+ * Parameters: pointer to a kalmanHealth struct to fill
+ **************************************/
+void ExtendedKalmanFilter::getHealth(kalmanHealth *health) {
+	*health = _health;
+}
+
+/**************************************
+ * Definition: Symmetrizes the covariance and makes sure it is still
+ *             positive semi-definite (every leading minor >= 0),
+ *             resetting it to its clamped diagonal if not
+ **************************************/
+void ExtendedKalmanFilter::_checkHealth() {
+	_health.steps++;
+
+	kfcov scale = 0;
+	for (int i = 0; i < EKF_SIZE; i++) {
+		scale = fmax(scale, fabs(_covariance[RC(i, i)]));
+	}
+
+	kfcov asymmetry = 0;
+	for (int i = 0; i < EKF_SIZE; i++) {
+		for (int j = i+1; j < EKF_SIZE; j++) {
+			kfcov average = (_covariance[RC(i, j)] + _covariance[RC(j, i)]) / 2.0;
+			asymmetry = fmax(asymmetry, fabs(_covariance[RC(i, j)] - average));
+			_covariance[RC(i, j)] = average;
+			_covariance[RC(j, i)] = average;
+		}
+	}
+	if (asymmetry > SYMMETRY_TOLERANCE * scale) {
+		_health.asymmetryRepairs++;
+	}
+
+	kfcov *P = _covariance;
+	kfcov tolerance = -DEFINITENESS_TOLERANCE * scale;
+	kfcov minor1 = P[0];
+	kfcov minor2 = P[0] * P[4] - P[1] * P[3];
+	kfcov minor3 = P[0] * (P[4] * P[8] - P[5] * P[7]) -
+	               P[1] * (P[3] * P[8] - P[5] * P[6]) +
+	               P[2] * (P[3] * P[7] - P[4] * P[6]);
+	if (minor1 < tolerance || P[4] < tolerance || P[8] < tolerance ||
+	    minor2 < tolerance * scale || minor3 < tolerance * scale * scale) {
+		_health.definitenessRepairs++;
+		for (int i = 0; i < EKF_SIZE; i++) {
+			for (int j = 0; j < EKF_SIZE; j++) {
+				if (i != j) {
+					_covariance[RC(i, j)] = 0;
+				}
+				else if (_covariance[RC(i, i)] < 0) {
+					_covariance[RC(i, i)] = 0;
+				}
+			}
+		}
+	}
+}
+
+/**************************************
+ * Definition: Returns the time since the last call, capped so
+ *             a long pause doesn't throw the prediction away
+ *
+ * Returns:    elapsed seconds as a float
+ **************************************/
+float ExtendedKalmanFilter::_elapsedTime() {
+	float elapsed = Util::elapsedSeconds(&_lastFilterTime);
+	if (!_hasFiltered) {
+		elapsed = EKF_DEFAULT_DT;
+		_hasFiltered = true;
+	}
+
+	if (elapsed > EKF_MAX_DT) {
+		elapsed = EKF_MAX_DT;
+	}
+	else if (elapsed < 0) {
+		elapsed = 0;
+	}
+	return elapsed;
+}
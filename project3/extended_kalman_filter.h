@@ -0,0 +1,117 @@
+/**
+ * extended_kalman_filter.h
+ *
+ * @brief
+ * 		This class is an extended Kalman filter that fuses the north star
+ *      and wheel encoder poses using a nonlinear motion model. Velocities
+ *      are given in the robot's frame and rotated by the estimated theta
+ *      on every prediction, and all theta math is wrapped properly.
+ *      It can be used anywhere a KalmanFilter is expected.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_EXTENDEDKALMANFILTER_H
+#define CS1567_EXTENDEDKALMANFILTER_H
+
+#include "kalman_filter.h"
+#include <math.h>
+#include <sys/time.h>
+
+// the filter state is x, y, and theta
+#define EKF_SIZE 3
+
+class ExtendedKalmanFilter : public KalmanFilter {
+public:
+	ExtendedKalmanFilter(Pose *initialPose);
+	~ExtendedKalmanFilter();
+	void filter(Pose *nsPose, Pose *wePose);
+	void setVelocity(float x, float y, float theta);
+	void setBodyVelocity(float forward, float strafe, float theta);
+	void setTimeStep(float dt);
+	void predict(float dt);
+	void correct(float *measurement, float *noise);
+	void getState(float *state);
+	void getCovariance(float *covariance);
+	void getPrediction(float *state, float *covariance, float *jacobian);
+	void getHealth(kalmanHealth *health);
+
+	template <typename T>
+	static void multiply3(T *mA, T *mB, T *mC, bool transposeB);
+	template <typename T>
+	static bool invert3(T *m, T *inv);
+private:
+	float _state[EKF_SIZE];
+	// the covariance math is kept in kfcov (double precision with
+	// KALMAN_DOUBLE_COVARIANCE), like the linear filter's
+	kfcov _covariance[EKF_SIZE * EKF_SIZE];
+	// the last prediction, before any corrections, and its jacobian
+	float _predictedState[EKF_SIZE];
+	kfcov _predictedCovariance[EKF_SIZE * EKF_SIZE];
+	kfcov _jacobian[EKF_SIZE * EKF_SIZE];
+	float _control[EKF_SIZE];
+	float _deltaT;
+	bool _hasFiltered;
+	struct timeval _lastFilterTime;
+	kalmanHealth _health;
+
+	float _elapsedTime();
+	void _checkHealth();
+};
+
+/**************************************
+ * Definition: Multiplies two 3x3 matrices, optionally transposing
+ *             the second one (C = A * B or C = A * B')
+ *
+ * Parameters: matrices A and B, result matrix C, and whether to
+ *             transpose B
+ **************************************/
+template <typename T>
+void ExtendedKalmanFilter::multiply3(T *mA, T *mB, T *mC, bool transposeB) {
+	for (int i = 0; i < EKF_SIZE; i++) {
+		for (int j = 0; j < EKF_SIZE; j++) {
+			T sum = 0;
+			for (int k = 0; k < EKF_SIZE; k++) {
+				sum += mA[i * EKF_SIZE + k] *
+				       (transposeB ? mB[j * EKF_SIZE + k] : mB[k * EKF_SIZE + j]);
+			}
+			mC[i * EKF_SIZE + j] = sum;
+		}
+	}
+}
+
+/**************************************
+ * Definition: Inverts a 3x3 matrix using its adjugate
+ *
+ * Parameters: matrix to invert and matrix to store the inverse in
+ *
+ * Returns:    false if the matrix is singular, true otherwise
+ **************************************/
+template <typename T>
+bool ExtendedKalmanFilter::invert3(T *m, T *inv) {
+	T c00 = m[4] * m[8] - m[5] * m[7];
+	T c01 = m[5] * m[6] - m[3] * m[8];
+	T c02 = m[3] * m[7] - m[4] * m[6];
+	T det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+	if (fabs(det) < 1e-12) {
+		return false;
+	}
+
+	T invDet = 1.0 / det;
+	inv[0] = c00 * invDet;
+	inv[1] = (m[2] * m[7] - m[1] * m[8]) * invDet;
+	inv[2] = (m[1] * m[5] - m[2] * m[4]) * invDet;
+	inv[3] = c01 * invDet;
+	inv[4] = (m[0] * m[8] - m[2] * m[6]) * invDet;
+	inv[5] = (m[2] * m[3] - m[0] * m[5]) * invDet;
+	inv[6] = c02 * invDet;
+	inv[7] = (m[1] * m[6] - m[0] * m[7]) * invDet;
+	inv[8] = (m[0] * m[4] - m[1] * m[3]) * invDet;
+	return true;
+}
+
+#endif
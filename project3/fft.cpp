@@ -0,0 +1,81 @@
+/**
+ * fft.cpp
+ * 
+ * @brief 
+ *      This namespace contains a radix-2 fast Fourier transform, used
+ *      for fast convolution of long filters and for looking at
+ *      frequency responses
+ * 
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ * 
+ **/
+
+#include "fft.h"
+#include "constants.h"
+#include <math.h>
+#include <algorithm>
+
+namespace FFT {
+    /**************************************
+     * Definition: Returns the smallest power of two that is
+     *             at least n
+     *
+     * Parameters: an int n
+     *
+     * Returns:    power of two as an int
+     **************************************/
+    int nextPowerOfTwo(int n) {
+        int size = 1;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    /**************************************
+     * Definition: Transforms the data in place. The inverse
+     *             transform is scaled by 1/size, so a forward
+     *             then inverse transform gives back the data
+     *
+     * Parameters: array of complex values, its size (a power
+     *             of two), and whether to do the inverse
+     **************************************/
+    void transform(std::complex<double> *data, int size, bool inverse) {
+        // put the data in bit-reversed order
+        for (int i = 1, j = 0; i < size; i++) {
+            int bit = size >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        // combine ever longer transforms
+        for (int length = 2; length <= size; length <<= 1) {
+            double angle = 2 * PI / length * (inverse ? 1 : -1);
+            std::complex<double> step(cos(angle), sin(angle));
+            for (int start = 0; start < size; start += length) {
+                std::complex<double> twiddle(1, 0);
+                for (int k = 0; k < length / 2; k++) {
+                    std::complex<double> even = data[start + k];
+                    std::complex<double> odd = data[start + k + length / 2] * twiddle;
+                    data[start + k] = even + odd;
+                    data[start + k + length / 2] = even - odd;
+                    twiddle *= step;
+                }
+            }
+        }
+
+        if (inverse) {
+            for (int i = 0; i < size; i++) {
+                data[i] /= size;
+            }
+        }
+    }
+};
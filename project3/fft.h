@@ -0,0 +1,26 @@
+/**
+ * fft.h
+ * 
+ * @brief 
+ *      This namespace contains a radix-2 fast Fourier transform, used
+ *      for fast convolution of long filters and for looking at
+ *      frequency responses
+ * 
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ * 
+ **/
+
+#ifndef CS1567_FFT_H
+#define CS1567_FFT_H
+
+#include <complex>
+
+namespace FFT {
+    int nextPowerOfTwo(int n);
+    void transform(std::complex<double> *data, int size, bool inverse);
+};
+
+#endif
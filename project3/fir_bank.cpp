@@ -0,0 +1,277 @@
+/**
+ * fir_bank.cpp
+ *
+ * @brief
+ *      This class applies FIR filters to several channels at once, such as
+ *      the three wheels or north star's x, y, and theta. The coefficients
+ *      and samples are interleaved by channel, so each tap is one loop
+ *      across all of the channels that the compiler can vectorize.
+ *      Channels may share one .ffc file or each have their own; shorter
+ *      filters are padded with zero taps. Every channel gives exactly
+ *      what its own FIRFilter would
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "fir_bank.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+/**************************************
+ * Definition: Reads the taps (coefficients) from a .ffc file
+ *             line by line
+ *
+ * Parameters: a string containing a filename and a vector to
+ *             fill with the taps
+ **************************************/
+static void readTaps(std::string fileName, std::vector<float> *taps) {
+    std::ifstream f(fileName.c_str());
+    std::string line;
+    while (std::getline(f, line)) {
+        taps->push_back(atof(line.c_str()));
+    }
+}
+
+FIRBank::FIRBank(int numChannels, std::string fileName) {
+    std::vector<float> taps;
+    readTaps(fileName, &taps);
+
+    _allocate(numChannels, taps.size());
+    for (int c = 0; c < numChannels; c++) {
+        _setCoefficients(c, &taps);
+    }
+}
+
+FIRBank::FIRBank(std::vector<std::string> *fileNames) {
+    std::vector<std::vector<float> > taps(fileNames->size());
+    unsigned int numTaps = 0;
+    for (unsigned int c = 0; c < fileNames->size(); c++) {
+        readTaps((*fileNames)[c], &taps[c]);
+        if (taps[c].size() > numTaps) {
+            numTaps = taps[c].size();
+        }
+    }
+
+    _allocate(fileNames->size(), numTaps);
+    for (unsigned int c = 0; c < fileNames->size(); c++) {
+        _setCoefficients(c, &taps[c]);
+    }
+}
+
+FIRBank::~FIRBank() {
+    delete[] _coefficients;
+    delete[] _samples;
+    delete[] _values;
+    delete[] _channelTaps;
+    delete[] _seedCount;
+}
+
+/**************************************
+ * Definition: Returns the number of channels being filtered
+ *
+ * Returns: an int with the number of channels
+ **************************************/
+int FIRBank::getNumChannels() {
+    return _numChannels;
+}
+
+/**************************************
+ * Definition: Returns the number of taps every channel uses
+ *             (the most of any channel's filter)
+ *
+ * Returns: an int with the number of taps
+ **************************************/
+int FIRBank::getNumTaps() {
+    return _numTaps;
+}
+
+/**************************************
+ * Definition: Returns the order of one channel's own filter (taps-1)
+ *
+ * Parameters: the channel
+ *
+ * Returns: an int with the order
+ **************************************/
+int FIRBank::getOrder(int channel) {
+    return _channelTaps[channel] - 1;
+}
+
+/**************************************
+ * Definition: Seeds one channel's samples with the given values,
+ *             exactly the way FIRFilter::seed does (including
+ *             leaving anything past the given values where it was),
+ *             without disturbing the other channels
+ *
+ * Parameters: the channel and a vector pointer with sample values
+ **************************************/
+void FIRBank::seed(int channel, std::vector<float> *samples) {
+    int numTaps = _channelTaps[channel];
+    if (numTaps == 0) {
+        return;
+    }
+    int numSamples = numTaps;
+    if ((int)samples->size() < numSamples) {
+        numSamples = samples->size();
+    }
+
+    // FIRFilter writes sample i into slot i of its own ring and starts
+    // its next sample back at slot 0, keeping its old slots past the
+    // given samples. gather the whole ring in that order first
+    std::vector<float> ring(numTaps);
+    for (int i = 0; i < numTaps; i++) {
+        if (i < numSamples) {
+            ring[i] = (*samples)[i];
+        }
+        else {
+            ring[i] = _samples[_slot(channel, i) * _stride + channel];
+        }
+    }
+
+    _seedCount[channel] = _filterCount;
+    for (int i = 0; i < numTaps; i++) {
+        _setSample(_slot(channel, i), channel, ring[i]);
+    }
+}
+
+/**************************************
+ * Definition: Seeds one channel's samples with the given value.
+ *             Like FIRFilter::seed(float), this fills all but one
+ *             slot of the channel's own ring
+ *
+ * Parameters: the channel and a single float used to populate it
+ **************************************/
+void FIRBank::seed(int channel, float value) {
+    for (int i = 0; i < _channelTaps[channel] - 1; i++) {
+        _setSample(_slot(channel, i), channel, value);
+    }
+}
+
+/**************************************
+ * Definition: Adds the newest value to every channel and filters
+ *             them all in one pass
+ *
+ * Parameters: an array with the newest value for each channel, and
+ *             an array to put each channel's filtered value in
+ **************************************/
+void FIRBank::filter(const float *values, float *filtered) {
+    int c, i;
+
+    for (c = 0; c < _numChannels; c++) {
+        _setSample(_nextSample, c, values[c]);
+    }
+
+    // the window starting at the newest sample runs newest, oldest,
+    // ..., second newest, which is the order FIRFilter pairs them in
+    const float *window = &_samples[_nextSample * _stride];
+    for (c = 0; c < _stride; c++) {
+        _values[c] = 0;
+    }
+    for (i = 0; i < _numTaps; i++) {
+        const float *coefficients = &_coefficients[i * _stride];
+        const float *samples = &window[i * _stride];
+        for (c = 0; c < _stride; c++) {
+            _values[c] += coefficients[c] * samples[c];
+        }
+    }
+
+    _nextSample = (_nextSample + 1 == _numTaps) ? 0 : _nextSample + 1;
+    _filterCount++;
+
+    for (c = 0; c < _numChannels; c++) {
+        filtered[c] = _values[c];
+    }
+}
+
+/**************************************
+ * Definition: Returns a channel's most recent filtered value
+ *
+ * Parameters: the channel
+ *
+ * Returns: a filtered float value
+ **************************************/
+float FIRBank::getValue(int channel) {
+    return _values[channel];
+}
+
+/**************************************
+ * Definition: Allocates and zeroes the coefficients and samples
+ *
+ * Parameters: number of channels and number of taps
+ **************************************/
+void FIRBank::_allocate(int numChannels, int numTaps) {
+    _numChannels = numChannels;
+    _stride = ((numChannels + FIR_BANK_ALIGN - 1) / FIR_BANK_ALIGN) * FIR_BANK_ALIGN;
+    // an empty .ffc file gives a filter that always outputs 0
+    _numTaps = numTaps > 0 ? numTaps : 1;
+    _nextSample = 0;
+
+    _coefficients = new float[_numTaps * _stride];
+    _samples = new float[2 * _numTaps * _stride];
+    _values = new float[_stride];
+    _channelTaps = new int[_stride];
+    _seedCount = new unsigned long[_stride];
+    _filterCount = 0;
+    memset(_coefficients, 0, sizeof(float) * _numTaps * _stride);
+    memset(_samples, 0, sizeof(float) * 2 * _numTaps * _stride);
+    memset(_values, 0, sizeof(float) * _stride);
+    memset(_channelTaps, 0, sizeof(int) * _stride);
+    memset(_seedCount, 0, sizeof(unsigned long) * _stride);
+}
+
+/**************************************
+ * Definition: Sets one channel's coefficients. FIRFilter pairs tap
+ *             0 with the newest sample and tap i with the sample
+ *             (taps - i) steps old, so a shorter filter keeps its
+ *             first tap first and the rest at the end. That way every
+ *             tap still meets the same age of sample, and the zero
+ *             padding in between only meets older ones
+ *
+ * Parameters: the channel and a vector pointer with its taps
+ **************************************/
+void FIRBank::_setCoefficients(int channel, std::vector<float> *taps) {
+    int numTaps = taps->size();
+    _channelTaps[channel] = numTaps;
+    if (numTaps == 0) {
+        return;
+    }
+
+    _coefficients[channel] = (*taps)[0];
+    for (int i = 1; i < numTaps; i++) {
+        _coefficients[(_numTaps - numTaps + i) * _stride + channel] = (*taps)[i];
+    }
+}
+
+/**************************************
+ * Definition: Stores a sample in both copies of the ring buffer
+ *
+ * Parameters: the ring slot, the channel, and the value
+ **************************************/
+void FIRBank::_setSample(int slot, int channel, float value) {
+    _samples[slot * _stride + channel] = value;
+    _samples[(slot + _numTaps) * _stride + channel] = value;
+}
+
+/**************************************
+ * Definition: Finds where slot i of a channel's own ring (the one
+ *             its FIRFilter would have) lives in the bank. Both
+ *             rings advance once per filter, so a slot's age only
+ *             depends on how far the channel's ring has turned since
+ *             it was last seeded
+ *
+ * Parameters: the channel and the slot in its own ring
+ *
+ * Returns: an int with the slot in the bank's ring
+ **************************************/
+int FIRBank::_slot(int channel, int i) {
+    int numTaps = _channelTaps[channel];
+    // the slot the channel's own filter would write next
+    int next = (_filterCount - _seedCount[channel]) % numTaps;
+    int age = ((next - 1 - i) % numTaps + numTaps) % numTaps;
+    return ((_nextSample - 1 - age) % _numTaps + _numTaps) % _numTaps;
+}
@@ -0,0 +1,65 @@
+/**
+ * fir_bank.h
+ *
+ * @brief
+ *      This class applies FIR filters to several channels at once, such as
+ *      the three wheels or north star's x, y, and theta. The coefficients
+ *      and samples are interleaved by channel, so each tap is one loop
+ *      across all of the channels that the compiler can vectorize.
+ *      Channels may share one .ffc file or each have their own; shorter
+ *      filters are padded with zero taps. Every channel gives exactly
+ *      what its own FIRFilter would
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_FIRBANK_H
+#define CS1567_FIRBANK_H
+
+#include <string>
+#include <vector>
+#include "sensor_filter.h"
+
+// channels are padded to a multiple of this many
+#define FIR_BANK_ALIGN 4
+
+class FIRBank : public SensorFilter {
+public:
+    FIRBank(int numChannels, std::string fileName);
+    FIRBank(std::vector<std::string> *fileNames);
+    ~FIRBank();
+    int getNumChannels();
+    int getNumTaps();
+    int getOrder(int channel);
+    void seed(int channel, std::vector<float> *samples);
+    void seed(int channel, float value);
+    void filter(const float *values, float *filtered);
+    float getValue(int channel);
+private:
+    int _numChannels;
+    int _stride;
+    int _numTaps;
+    // _coefficients[tap * _stride + channel]
+    float *_coefficients;
+    // a ring buffer stored twice back to back, so
+    // _samples[i * _stride + c] == _samples[(i + _numTaps) * _stride + c]
+    float *_samples;
+    float *_values;
+    // how many taps each channel's own filter has
+    int *_channelTaps;
+    // filters run in total, and as of each channel's last seed
+    unsigned long _filterCount;
+    unsigned long *_seedCount;
+    int _nextSample;
+
+    void _allocate(int numChannels, int numTaps);
+    void _setCoefficients(int channel, std::vector<float> *taps);
+    void _setSample(int slot, int channel, float value);
+    int _slot(int channel, int i);
+};
+
+#endif
@@ -12,15 +12,22 @@
  **/
 
 #include "fir_filter.h"
+#include "fft.h"
 
 #include <cstdlib>
 #include <fstream>
+#include <complex>
 
 FIRFilter::FIRFilter(std::string fileName) 
-: _order(0), _coefficients(), _samples(), _nextSample(0) {
+: _order(0), _value(0), _coefficients(), _samples(), _nextSample(0), _fixed(NULL) {
     // read in the taps from the specified .ffc file and set the order
     int numTaps = _readTaps(fileName);
     _order = numTaps - 1;
+    _fixed = _makeFixed(numTaps);
+}
+
+FIRFilter::~FIRFilter() {
+    delete _fixed;
 }
 
 /**************************************
@@ -62,6 +69,14 @@ void FIRFilter::seedFromFile(std::string fileName) {
  * Parameters: a vector pointer with sample values
  **************************************/
 void FIRFilter::seed(std::vector<float> *samples) {
+    if (_fixed != NULL) {
+        // even with nothing to seed, this starts the next sample
+        // back at the beginning
+        const float *values = samples->empty() ? NULL : &(*samples)[0];
+        _fixed->seed(values, samples->size());
+        return;
+    }
+
     int numSamples = getOrder()+1;
     if (samples->size() < numSamples) {
         numSamples = samples->size();
@@ -79,6 +94,11 @@ void FIRFilter::seed(std::vector<float> *samples) {
  * Parameters: a single float used to populate the entire array
  **************************************/
 void FIRFilter::seed(float value) {
+    if (_fixed != NULL) {
+        _fixed->seed(value);
+        return;
+    }
+
 	for (int i = 0; i < getOrder(); i++){
 		_samples[i] = value;
 	}
@@ -92,21 +112,27 @@ void FIRFilter::seed(float value) {
  * Returns: a filtered float
  **************************************/
 float FIRFilter::filter(float val) {
+    if (_fixed != NULL) {
+        _value = _fixed->filter(val);
+        return _value;
+    }
+
     float sum = 0;
+    int numTaps = _order + 1;
     int i, j;
 
     // add this value as the next sample
     _samples[_nextSample] = val;
-    for (i = 0, j = _nextSample; i < getOrder()+1; i++) {
+    for (i = 0, j = _nextSample; i < numTaps; i++) {
         sum += _coefficients[i] * _samples[j++];
         // if j has passed our filter size, reset it to 0
-        if (j == getOrder()+1) {
+        if (j == numTaps) {
             j = 0;
         }
     }
 
     // the next sample should be put at 0 if we've reached our size
-    if (++_nextSample == getOrder()+1) {
+    if (++_nextSample == numTaps) {
         _nextSample = 0;
     }
 
@@ -116,6 +142,53 @@ float FIRFilter::filter(float val) {
     return sum;
 }
 
+/**************************************
+ * Definition: Filters a run of values, giving the same results as
+ *             passing each one to filter in turn and leaving the
+ *             filter in the same state afterwards. Long filters use
+ *             overlap-save FFT convolution, which matches to within
+ *             float rounding; everything else matches exactly
+ *
+ * Parameters: the values to filter, an array to put the filtered
+ *             values in, and how many there are
+ **************************************/
+void FIRFilter::filter(const float *values, float *filtered, int numSamples) {
+    if (numSamples <= 0) {
+        return;
+    }
+    if (_fixed != NULL) {
+        _fixed->filter(values, filtered, numSamples);
+        _value = filtered[numSamples - 1];
+        return;
+    }
+
+    // lay the samples we already have (oldest first) in front of
+    // the new ones, so every output only looks backwards in one array
+    int numTaps = _order + 1;
+    std::vector<float> history(numTaps - 1 + numSamples);
+    for (int age = numTaps - 1; age >= 1; age--) {
+        history[numTaps - 1 - age] = _samples[(_nextSample + numTaps - age) % numTaps];
+    }
+    for (int i = 0; i < numSamples; i++) {
+        history[numTaps - 1 + i] = values[i];
+    }
+
+    if (numTaps >= FIR_FFT_MIN_TAPS) {
+        _filterFFT(&history[0], filtered, numSamples);
+    }
+    else {
+        _filterDirect(&history[0], filtered, numSamples);
+    }
+
+    // store the newest samples where filter would have put them
+    int first = numSamples > numTaps ? numSamples - numTaps : 0;
+    for (int i = first; i < numSamples; i++) {
+        _samples[(_nextSample + i) % numTaps] = values[i];
+    }
+    _nextSample = (_nextSample + numSamples) % numTaps;
+    _value = filtered[numSamples - 1];
+}
+
 /**************************************
  * Definition: Reads in the taps (coefficients) from a given file
  *             line by line
@@ -136,3 +209,93 @@ int FIRFilter::_readTaps(std::string fileName) {
     _samples.resize(numTaps);
     return numTaps;
 }
+
+/**************************************
+ * Definition: Makes a compile-time sized filter for the tap counts
+ *             our .ffc files use (8 for the wheel encoders, 3 for
+ *             north star x and y, 1 for north star theta)
+ *
+ * Parameters: an int with the number of taps
+ *
+ * Returns: a new FixedFIRFilter, or NULL if there isn't one for
+ *          this many taps
+ **************************************/
+FixedFIRKernel* FIRFilter::_makeFixed(int numTaps) {
+    switch (numTaps) {
+    case 1:
+        return new FixedFIRFilter<1>(&_coefficients[0]);
+    case 3:
+        return new FixedFIRFilter<3>(&_coefficients[0]);
+    case 8:
+        return new FixedFIRFilter<8>(&_coefficients[0]);
+    default:
+        return NULL;
+    }
+}
+
+/**************************************
+ * Definition: Filters a run of values by direct convolution, adding
+ *             the products up in the same order as filter does so
+ *             the results are exactly the same
+ *
+ * Parameters: the old samples followed by the new ones, an array
+ *             to put the filtered values in, and how many new
+ *             values there are
+ **************************************/
+void FIRFilter::_filterDirect(const float *history, float *filtered, int numSamples) {
+    int numTaps = _order + 1;
+    for (int n = 0; n < numSamples; n++) {
+        // filter pairs the first tap with the newest sample and
+        // tap i with the sample (taps - i) steps older
+        const float *window = &history[n];
+        float sum = _coefficients[0] * window[numTaps - 1];
+        for (int i = 1; i < numTaps; i++) {
+            sum += _coefficients[i] * window[i - 1];
+        }
+        filtered[n] = sum;
+    }
+}
+
+/**************************************
+ * Definition: Filters a run of values with overlap-save FFT
+ *             convolution, which takes O(log taps) work per sample
+ *             instead of O(taps)
+ *
+ * Parameters: the old samples followed by the new ones, an array
+ *             to put the filtered values in, and how many new
+ *             values there are
+ **************************************/
+void FIRFilter::_filterFFT(const float *history, float *filtered, int numSamples) {
+    int numTaps = _order + 1;
+    int size = FFT::nextPowerOfTwo(4 * numTaps);
+    // each block gives this many outputs; the rest wrap around
+    int step = size - numTaps + 1;
+    int length = numTaps - 1 + numSamples;
+
+    // the impulse response: the first tap is for the newest sample,
+    // and tap i for the sample (taps - i) steps older
+    std::vector<std::complex<double> > response(size);
+    response[0] = _coefficients[0];
+    for (int i = 1; i < numTaps; i++) {
+        response[numTaps - i] = _coefficients[i];
+    }
+    FFT::transform(&response[0], size, false);
+
+    std::vector<std::complex<double> > block(size);
+    for (int start = 0; start < numSamples; start += step) {
+        for (int i = 0; i < size; i++) {
+            int j = start + i;
+            block[i] = j < length ? history[j] : 0;
+        }
+        FFT::transform(&block[0], size, false);
+        for (int i = 0; i < size; i++) {
+            block[i] *= response[i];
+        }
+        FFT::transform(&block[0], size, true);
+
+        // the first taps-1 outputs wrapped around, so skip them
+        for (int i = 0; i < step && start + i < numSamples; i++) {
+            filtered[start + i] = block[numTaps - 1 + i].real();
+        }
+    }
+}
@@ -16,15 +16,22 @@
 
 #include <string>
 #include <vector>
+#include "fixed_fir_filter.h"
+
+// filters with at least this many taps use FFT convolution when
+// filtering a run of samples
+#define FIR_FFT_MIN_TAPS 64
 
 class FIRFilter {
 public:
     FIRFilter(std::string fileName);
+    ~FIRFilter();
     int getOrder();
     void seedFromFile(std::string fileName);
     void seed(std::vector<float> *samples);
     void seed(float value);
     float filter(float val);
+    void filter(const float *values, float *filtered, int numSamples);
 	float getValue();
 private:
     int _order;
@@ -32,8 +39,14 @@ private:
     std::vector<float> _coefficients;
     std::vector<float> _samples;
     unsigned int _nextSample;
+    // a compile-time sized filter to use instead, if there is one
+    // for our tap count
+    FixedFIRKernel *_fixed;
 	
     int _readTaps(std::string fileName);
+    void _filterDirect(const float *history, float *filtered, int numSamples);
+    void _filterFFT(const float *history, float *filtered, int numSamples);
+    FixedFIRKernel* _makeFixed(int numTaps);
 };
 
 #endif
@@ -0,0 +1,130 @@
+/**
+ * fixed_fir_filter.h
+ *
+ * @brief
+ *      A FIR filter with its tap count fixed at compile time. The samples
+ *      live in a ring buffer that is stored twice back to back, so the
+ *      newest N samples are always one contiguous window and the dot
+ *      product is a single loop with no index wrapping. It gives exactly
+ *      the same results as FIRFilter (which hands off to it for the tap
+ *      counts our .ffc files use), including which coefficient meets
+ *      which sample
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_FIXEDFIRFILTER_H
+#define CS1567_FIXEDFIRFILTER_H
+
+// lets FIRFilter hold any FixedFIRFilter<N> without knowing N
+class FixedFIRKernel {
+public:
+    virtual ~FixedFIRKernel() {}
+    virtual float filter(float val) = 0;
+    virtual void filter(const float *values, float *filtered, int numSamples) = 0;
+    virtual void seed(const float *samples, int numSamples) = 0;
+    virtual void seed(float value) = 0;
+};
+
+template <int N>
+class FixedFIRFilter : public FixedFIRKernel {
+public:
+    FixedFIRFilter(const float *coefficients);
+    float filter(float val);
+    void filter(const float *values, float *filtered, int numSamples);
+    void seed(const float *samples, int numSamples);
+    void seed(float value);
+private:
+    float _coefficients[N];
+    // _buffer[i] == _buffer[i + N] for every i < N
+    float _buffer[2 * N];
+    int _nextSample;
+};
+
+template <int N>
+FixedFIRFilter<N>::FixedFIRFilter(const float *coefficients)
+: _nextSample(0) {
+    for (int i = 0; i < N; i++) {
+        _coefficients[i] = coefficients[i];
+        _buffer[i] = 0;
+        _buffer[i + N] = 0;
+    }
+}
+
+/**************************************
+ * Definition: Returns a filtered value
+ *
+ * Parameters: the newest float value to add to the samples
+ *
+ * Returns: a filtered float
+ **************************************/
+template <int N>
+float FixedFIRFilter<N>::filter(float val) {
+    // write both copies, then the window starting at the newest
+    // sample runs newest, oldest, ..., second newest without wrapping
+    _buffer[_nextSample] = val;
+    _buffer[_nextSample + N] = val;
+    const float *window = &_buffer[_nextSample];
+
+    float sum = 0;
+    for (int i = 0; i < N; i++) {
+        sum += _coefficients[i] * window[i];
+    }
+
+    // a select rather than a branch
+    _nextSample = (_nextSample + 1 == N) ? 0 : _nextSample + 1;
+
+    return sum;
+}
+
+/**************************************
+ * Definition: Filters a run of values, exactly as if each were
+ *             passed to filter in turn
+ *
+ * Parameters: the values to filter, an array to put the filtered
+ *             values in, and how many there are
+ **************************************/
+template <int N>
+void FixedFIRFilter<N>::filter(const float *values, float *filtered, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        filtered[i] = FixedFIRFilter<N>::filter(values[i]);
+    }
+}
+
+/**************************************
+ * Definition: Seeds the samples with the given values, and starts
+ *             the next sample back at the beginning
+ *
+ * Parameters: an array of sample values and its length
+ **************************************/
+template <int N>
+void FixedFIRFilter<N>::seed(const float *samples, int numSamples) {
+    if (numSamples > N) {
+        numSamples = N;
+    }
+    for (int i = 0; i < numSamples; i++) {
+        _buffer[i] = samples[i];
+        _buffer[i + N] = samples[i];
+    }
+    _nextSample = 0;
+}
+
+/**************************************
+ * Definition: Seeds the samples with the given value. Like
+ *             FIRFilter::seed(float), this fills the first N-1
+ *
+ * Parameters: a single float used to populate the samples
+ **************************************/
+template <int N>
+void FixedFIRFilter<N>::seed(float value) {
+    for (int i = 0; i < N - 1; i++) {
+        _buffer[i] = value;
+        _buffer[i + N] = value;
+    }
+}
+
+#endif
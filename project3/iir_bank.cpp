@@ -0,0 +1,161 @@
+/**
+ * iir_bank.cpp
+ *
+ * @brief
+ *      This class applies the same IIR filter to several channels at
+ *      once. It is the low-lag alternative to FIRBank: a one-pole
+ *      (exponential) low-pass, a second order Butterworth low-pass
+ *      (biquad), or a critically damped alpha-beta tracker, which
+ *      follows a steady ramp (a constant spin or drive) with no lag at
+ *      all. All three are run as a biquad, so each sample costs the same
+ *      few multiplies however much smoothing is asked for
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "iir_bank.h"
+#include "constants.h"
+
+#include <math.h>
+
+/**************************************
+ * Definition: Sets up the filter for every channel
+ *
+ * Parameters: number of channels, filter type (FILTER_ONE_POLE,
+ *             FILTER_BIQUAD or FILTER_ALPHA_BETA from constants.h),
+ *             and cutoff as a fraction of the update rate
+ **************************************/
+IIRBank::IIRBank(int numChannels, int type, float cutoff) {
+    _numChannels = numChannels;
+    _b0 = 1;
+    _b1 = _b2 = _a1 = _a2 = 0;
+
+    if (type == FILTER_BIQUAD) {
+        // butterworth low-pass (Q = 1/sqrt(2)) from the bilinear transform
+        float w = 2 * PI * cutoff;
+        float alpha = sin(w) / sqrt(2.0);
+        float a0 = 1 + alpha;
+        _b0 = (1 - cos(w)) / 2 / a0;
+        _b1 = (1 - cos(w)) / a0;
+        _b2 = _b0;
+        _a1 = -2 * cos(w) / a0;
+        _a2 = (1 - alpha) / a0;
+        _order = 2;
+    }
+    else if (type == FILTER_ALPHA_BETA) {
+        // x = x + v + alpha r, v = v + beta r with r = input - (x + v),
+        // which works out to this biquad. the critically damped gains
+        // put both poles where the one-pole filter's is
+        float theta = exp(-2 * PI * cutoff);
+        float alpha = 1 - theta * theta;
+        float beta = (1 - theta) * (1 - theta);
+        _b0 = alpha;
+        _b1 = beta - alpha;
+        _a1 = alpha + beta - 2;
+        _a2 = 1 - alpha;
+        _order = 2;
+    }
+    else {
+        // one-pole: y = y[-1] + (1 - pole) (x - y[-1])
+        float pole = exp(-2 * PI * cutoff);
+        _b0 = 1 - pole;
+        _a1 = -pole;
+        _order = 1;
+    }
+
+    _z1 = new float[numChannels];
+    _z2 = new float[numChannels];
+    _values = new float[numChannels];
+    for (int c = 0; c < numChannels; c++) {
+        _z1[c] = 0;
+        _z2[c] = 0;
+        _values[c] = 0;
+    }
+}
+
+IIRBank::~IIRBank() {
+    delete[] _z1;
+    delete[] _z2;
+    delete[] _values;
+}
+
+/**************************************
+ * Definition: Returns the number of channels being filtered
+ *
+ * Returns: an int with the number of channels
+ **************************************/
+int IIRBank::getNumChannels() {
+    return _numChannels;
+}
+
+/**************************************
+ * Definition: Returns the order of the filter, which is the same
+ *             for every channel
+ *
+ * Parameters: the channel
+ *
+ * Returns: an int with the order
+ **************************************/
+int IIRBank::getOrder(int /* channel */) {
+    return _order;
+}
+
+/**************************************
+ * Definition: Seeds one channel from a history of samples. An IIR
+ *             filter only needs the newest one, which comes first
+ *
+ * Parameters: the channel and a vector pointer with sample values,
+ *             newest first
+ **************************************/
+void IIRBank::seed(int channel, std::vector<float> *samples) {
+    if (!samples->empty()) {
+        seed(channel, (*samples)[0]);
+    }
+}
+
+/**************************************
+ * Definition: Seeds one channel as if it had been given the same
+ *             value forever
+ *
+ * Parameters: the channel and a single float used to populate it
+ **************************************/
+void IIRBank::seed(int channel, float value) {
+    // the state the filter settles into for a constant input
+    // (every type has a DC gain of 1)
+    _z2[channel] = (_b2 - _a2) * value;
+    _z1[channel] = (_b1 - _a1) * value + _z2[channel];
+    _values[channel] = value;
+}
+
+/**************************************
+ * Definition: Adds the newest value to every channel and filters
+ *             them all in one pass
+ *
+ * Parameters: an array with the newest value for each channel, and
+ *             an array to put each channel's filtered value in
+ **************************************/
+void IIRBank::filter(const float *values, float *filtered) {
+    for (int c = 0; c < _numChannels; c++) {
+        float x = values[c];
+        float y = _b0 * x + _z1[c];
+        _z1[c] = _b1 * x - _a1 * y + _z2[c];
+        _z2[c] = _b2 * x - _a2 * y;
+        _values[c] = y;
+        filtered[c] = y;
+    }
+}
+
+/**************************************
+ * Definition: Returns a channel's most recent filtered value
+ *
+ * Parameters: the channel
+ *
+ * Returns: a filtered float value
+ **************************************/
+float IIRBank::getValue(int channel) {
+    return _values[channel];
+}
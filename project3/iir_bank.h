@@ -0,0 +1,47 @@
+/**
+ * iir_bank.h
+ *
+ * @brief
+ *      This class applies the same IIR filter to several channels at
+ *      once. It is the low-lag alternative to FIRBank: a one-pole
+ *      (exponential) low-pass, a second order Butterworth low-pass
+ *      (biquad), or a critically damped alpha-beta tracker, which
+ *      follows a steady ramp (a constant spin or drive) with no lag at
+ *      all. All three are run as a biquad, so each sample costs the same
+ *      few multiplies however much smoothing is asked for
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_IIRBANK_H
+#define CS1567_IIRBANK_H
+
+#include "sensor_filter.h"
+
+class IIRBank : public SensorFilter {
+public:
+    IIRBank(int numChannels, int type, float cutoff);
+    ~IIRBank();
+    int getNumChannels();
+    int getOrder(int channel);
+    void seed(int channel, std::vector<float> *samples);
+    void seed(int channel, float value);
+    void filter(const float *values, float *filtered);
+    float getValue(int channel);
+private:
+    int _numChannels;
+    int _order;
+    // y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+    float _b0, _b1, _b2;
+    float _a1, _a2;
+    // each channel's transposed direct form II state
+    float *_z1;
+    float *_z2;
+    float *_values;
+};
+
+#endif
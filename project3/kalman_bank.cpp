@@ -0,0 +1,563 @@
+/**
+ * kalman_bank.cpp
+ *
+ * @brief
+ * 		This class holds the extended Kalman filter state for a whole fleet
+ *      of robots in structure-of-arrays form (every field is one
+ *      contiguous row with one column per robot), so a single step
+ *      predicts and corrects all of them in straight-line loops the
+ *      compiler can vectorize. KalmanBankFilter wraps one column so it
+ *      can be used anywhere a KalmanFilter is expected, but it steps
+ *      only its own column, so the batching comes from calling the
+ *      bank's step directly.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include "kalman_bank.h"
+#include "utilities.h"
+#include "constants.h"
+#include <math.h>
+#include <string.h>
+
+// wraps an angle into [0, 2PI) without looping
+#define WRAP_THETA(t) ((t) - 2*PI * floorf((t) / (2*PI)))
+// wraps an angle difference into [-PI, PI) without looping
+#define WRAP_ERROR(e) ((e) - 2*PI * floorf(((e) + PI) / (2*PI)))
+
+KalmanBank::KalmanBank(int numRobots) {
+	_numRobots = numRobots;
+	_stride = ((numRobots + KALMAN_BANK_ALIGN - 1) / KALMAN_BANK_ALIGN) * KALMAN_BANK_ALIGN;
+
+	_data = new float[KB_NUM_FIELDS * _stride];
+	memset(_data, 0, sizeof(float) * KB_NUM_FIELDS * _stride);
+
+	_health = new kalmanHealth[_stride];
+	memset(_health, 0, sizeof(kalmanHealth) * _stride);
+
+	// every robot (and padding column) starts at the origin with
+	// the same default uncertainties as a KalmanFilter
+	Pose origin(0, 0, 0);
+	for (int i = 0; i < _stride; i++) {
+		reset(i, &origin);
+		setUncertainty(i, 0.05, 0.05, 0.05,
+		               0.05, 0.05, 0.05,
+		               0.05, 0.05, 0.05);
+	}
+}
+
+KalmanBank::~KalmanBank() {
+	delete[] _data;
+	delete[] _health;
+}
+
+/**************************************
+ * Definition: Returns the number of robots in the bank
+ *
+ * Returns:    number of robots as an int
+ **************************************/
+int KalmanBank::size() {
+	return _numRobots;
+}
+
+/**************************************
+ * Definition: Restarts a robot's filter at the given pose, standing
+ *             still, with its covariance at one model step
+ *
+ * Parameters: index of the robot and the pose to start at
+ **************************************/
+void KalmanBank::reset(int robot, Pose *pose) {
+	_row(KB_X)[robot] = pose->getX();
+	_row(KB_Y)[robot] = pose->getY();
+	_row(KB_THETA)[robot] = pose->getTheta();
+
+	_row(KB_P00)[robot] = _row(KB_Q0)[robot];
+	_row(KB_P01)[robot] = 0;
+	_row(KB_P02)[robot] = 0;
+	_row(KB_P11)[robot] = _row(KB_Q1)[robot];
+	_row(KB_P12)[robot] = 0;
+	_row(KB_P22)[robot] = _row(KB_Q2)[robot];
+
+	_row(KB_VF)[robot] = 0;
+	_row(KB_VS)[robot] = 0;
+	_row(KB_VW)[robot] = 0;
+
+	_row(KB_MASK_NS)[robot] = 0;
+	_row(KB_MASK_WE)[robot] = 0;
+}
+
+/**************************************
+ * Definition: Sets all of a robot's uncertainties at once
+ *
+ * Parameters: index of the robot, then process, north star, and
+ *             wheel encoder uncertainties for x, y, and theta
+ **************************************/
+void KalmanBank::setUncertainty(int robot, float px, float py, float ptheta,
+                                float nsx, float nsy, float nstheta,
+                                float wex, float wey, float wetheta) {
+	setProcUncertainty(robot, px, py, ptheta);
+	setNSUncertainty(robot, nsx, nsy, nstheta);
+	setWEUncertainty(robot, wex, wey, wetheta);
+}
+
+/**************************************
+ * Definition: Sets a robot's process (model) uncertainty
+ *
+ * Parameters: index of the robot and x, y, and theta uncertainties
+ **************************************/
+void KalmanBank::setProcUncertainty(int robot, float x, float y, float theta) {
+	_row(KB_Q0)[robot] = x;
+	_row(KB_Q1)[robot] = y;
+	_row(KB_Q2)[robot] = theta;
+}
+
+/**************************************
+ * Definition: Sets a robot's north star measurement uncertainty
+ *
+ * Parameters: index of the robot and x, y, and theta uncertainties
+ **************************************/
+void KalmanBank::setNSUncertainty(int robot, float x, float y, float theta) {
+	_row(KB_RN0)[robot] = x;
+	_row(KB_RN1)[robot] = y;
+	_row(KB_RN2)[robot] = theta;
+}
+
+/**************************************
+ * Definition: Sets a robot's wheel encoder measurement uncertainty
+ *
+ * Parameters: index of the robot and x, y, and theta uncertainties
+ **************************************/
+void KalmanBank::setWEUncertainty(int robot, float x, float y, float theta) {
+	_row(KB_RW0)[robot] = x;
+	_row(KB_RW1)[robot] = y;
+	_row(KB_RW2)[robot] = theta;
+}
+
+/**************************************
+ * Definition: Sets the velocity used by a robot's motion model,
+ *             in the robot's frame
+ *
+ * Parameters: index of the robot, then forward (cm/s), strafe
+ *             left (cm/s), and theta (rad/s) speeds as floats
+ **************************************/
+void KalmanBank::setBodyVelocity(int robot, float forward, float strafe, float theta) {
+	_row(KB_VF)[robot] = forward;
+	_row(KB_VS)[robot] = strafe;
+	_row(KB_VW)[robot] = theta;
+}
+
+/**************************************
+ * Definition: Stages north star and wheel encoder poses to be
+ *             used by the next step. Either pose may be NULL if
+ *             that sensor has nothing new
+ *
+ * Parameters: index of the robot, a North Star pose and a
+ *             Wheel Encoders Pose
+ **************************************/
+void KalmanBank::setMeasurements(int robot, Pose *nsPose, Pose *wePose) {
+	if (nsPose != NULL) {
+		_row(KB_ZN0)[robot] = nsPose->getX();
+		_row(KB_ZN1)[robot] = nsPose->getY();
+		_row(KB_ZN2)[robot] = nsPose->getTheta();
+		_row(KB_MASK_NS)[robot] = 1;
+	}
+	if (wePose != NULL) {
+		_row(KB_ZW0)[robot] = wePose->getX();
+		_row(KB_ZW1)[robot] = wePose->getY();
+		_row(KB_ZW2)[robot] = wePose->getTheta();
+		_row(KB_MASK_WE)[robot] = 1;
+	}
+}
+
+/**************************************
+ * Definition: Predicts every robot dt seconds forward and corrects
+ *             each with whatever measurements were staged for it
+ *
+ * Parameters: time step in seconds as a float
+ **************************************/
+void KalmanBank::step(float dt) {
+	_step(0, _stride, dt);
+	_checkHealth(0, _numRobots);
+}
+
+/**************************************
+ * Definition: Steps a single robot, leaving the rest alone
+ *
+ * Parameters: index of the robot and time step in seconds
+ **************************************/
+void KalmanBank::stepOne(int robot, float dt) {
+	_step(robot, robot + 1, dt);
+	_checkHealth(robot, robot + 1);
+}
+
+/**************************************
+ * Definition: Copies a robot's current estimate into a pose
+ *
+ * Parameters: index of the robot and the pose to update
+ **************************************/
+void KalmanBank::getPose(int robot, Pose *pose) {
+	pose->setX(_row(KB_X)[robot]);
+	pose->setY(_row(KB_Y)[robot]);
+	pose->setTheta(_row(KB_THETA)[robot]);
+}
+
+/**************************************
+ * Definition: Returns a robot's current heading estimate
+ *
+ * Parameters: index of the robot
+ *
+ * Returns:    theta in [0, 2PI) as a float
+ **************************************/
+float KalmanBank::getTheta(int robot) {
+	return _row(KB_THETA)[robot];
+}
+
+/**************************************
+ * Definition: Copies a robot's full 3x3 covariance (row major)
+ *
+ * Parameters: index of the robot and 9-element array to copy into
+ **************************************/
+void KalmanBank::getCovariance(int robot, float *covariance) {
+	covariance[0] = _row(KB_P00)[robot];
+	covariance[1] = _row(KB_P01)[robot];
+	covariance[2] = _row(KB_P02)[robot];
+	covariance[3] = covariance[1];
+	covariance[4] = _row(KB_P11)[robot];
+	covariance[5] = _row(KB_P12)[robot];
+	covariance[6] = covariance[2];
+	covariance[7] = covariance[5];
+	covariance[8] = _row(KB_P22)[robot];
+}
+
+/**************************************
+ * Definition: Copies out counters describing the numerical health
+ *             of a robot's covariance
+ *
+ * Parameters: index of the robot and a kalmanHealth struct to fill
+ **************************************/
+void KalmanBank::getHealth(int robot, kalmanHealth *health) {
+	*health = _health[robot];
+}
+
+/**************************************
+ * Definition: Returns the start of a field's row
+ *
+ * Parameters: field index (one of KB_*)
+ *
+ * Returns:    pointer to the row's first column
+ **************************************/
+float* KalmanBank::_row(int field) {
+	return &_data[field * _stride];
+}
+
+/**************************************
+ * Definition: Runs the prediction for robots [first, last) and then
+ *             the north star and wheel encoder corrections. This is
+ *             the same math as ExtendedKalmanFilter, one robot per
+ *             loop iteration with no branches
+ *
+ * Parameters: first robot, one past the last robot, and time step
+ **************************************/
+void KalmanBank::_step(int first, int last, float dt) {
+	float *x = _row(KB_X);
+	float *y = _row(KB_Y);
+	float *theta = _row(KB_THETA);
+	float *p00 = _row(KB_P00);
+	float *p01 = _row(KB_P01);
+	float *p02 = _row(KB_P02);
+	float *p11 = _row(KB_P11);
+	float *p12 = _row(KB_P12);
+	float *p22 = _row(KB_P22);
+	float *vf = _row(KB_VF);
+	float *vs = _row(KB_VS);
+	float *vw = _row(KB_VW);
+	float *q0 = _row(KB_Q0);
+	float *q1 = _row(KB_Q1);
+	float *q2 = _row(KB_Q2);
+
+	// the process noise is given per EKF_DEFAULT_DT step, like the
+	// extended kalman filter's
+	float noiseScale = dt / EKF_DEFAULT_DT;
+
+	for (int i = first; i < last; i++) {
+		// rotate by the heading halfway through the step
+		float heading = theta[i] + vw[i] * dt / 2.0f;
+		float c = cosf(heading);
+		float s = sinf(heading);
+
+		x[i] += (vf[i] * c - vs[i] * s) * dt;
+		y[i] += (vf[i] * s + vs[i] * c) * dt;
+		theta[i] = WRAP_THETA(theta[i] + vw[i] * dt);
+
+		// the jacobian is the identity plus a and b in the
+		// theta column, so F * P * F' expands to this
+		float a = (-vf[i] * s - vs[i] * c) * dt;
+		float b = (vf[i] * c - vs[i] * s) * dt;
+		float P02 = p02[i];
+		float P12 = p12[i];
+		float P22 = p22[i];
+
+		p00[i] += 2*a * P02 + a*a * P22 + q0[i] * noiseScale;
+		p01[i] += a * P12 + b * P02 + a*b * P22;
+		p02[i] += a * P22;
+		p11[i] += 2*b * P12 + b*b * P22 + q1[i] * noiseScale;
+		p12[i] += b * P22;
+		p22[i] += q2[i] * noiseScale;
+	}
+
+	_correct(first, last, KB_ZN0, KB_RN0, KB_MASK_NS);
+	_correct(first, last, KB_ZW0, KB_RW0, KB_MASK_WE);
+}
+
+/**************************************
+ * Definition: Corrects robots [first, last) with a direct pose
+ *             measurement. Robots whose mask is 0 (or whose
+ *             innovation is singular) get a zero gain and so are
+ *             left alone. Clears the mask afterwards
+ *
+ * Parameters: first robot, one past the last robot, and the first
+ *             measurement field, first noise field, and mask field
+ **************************************/
+void KalmanBank::_correct(int first, int last, int z, int r, int mask) {
+	float *x = _row(KB_X);
+	float *y = _row(KB_Y);
+	float *theta = _row(KB_THETA);
+	float *p00 = _row(KB_P00);
+	float *p01 = _row(KB_P01);
+	float *p02 = _row(KB_P02);
+	float *p11 = _row(KB_P11);
+	float *p12 = _row(KB_P12);
+	float *p22 = _row(KB_P22);
+	float *z0 = _row(z);
+	float *z1 = _row(z + 1);
+	float *z2 = _row(z + 2);
+	float *r0 = _row(r);
+	float *r1 = _row(r + 1);
+	float *r2 = _row(r + 2);
+	float *m = _row(mask);
+
+	for (int i = first; i < last; i++) {
+		float P00 = p00[i], P01 = p01[i], P02 = p02[i];
+		float P11 = p11[i], P12 = p12[i], P22 = p22[i];
+
+		// S = P + R, inverted through its (symmetric) cofactors
+		float s00 = P00 + r0[i];
+		float s11 = P11 + r1[i];
+		float s22 = P22 + r2[i];
+		float c00 = s11 * s22 - P12 * P12;
+		float c01 = P02 * P12 - P01 * s22;
+		float c02 = P01 * P12 - P02 * s11;
+		float c11 = s00 * s22 - P02 * P02;
+		float c12 = P01 * P02 - s00 * P12;
+		float c22 = s00 * s11 - P01 * P01;
+		float det = s00 * c00 + P01 * c01 + P02 * c02;
+
+		float usable = (m[i] != 0 && fabsf(det) >= 1e-12f) ? 1.0f : 0.0f;
+		_health[i].inversionFailures += (int)(m[i] - usable);
+		float invDet = usable / (usable != 0 ? det : 1.0f);
+		float i00 = c00 * invDet, i01 = c01 * invDet, i02 = c02 * invDet;
+		float i11 = c11 * invDet, i12 = c12 * invDet, i22 = c22 * invDet;
+
+		// K = P * S^-1
+		float k00 = P00 * i00 + P01 * i01 + P02 * i02;
+		float k01 = P00 * i01 + P01 * i11 + P02 * i12;
+		float k02 = P00 * i02 + P01 * i12 + P02 * i22;
+		float k10 = P01 * i00 + P11 * i01 + P12 * i02;
+		float k11 = P01 * i01 + P11 * i11 + P12 * i12;
+		float k12 = P01 * i02 + P11 * i12 + P12 * i22;
+		float k20 = P02 * i00 + P12 * i01 + P22 * i02;
+		float k21 = P02 * i01 + P12 * i11 + P22 * i12;
+		float k22 = P02 * i02 + P12 * i12 + P22 * i22;
+
+		float e0 = z0[i] - x[i];
+		float e1 = z1[i] - y[i];
+		float e2 = WRAP_ERROR(z2[i] - theta[i]);
+
+		x[i] += k00 * e0 + k01 * e1 + k02 * e2;
+		y[i] += k10 * e0 + k11 * e1 + k12 * e2;
+		float t = theta[i] + k20 * e0 + k21 * e1 + k22 * e2;
+		theta[i] = WRAP_THETA(t);
+
+		// P = P - K * P, which stays symmetric for this gain
+		p00[i] = P00 - (k00 * P00 + k01 * P01 + k02 * P02);
+		p01[i] = P01 - (k00 * P01 + k01 * P11 + k02 * P12);
+		p02[i] = P02 - (k00 * P02 + k01 * P12 + k02 * P22);
+		p11[i] = P11 - (k10 * P01 + k11 * P11 + k12 * P12);
+		p12[i] = P12 - (k10 * P02 + k11 * P12 + k12 * P22);
+		p22[i] = P22 - (k20 * P02 + k21 * P12 + k22 * P22);
+
+		m[i] = 0;
+	}
+}
+
+/**************************************
+ * Definition: Makes sure each robot's covariance is still positive
+ *             semi-definite (every leading minor >= 0), resetting it
+ *             to its clamped diagonal if not. The stored covariance
+ *             is symmetric by construction so it never needs
+ *             symmetrizing
+ *
+ * Parameters: first robot and one past the last robot
+ **************************************/
+void KalmanBank::_checkHealth(int first, int last) {
+	float *p00 = _row(KB_P00);
+	float *p01 = _row(KB_P01);
+	float *p02 = _row(KB_P02);
+	float *p11 = _row(KB_P11);
+	float *p12 = _row(KB_P12);
+	float *p22 = _row(KB_P22);
+
+	for (int i = first; i < last; i++) {
+		_health[i].steps++;
+
+		float scale = fmax(fabs(p00[i]), fmax(fabs(p11[i]), fabs(p22[i])));
+		float tolerance = -DEFINITENESS_TOLERANCE * scale;
+		float minor2 = p00[i] * p11[i] - p01[i] * p01[i];
+		float minor3 = p00[i] * (p11[i] * p22[i] - p12[i] * p12[i]) -
+		               p01[i] * (p01[i] * p22[i] - p12[i] * p02[i]) +
+		               p02[i] * (p01[i] * p12[i] - p11[i] * p02[i]);
+		if (p00[i] < tolerance || p11[i] < tolerance || p22[i] < tolerance ||
+		    minor2 < tolerance * scale || minor3 < tolerance * scale * scale) {
+			_health[i].definitenessRepairs++;
+			p01[i] = 0;
+			p02[i] = 0;
+			p12[i] = 0;
+			p00[i] = fmax(p00[i], 0);
+			p11[i] = fmax(p11[i], 0);
+			p22[i] = fmax(p22[i], 0);
+		}
+	}
+}
+
+KalmanBankFilter::KalmanBankFilter(KalmanBank *bank, int robot, Pose *initialPose)
+: KalmanFilter(initialPose), _bank(bank), _robot(robot), _deltaT(0), _hasFiltered(false) {
+	// the base constructor set our default uncertainties,
+	// so hand them to the bank before starting at the pose
+	_bank->setUncertainty(_robot, _uncertainties[0], _uncertainties[1], _uncertainties[2],
+	                      _uncertainties[3], _uncertainties[4], _uncertainties[5],
+	                      _uncertainties[6], _uncertainties[7], _uncertainties[8]);
+	_bank->reset(_robot, initialPose);
+	gettimeofday(&_lastFilterTime, NULL);
+}
+
+KalmanBankFilter::~KalmanBankFilter() {}
+
+/**************************************
+ * Definition: Steps this robot's column of the bank forward to now,
+ *             corrects it with the north star and wheel encoder
+ *             poses, and updates the stored pose. Only this column
+ *             is stepped (stepOne), so robots filtered one at a time
+ *             this way don't get the batched step. To batch them,
+ *             call setMeasurements for each and then the bank's step
+ *
+ * Parameters: a North Star pose and a Wheel Encoders Pose
+ **************************************/
+void KalmanBankFilter::filter(Pose *nsPose, Pose *wePose) {
+	float dt = Util::elapsedSeconds(&_lastFilterTime);
+	if (!_hasFiltered) {
+		dt = EKF_DEFAULT_DT;
+		_hasFiltered = true;
+	}
+	dt = fmin(fmax(dt, 0), EKF_MAX_DT);
+	if (_deltaT > 0) {
+		// an explicit time step overrides the measured one
+		dt = _deltaT;
+		_deltaT = 0;
+	}
+
+	_bank->setMeasurements(_robot, nsPose, wePose);
+	_bank->stepOne(_robot, dt);
+	_bank->getPose(_robot, _pose);
+}
+
+/**************************************
+ * Definition: Sets all of the uncertainties at once
+ *
+ * Parameters: process, north star, and wheel encoder
+ *             uncertainties for x, y, and theta
+ **************************************/
+void KalmanBankFilter::setUncertainty(float px, float py, float ptheta,
+                                      float nsx, float nsy, float nstheta,
+                                      float wex, float wey, float wetheta) {
+	setProcUncertainty(px, py, ptheta);
+	setNSUncertainty(nsx, nsy, nstheta);
+	setWEUncertainty(wex, wey, wetheta);
+}
+
+/**************************************
+ * Definition: Sets the north star measurement uncertainty
+ *
+ * Parameters: x, y, and theta uncertainties as floats
+ **************************************/
+void KalmanBankFilter::setNSUncertainty(float x, float y, float theta) {
+	KalmanFilter::setNSUncertainty(x, y, theta);
+	_bank->setNSUncertainty(_robot, x, y, theta);
+}
+
+/**************************************
+ * Definition: Sets the wheel encoder measurement uncertainty
+ *
+ * Parameters: x, y, and theta uncertainties as floats
+ **************************************/
+void KalmanBankFilter::setWEUncertainty(float x, float y, float theta) {
+	KalmanFilter::setWEUncertainty(x, y, theta);
+	_bank->setWEUncertainty(_robot, x, y, theta);
+}
+
+/**************************************
+ * Definition: Sets the process (model) uncertainty
+ *
+ * Parameters: x, y, and theta uncertainties as floats
+ **************************************/
+void KalmanBankFilter::setProcUncertainty(float x, float y, float theta) {
+	KalmanFilter::setProcUncertainty(x, y, theta);
+	_bank->setProcUncertainty(_robot, x, y, theta);
+}
+
+/**************************************
+ * Definition: Sets the velocity from global x and y speeds by
+ *             rotating them into the robot's frame
+ *
+ * Parameters: x, y, and theta speeds as floats
+ **************************************/
+void KalmanBankFilter::setVelocity(float x, float y, float theta) {
+	float heading = _bank->getTheta(_robot);
+	float forward = x * cos(heading) + y * sin(heading);
+	float strafe = -x * sin(heading) + y * cos(heading);
+
+	setBodyVelocity(forward, strafe, theta);
+}
+
+/**************************************
+ * Definition: Sets the velocity used by the motion model, in the
+ *             robot's frame
+ *
+ * Parameters: forward (cm/s), strafe left (cm/s), and theta (rad/s)
+ *             speeds as floats
+ **************************************/
+void KalmanBankFilter::setBodyVelocity(float forward, float strafe, float theta) {
+	_bank->setBodyVelocity(_robot, forward, strafe, theta);
+}
+
+/**************************************
+ * Definition: Forces the time step (in seconds) used by the next
+ *             call to filter, instead of the measured one
+ *
+ * Parameters: time step as a float
+ **************************************/
+void KalmanBankFilter::setTimeStep(float dt) {
+	_deltaT = dt;
+}
+
+/**************************************
+ * Definition: Copies out this robot's health counters
+ *
+ * Parameters: pointer to a kalmanHealth struct to fill
+ **************************************/
+void KalmanBankFilter::getHealth(kalmanHealth *health) {
+	_bank->getHealth(_robot, health);
+}
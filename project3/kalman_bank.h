@@ -0,0 +1,103 @@
+/**
+ * kalman_bank.h
+ *
+ * @brief
+ * 		This class holds the extended Kalman filter state for a whole fleet
+ *      of robots in structure-of-arrays form (every field is one
+ *      contiguous row with one column per robot), so a single step
+ *      predicts and corrects all of them in straight-line loops the
+ *      compiler can vectorize. KalmanBankFilter wraps one column so it
+ *      can be used anywhere a KalmanFilter is expected, but it steps
+ *      only its own column, so the batching comes from calling the
+ *      bank's step directly.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_KALMANBANK_H
+#define CS1567_KALMANBANK_H
+
+#include "kalman_filter.h"
+#include "pose.h"
+#include <sys/time.h>
+
+// rows are padded to a multiple of this many robots
+#define KALMAN_BANK_ALIGN 4
+
+// one row of the bank per field
+enum {
+	KB_X = 0, KB_Y, KB_THETA,
+	// covariance is symmetric so only the upper triangle is kept
+	KB_P00, KB_P01, KB_P02, KB_P11, KB_P12, KB_P22,
+	// body velocity: forward, strafe left, and turn
+	KB_VF, KB_VS, KB_VW,
+	KB_Q0, KB_Q1, KB_Q2,
+	KB_RN0, KB_RN1, KB_RN2,
+	KB_RW0, KB_RW1, KB_RW2,
+	KB_ZN0, KB_ZN1, KB_ZN2,
+	KB_ZW0, KB_ZW1, KB_ZW2,
+	// 1 if a measurement is waiting for the next step, 0 if not
+	KB_MASK_NS, KB_MASK_WE,
+	KB_NUM_FIELDS
+};
+
+class KalmanBank {
+public:
+	KalmanBank(int numRobots);
+	~KalmanBank();
+	int size();
+	void reset(int robot, Pose *pose);
+	void setUncertainty(int robot, float px, float py, float ptheta,
+	                    float nsx, float nsy, float nstheta,
+	                    float wex, float wey, float wetheta);
+	void setProcUncertainty(int robot, float x, float y, float theta);
+	void setNSUncertainty(int robot, float x, float y, float theta);
+	void setWEUncertainty(int robot, float x, float y, float theta);
+	void setBodyVelocity(int robot, float forward, float strafe, float theta);
+	void setMeasurements(int robot, Pose *nsPose, Pose *wePose);
+	void step(float dt);
+	void stepOne(int robot, float dt);
+	void getPose(int robot, Pose *pose);
+	float getTheta(int robot);
+	void getCovariance(int robot, float *covariance);
+	void getHealth(int robot, kalmanHealth *health);
+private:
+	int _numRobots;
+	int _stride;
+	float *_data;
+	kalmanHealth *_health;
+
+	float *_row(int field);
+	void _step(int first, int last, float dt);
+	void _correct(int first, int last, int z, int r, int mask);
+	void _checkHealth(int first, int last);
+};
+
+class KalmanBankFilter : public KalmanFilter {
+public:
+	KalmanBankFilter(KalmanBank *bank, int robot, Pose *initialPose);
+	~KalmanBankFilter();
+	void filter(Pose *nsPose, Pose *wePose);
+	void setUncertainty(float px, float py, float ptheta,
+	                    float nsx, float nsy, float nstheta,
+	                    float wex, float wey, float wetheta);
+	void setNSUncertainty(float x, float y, float theta);
+	void setWEUncertainty(float x, float y, float theta);
+	void setProcUncertainty(float x, float y, float theta);
+	void setVelocity(float x, float y, float theta);
+	void setBodyVelocity(float forward, float strafe, float theta);
+	void setTimeStep(float dt);
+	void getHealth(kalmanHealth *health);
+private:
+	KalmanBank *_bank;
+	int _robot;
+	float _deltaT;
+	bool _hasFiltered;
+	struct timeval _lastFilterTime;
+};
+
+#endif
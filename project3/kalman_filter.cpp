@@ -88,6 +88,42 @@ void KalmanFilter::setVelocity(float x, float y, float theta){
 	rovioKalmanFilterSetVelocity(&_kf, _velocity);
 }
 
+/**************************************
+ * Definition: Updates the Kalman velocity estimate from a velocity
+ *             given in the robot's frame, rotating it into the
+ *             global frame by the current theta estimate
+ *
+ * Parameters: forward, strafe (left), and theta speeds as floats
+ **************************************/
+void KalmanFilter::setBodyVelocity(float forward, float strafe, float theta) {
+	float heading = _pose->getTheta();
+	float x = forward * cos(heading) - strafe * sin(heading);
+	float y = forward * sin(heading) + strafe * cos(heading);
+
+	setVelocity(x, y, theta);
+}
+
+/**************************************
+ * Definition: Sets the time step the model moves the state along
+ *             its velocity by. The linear filter keeps using it
+ *             until it's changed (it starts at one)
+ *
+ * Parameters: time step as a float
+ **************************************/
+void KalmanFilter::setTimeStep(float dt) {
+	rovioKalmanFilterSetTimeStep(&_kf, dt);
+}
+
+/**************************************
+ * Definition: Copies out counters describing the numerical health
+ *             of the filter's covariance
+ *
+ * Parameters: pointer to a kalmanHealth struct to fill
+ **************************************/
+void KalmanFilter::getHealth(kalmanHealth *health) {
+	rovioKalmanFilterGetHealth(&_kf, health);
+}
+
 /**************************************
  * Definition: Updates all the Kalman uncertainties
  *
@@ -23,21 +23,25 @@ extern "C" {
 class KalmanFilter {
 public:
 	KalmanFilter(Pose *initialPose);
-	~KalmanFilter();
-	void filter(Pose *nsPose, Pose *wePose);
-	void setUncertainty(float px, float py, float ptheta,
-                        float nsx, float nsy, float nstheta,
-                        float wex, float wey, float wetheta);
-	void setNSUncertainty(float x, float y, float theta);
-	void setWEUncertainty(float x, float y, float theta);
-	void setProcUncertainty(float x, float y, float theta);
-	void setVelocity(float x, float y, float theta);
+	virtual ~KalmanFilter();
+	virtual void filter(Pose *nsPose, Pose *wePose);
+	virtual void setUncertainty(float px, float py, float ptheta,
+                                float nsx, float nsy, float nstheta,
+                                float wex, float wey, float wetheta);
+	virtual void setNSUncertainty(float x, float y, float theta);
+	virtual void setWEUncertainty(float x, float y, float theta);
+	virtual void setProcUncertainty(float x, float y, float theta);
+	virtual void setVelocity(float x, float y, float theta);
+	virtual void setBodyVelocity(float forward, float strafe, float theta);
+	virtual void setTimeStep(float dt);
+	virtual void getHealth(kalmanHealth *health);
+protected:
+	float _uncertainties[9];
+	Pose *_pose;
 private:
 	kalmanFilter _kf;
 	float _track[9];
 	float _velocity[3];
-	float _uncertainties[9];
-	Pose *_pose;
 };
 
 #endif
@@ -0,0 +1,173 @@
+/**
+ * kalman_smoother.cpp
+ *
+ * @brief
+ * 		This class runs an extended Kalman filter and records every
+ *      prediction and correction it makes, so a Rauch-Tung-Striebel
+ *      backward pass can refine each estimate with the measurements
+ *      that came after it. With a lag of 0 it keeps the whole run for
+ *      a fixed-interval smooth; with a lag of L it keeps only the last
+ *      L+1 steps and gives a fixed-lag estimate L steps behind.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#include "kalman_smoother.h"
+#include "utilities.h"
+#include <string.h>
+
+#define RC(i, j) ((i) * EKF_SIZE + (j))
+
+KalmanSmoother::KalmanSmoother(ExtendedKalmanFilter *filter, int lag) {
+	_filter = filter;
+	_lag = lag;
+}
+
+KalmanSmoother::~KalmanSmoother() {}
+
+/**************************************
+ * Definition: Filters the two poses and records the step. In
+ *             fixed-lag mode, also smooths the last lag steps and
+ *             forgets anything older
+ *
+ * Parameters: a North Star pose and a Wheel Encoders Pose
+ **************************************/
+void KalmanSmoother::filter(Pose *nsPose, Pose *wePose) {
+	SmootherStep step;
+
+	_filter->filter(nsPose, wePose);
+	_filter->getPrediction(step.predicted, step.predictedCovariance, step.jacobian);
+	_filter->getState(step.filtered);
+	_filter->getCovariance(step.filteredCovariance);
+	memcpy(step.smoothed, step.filtered, sizeof(step.smoothed));
+	memcpy(step.smoothedCovariance, step.filteredCovariance, sizeof(step.smoothedCovariance));
+	_steps.push_back(step);
+
+	if (_lag > 0) {
+		while ((int)_steps.size() > _lag + 1) {
+			_steps.pop_front();
+		}
+		_backward(0, _steps.size() - 1);
+	}
+}
+
+/**************************************
+ * Definition: Gets the fixed-lag estimate, which is for the step
+ *             lag steps before the latest one
+ *
+ * Parameters: the pose to update
+ *
+ * Returns:    false if there aren't lag steps yet (or the smoother
+ *             isn't in fixed-lag mode), true otherwise
+ **************************************/
+bool KalmanSmoother::getLagged(Pose *pose) {
+	if (_lag <= 0 || (int)_steps.size() < _lag + 1) {
+		return false;
+	}
+	getSmoothed(0, pose);
+	return true;
+}
+
+/**************************************
+ * Definition: Runs the backward pass over every recorded step
+ **************************************/
+void KalmanSmoother::smooth() {
+	if (_steps.empty()) {
+		return;
+	}
+	_backward(0, _steps.size() - 1);
+}
+
+/**************************************
+ * Definition: Returns the number of steps being kept
+ *
+ * Returns:    number of steps as an int
+ **************************************/
+int KalmanSmoother::getNumSteps() {
+	return _steps.size();
+}
+
+/**************************************
+ * Definition: Copies a step's smoothed estimate into a pose. Steps
+ *             count from the oldest one being kept
+ *
+ * Parameters: index of the step and the pose to update
+ **************************************/
+void KalmanSmoother::getSmoothed(int step, Pose *pose) {
+	pose->setX(_steps[step].smoothed[0]);
+	pose->setY(_steps[step].smoothed[1]);
+	pose->setTheta(_steps[step].smoothed[2]);
+}
+
+/**************************************
+ * Definition: Copies a step's smoothed 3x3 covariance (row major)
+ *
+ * Parameters: index of the step and 9-element array to copy into
+ **************************************/
+void KalmanSmoother::getSmoothedCovariance(int step, float *covariance) {
+	memcpy(covariance, _steps[step].smoothedCovariance,
+	       sizeof(_steps[step].smoothedCovariance));
+}
+
+/**************************************
+ * Definition: The Rauch-Tung-Striebel backward pass from step last
+ *             (whose smoothed estimate is its filtered one) down to
+ *             step first. Each step only looks at the one after it,
+ *             so this is linear in the number of steps
+ *
+ * Parameters: indices of the first and last steps
+ **************************************/
+void KalmanSmoother::_backward(int first, int last) {
+	SmootherStep *end = &_steps[last];
+	memcpy(end->smoothed, end->filtered, sizeof(end->smoothed));
+	memcpy(end->smoothedCovariance, end->filteredCovariance, sizeof(end->smoothedCovariance));
+
+	for (int k = last - 1; k >= first; k--) {
+		SmootherStep *step = &_steps[k];
+		SmootherStep *next = &_steps[k + 1];
+
+		// C = P(k|k) * F(k+1)' * P(k+1|k)^-1
+		float predictedInv[EKF_SIZE * EKF_SIZE];
+		if (!ExtendedKalmanFilter::invert3(next->predictedCovariance, predictedInv)) {
+			// can't do better than the filter here
+			memcpy(step->smoothed, step->filtered, sizeof(step->smoothed));
+			memcpy(step->smoothedCovariance, step->filteredCovariance,
+			       sizeof(step->smoothedCovariance));
+			continue;
+		}
+		float temp[EKF_SIZE * EKF_SIZE];
+		float gain[EKF_SIZE * EKF_SIZE];
+		ExtendedKalmanFilter::multiply3(step->filteredCovariance, next->jacobian, temp, true);
+		ExtendedKalmanFilter::multiply3(temp, predictedInv, gain, false);
+
+		// x(k|N) = x(k|k) + C * (x(k+1|N) - x(k+1|k))
+		float difference[EKF_SIZE];
+		for (int i = 0; i < EKF_SIZE; i++) {
+			difference[i] = next->smoothed[i] - next->predicted[i];
+		}
+		difference[2] = Util::normalizeThetaError(difference[2]);
+
+		for (int i = 0; i < EKF_SIZE; i++) {
+			step->smoothed[i] = step->filtered[i];
+			for (int j = 0; j < EKF_SIZE; j++) {
+				step->smoothed[i] += gain[RC(i, j)] * difference[j];
+			}
+		}
+		step->smoothed[2] = Util::normalizeTheta(step->smoothed[2]);
+
+		// P(k|N) = P(k|k) + C * (P(k+1|N) - P(k+1|k)) * C'
+		float covDifference[EKF_SIZE * EKF_SIZE];
+		for (int i = 0; i < EKF_SIZE * EKF_SIZE; i++) {
+			covDifference[i] = next->smoothedCovariance[i] - next->predictedCovariance[i];
+		}
+		ExtendedKalmanFilter::multiply3(gain, covDifference, temp, false);
+		ExtendedKalmanFilter::multiply3(temp, gain, step->smoothedCovariance, true);
+		for (int i = 0; i < EKF_SIZE * EKF_SIZE; i++) {
+			step->smoothedCovariance[i] += step->filteredCovariance[i];
+		}
+	}
+}
@@ -0,0 +1,54 @@
+/**
+ * kalman_smoother.h
+ *
+ * @brief
+ * 		This class runs an extended Kalman filter and records every
+ *      prediction and correction it makes, so a Rauch-Tung-Striebel
+ *      backward pass can refine each estimate with the measurements
+ *      that came after it. With a lag of 0 it keeps the whole run for
+ *      a fixed-interval smooth; with a lag of L it keeps only the last
+ *      L+1 steps and gives a fixed-lag estimate L steps behind.
+ *
+ * @author
+ * 		Shawn Hanna
+ * 		Tom Nason
+ * 		Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_KALMANSMOOTHER_H
+#define CS1567_KALMANSMOOTHER_H
+
+#include "extended_kalman_filter.h"
+#include "pose.h"
+#include <deque>
+
+typedef struct {
+	float predicted[EKF_SIZE];
+	float predictedCovariance[EKF_SIZE * EKF_SIZE];
+	float jacobian[EKF_SIZE * EKF_SIZE];
+	float filtered[EKF_SIZE];
+	float filteredCovariance[EKF_SIZE * EKF_SIZE];
+	float smoothed[EKF_SIZE];
+	float smoothedCovariance[EKF_SIZE * EKF_SIZE];
+} SmootherStep;
+
+class KalmanSmoother {
+public:
+	KalmanSmoother(ExtendedKalmanFilter *filter, int lag);
+	~KalmanSmoother();
+	void filter(Pose *nsPose, Pose *wePose);
+	bool getLagged(Pose *pose);
+	void smooth();
+	int getNumSteps();
+	void getSmoothed(int step, Pose *pose);
+	void getSmoothedCovariance(int step, float *covariance);
+private:
+	ExtendedKalmanFilter *_filter;
+	int _lag;
+	std::deque<SmootherStep> _steps;
+
+	void _backward(int first, int last);
+};
+
+#endif
@@ -0,0 +1,52 @@
+/* Kalman backend on CBLAS and (ATLAS) CLAPACK. Needs -lgslcblas and
+   -lclapack (or -llapack) at link time */
+#ifndef __KALMAN_BLAS_BACKEND_H__
+#define __KALMAN_BLAS_BACKEND_H__
+
+extern "C" {
+	#include <clapack.h>
+}
+#include "kalmanStep.h"
+
+/* pick the BLAS/LAPACK routines matching the covariance precision */
+#ifdef KALMAN_DOUBLE_COVARIANCE
+#define kf_gemm cblas_dgemm
+#define kf_getrf clapack_dgetrf
+#define kf_getri clapack_dgetri
+#else
+#define kf_gemm cblas_sgemm
+#define kf_getrf clapack_sgetrf
+#define kf_getri clapack_sgetri
+#endif
+
+struct KalmanBlasBackend {
+	static void multiply(kfcov *A, kfcov *B, kfcov *C) {
+		kf_gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, FILTER_SIZE, FILTER_SIZE, FILTER_SIZE, 1.0,
+			A, FILTER_SIZE, B, FILTER_SIZE, 0.0, C, FILTER_SIZE);
+	}
+
+	static void multiplyTransposed(kfcov *A, kfcov *B, kfcov *C) {
+		kf_gemm(CblasRowMajor, CblasNoTrans, CblasTrans, FILTER_SIZE, FILTER_SIZE, FILTER_SIZE, 1.0,
+			A, FILTER_SIZE, B, FILTER_SIZE, 0.0, C, FILTER_SIZE);
+	}
+
+	static void multiplyVector(kfcov *A, kfcov *x, kfcov *y) {
+		kf_gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, FILTER_SIZE, 1, FILTER_SIZE, 1.0,
+			A, FILTER_SIZE, x, 1, 0.0, y, 1);
+	}
+
+	static int invert(kfcov *S) {
+		int info;
+		int ipiv[MEAS_SIZE];
+
+		/* Invert S by first performing an LU Decomposition */
+		info = kf_getrf(CblasRowMajor, MEAS_SIZE, MEAS_SIZE, S, MEAS_SIZE, ipiv);
+		if(info != 0)
+			return info;
+
+		/* Now, invert given the LU decomposition */
+		return kf_getri(CblasRowMajor, MEAS_SIZE, S, MEAS_SIZE, ipiv);
+	}
+};
+
+#endif /* __KALMAN_BLAS_BACKEND_H__ */
@@ -0,0 +1,40 @@
+/* Kalman backend on Eigen's fixed-size expression templates. Header only;
+   needs the Eigen include directory (usually -I/usr/include/eigen3) */
+#ifndef __KALMAN_EIGEN_BACKEND_H__
+#define __KALMAN_EIGEN_BACKEND_H__
+
+#include "kalmanStep.h"
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+struct KalmanEigenBackend {
+	typedef Eigen::Matrix<kfcov, FILTER_SIZE, FILTER_SIZE, Eigen::RowMajor> Matrix;
+	typedef Eigen::Matrix<kfcov, FILTER_SIZE, 1> Vector;
+	typedef Eigen::Matrix<kfcov, MEAS_SIZE, MEAS_SIZE, Eigen::RowMajor> MeasMatrix;
+
+	static void multiply(kfcov *A, kfcov *B, kfcov *C) {
+		Eigen::Map<Matrix>(C).noalias() = Eigen::Map<Matrix>(A) * Eigen::Map<Matrix>(B);
+	}
+
+	static void multiplyTransposed(kfcov *A, kfcov *B, kfcov *C) {
+		Eigen::Map<Matrix>(C).noalias() = Eigen::Map<Matrix>(A) * Eigen::Map<Matrix>(B).transpose();
+	}
+
+	static void multiplyVector(kfcov *A, kfcov *x, kfcov *y) {
+		Eigen::Map<Vector>(y).noalias() = Eigen::Map<Matrix>(A) * Eigen::Map<Vector>(x);
+	}
+
+	static int invert(kfcov *S) {
+		Eigen::Map<MeasMatrix> s(S);
+		MeasMatrix inv;
+		bool invertible;
+
+		s.computeInverseWithCheck(inv, invertible, SINGULAR_TOLERANCE);
+		if(!invertible)
+			return 1;
+		s = inv;
+		return 0;
+	}
+};
+
+#endif /* __KALMAN_EIGEN_BACKEND_H__ */
@@ -26,35 +26,63 @@
 #define PROCESS_UNCERTAINTY_Y  0.05
 #define PROCESS_UNCERTAINTY_TH 0.05
 
+// define KALMAN_DOUBLE_COVARIANCE (for every file that includes this one) to
+// keep the covariance, and everything propagated along with it, in double precision.
+// the state and the interface stay in single precision either way
+#ifdef KALMAN_DOUBLE_COVARIANCE
+typedef double kfcov;
+#else
+typedef float kfcov;
+#endif
+
+// how far P may drift from symmetric (relative to its largest diagonal)
+// and from positive semi-definite before a step counts as needing repair
+#define SYMMETRY_TOLERANCE 1e-4
+#define DEFINITENESS_TOLERANCE 1e-6
+
+// counters describing the numerical health of the filter, updated every step
+typedef struct {
+  int steps;               // number of filter steps taken
+  int inversionFailures;   // times a gain could not be computed (singular P + R), so the sensor was skipped
+  int asymmetryRepairs;    // times P had drifted from symmetric beyond SYMMETRY_TOLERANCE
+  int definitenessRepairs; // times P was not positive semi-definite and was reset to its (clamped) diagonal
+} kalmanHealth;
+
 // the following structure defines the important matrices and constants that make up the filter
 typedef struct {
   // the first part of the filter definition is a set of diagonal matrixes loaded with the uncertainties
   // the matrices are diagonal in the first three elements, since velocity and acceleration are not measuure, uncertainty = 0
-  float Q[FILTER_SIZE * FILTER_SIZE];  // this is a diagonal matrix (over 1st three elements) with the process uncertainty
-  float R1[FILTER_SIZE * FILTER_SIZE]; // same here for the northstart
-  float R2[FILTER_SIZE * FILTER_SIZE]; // same here for the wheel encoders
+  kfcov Q[FILTER_SIZE * FILTER_SIZE];  // this is a diagonal matrix (over 1st three elements) with the process uncertainty
+  kfcov R1[FILTER_SIZE * FILTER_SIZE]; // same here for the northstart
+  kfcov R2[FILTER_SIZE * FILTER_SIZE]; // same here for the wheel encoders
   //
   // the Phi matrix encodes the linear equations of motion that govern the internal filter model of the robot
-  float Phi[FILTER_SIZE * FILTER_SIZE]; 
+  kfcov Phi[FILTER_SIZE * FILTER_SIZE]; 
   //
   // these hold the difference between the last prediction and the current measurements
   float residual_s1[FILTER_SIZE];
   float residual_s2[FILTER_SIZE];
   //
   // the W matrics (a.k.a) Kalman gain are the computed weight factors corresponding to each of the sensor measurements
-  float W1[FILTER_SIZE * FILTER_SIZE];
-  float W2[FILTER_SIZE * FILTER_SIZE];
+  kfcov W1[FILTER_SIZE * FILTER_SIZE];
+  kfcov W2[FILTER_SIZE * FILTER_SIZE];
 
   // this is the current internal state of the filter model .. it is also the current prediction
   float current_state[FILTER_SIZE];
   
   // this matrix is the statistical covariance of the overall system computed and updated at each step
-  float P[FILTER_SIZE * FILTER_SIZE]; 
+  kfcov P[FILTER_SIZE * FILTER_SIZE]; 
+
+  // counters for how often P needed repairing
+  kalmanHealth health;
 } kalmanFilter;
 
 void initKalmanFilter(kalmanFilter *, float *, float *,  int );
 void rovioKalmanFilter(kalmanFilter *, float *, float *, float *);
 void rovioKalmanFilterSetVelocity(kalmanFilter *,float *);
+void rovioKalmanFilterSetTimeStep(kalmanFilter *, float);
 void rovioKalmanFilterSetUncertainty(kalmanFilter *, float *);
+void rovioKalmanFilterCheckHealth(kalmanFilter *);
+void rovioKalmanFilterGetHealth(kalmanFilter *, kalmanHealth *);
 
 #endif
@@ -0,0 +1,69 @@
+/* Kalman backend with the FILTER_SIZE products written out by hand and
+   a cofactor inverse for the MEAS_SIZE block. Needs no libraries */
+#ifndef __KALMAN_FIXED_BACKEND_H__
+#define __KALMAN_FIXED_BACKEND_H__
+
+#include "kalmanStep.h"
+#include <math.h>
+
+/* row I of A dotted with column J of B, and with row J of B */
+#define DOT_COL(A,B,I,J) (\
+	A[ROWCOL(I,0)]*B[ROWCOL(0,J)] + A[ROWCOL(I,1)]*B[ROWCOL(1,J)] + A[ROWCOL(I,2)]*B[ROWCOL(2,J)] +\
+	A[ROWCOL(I,3)]*B[ROWCOL(3,J)] + A[ROWCOL(I,4)]*B[ROWCOL(4,J)] + A[ROWCOL(I,5)]*B[ROWCOL(5,J)] +\
+	A[ROWCOL(I,6)]*B[ROWCOL(6,J)] + A[ROWCOL(I,7)]*B[ROWCOL(7,J)] + A[ROWCOL(I,8)]*B[ROWCOL(8,J)])
+#define DOT_ROW(A,B,I,J) (\
+	A[ROWCOL(I,0)]*B[ROWCOL(J,0)] + A[ROWCOL(I,1)]*B[ROWCOL(J,1)] + A[ROWCOL(I,2)]*B[ROWCOL(J,2)] +\
+	A[ROWCOL(I,3)]*B[ROWCOL(J,3)] + A[ROWCOL(I,4)]*B[ROWCOL(J,4)] + A[ROWCOL(I,5)]*B[ROWCOL(J,5)] +\
+	A[ROWCOL(I,6)]*B[ROWCOL(J,6)] + A[ROWCOL(I,7)]*B[ROWCOL(J,7)] + A[ROWCOL(I,8)]*B[ROWCOL(J,8)])
+
+struct KalmanFixedBackend {
+	static void multiply(kfcov *A, kfcov *B, kfcov *C) {
+		int i, j;
+		for(i=0; i<FILTER_SIZE; i++)
+			for(j=0; j<FILTER_SIZE; j++)
+				C[ROWCOL(i,j)] = DOT_COL(A,B,i,j);
+	}
+
+	static void multiplyTransposed(kfcov *A, kfcov *B, kfcov *C) {
+		int i, j;
+		for(i=0; i<FILTER_SIZE; i++)
+			for(j=0; j<FILTER_SIZE; j++)
+				C[ROWCOL(i,j)] = DOT_ROW(A,B,i,j);
+	}
+
+	static void multiplyVector(kfcov *A, kfcov *x, kfcov *y) {
+		int i;
+		for(i=0; i<FILTER_SIZE; i++)
+			y[i] = A[ROWCOL(i,0)]*x[0] + A[ROWCOL(i,1)]*x[1] + A[ROWCOL(i,2)]*x[2] +
+			       A[ROWCOL(i,3)]*x[3] + A[ROWCOL(i,4)]*x[4] + A[ROWCOL(i,5)]*x[5] +
+			       A[ROWCOL(i,6)]*x[6] + A[ROWCOL(i,7)]*x[7] + A[ROWCOL(i,8)]*x[8];
+	}
+
+	static int invert(kfcov *S) {
+		kfcov c00 = S[4]*S[8] - S[5]*S[7];
+		kfcov c01 = S[5]*S[6] - S[3]*S[8];
+		kfcov c02 = S[3]*S[7] - S[4]*S[6];
+		kfcov det = S[0]*c00 + S[1]*c01 + S[2]*c02;
+		kfcov inv[MEAS_SIZE * MEAS_SIZE];
+		int i;
+
+		if(fabs(det) < SINGULAR_TOLERANCE)
+			return 1;
+
+		det = 1 / det;
+		inv[0] = c00 * det;
+		inv[1] = (S[2]*S[7] - S[1]*S[8]) * det;
+		inv[2] = (S[1]*S[5] - S[2]*S[4]) * det;
+		inv[3] = c01 * det;
+		inv[4] = (S[0]*S[8] - S[2]*S[6]) * det;
+		inv[5] = (S[2]*S[3] - S[0]*S[5]) * det;
+		inv[6] = c02 * det;
+		inv[7] = (S[1]*S[6] - S[0]*S[7]) * det;
+		inv[8] = (S[0]*S[4] - S[1]*S[3]) * det;
+		for(i=0; i<MEAS_SIZE*MEAS_SIZE; i++)
+			S[i] = inv[i];
+		return 0;
+	}
+};
+
+#endif /* __KALMAN_FIXED_BACKEND_H__ */
@@ -0,0 +1,137 @@
+/* The Kalman Redundant Sensors step, written once over a backend that
+   supplies the matrix math. A backend is a struct with these static members:
+
+     multiply(A, B, C)            C = A * B        (FILTER_SIZE square)
+     multiplyTransposed(A, B, C)  C = A * B'       (FILTER_SIZE square)
+     multiplyVector(A, x, y)      y = A * x        (FILTER_SIZE vector)
+     invert(S)                    S = S^-1 in place (MEAS_SIZE square),
+                                  returning 0 on success like LAPACK
+
+   See kalmanBlasBackend.h, kalmanFixedBackend.h and kalmanEigenBackend.h */
+#ifndef __KALMAN_STEP_H__
+#define __KALMAN_STEP_H__
+
+extern "C" {
+	#include "kalmanFilterDef.h"
+}
+#include <string.h>
+
+#define ROWCOL(I,J) (I*FILTER_SIZE+J)
+// the sensors measure x, y, and theta directly (the first three states)
+#define MEAS_SIZE 3
+// determinant below which the hand-written inverses call S singular
+#define SINGULAR_TOLERANCE 1e-12
+
+/* Compute the gain W = P * H' * (H * P * H' + R)^-1 for a sensor that
+   measures the first MEAS_SIZE states. Only that block of P + R is
+   inverted, since the velocity and acceleration rows of P + R are zero
+   and the full matrix is always singular. Returns the backend's info code
+   (0 on success), leaving W zero'd on failure so the sensor is skipped. */
+template <class Backend>
+int kalmanGain(kalmanFilter *kf, kfcov *R, kfcov *W) {
+	int i, j, k;
+	int info;
+	kfcov S[MEAS_SIZE * MEAS_SIZE];
+
+	memset(W, 0, sizeof(kfcov) * FILTER_SIZE * FILTER_SIZE);
+
+	/* S = P + R over the measured states */
+	for(i=0; i<MEAS_SIZE; i++)
+		for(j=0; j<MEAS_SIZE; j++)
+			S[i*MEAS_SIZE + j] = kf->P[ROWCOL(i,j)] + R[ROWCOL(i,j)];
+
+	info = Backend::invert(S);
+	if(info != 0)
+		return info;
+
+	/* W = P(:, measured) * S^-1 */
+	for(i=0; i<FILTER_SIZE; i++)
+		for(j=0; j<MEAS_SIZE; j++)
+			for(k=0; k<MEAS_SIZE; k++)
+				W[ROWCOL(i,j)] += kf->P[ROWCOL(i,k)] * S[k*MEAS_SIZE + j];
+
+	return 0;
+}
+
+/* out = (I - W) * P * (I - W)' + W * R * W' */
+template <class Backend>
+void kalmanJoseph(kfcov *W, kfcov *R, kfcov *P, kfcov *out) {
+	int i;
+	kfcov IminusW[FILTER_SIZE * FILTER_SIZE];
+	kfcov temp[FILTER_SIZE * FILTER_SIZE];
+	kfcov temp2[FILTER_SIZE * FILTER_SIZE];
+
+	for(i=0; i<FILTER_SIZE*FILTER_SIZE; i++)
+		IminusW[i] = -W[i];
+	for(i=0; i<FILTER_SIZE; i++)
+		IminusW[ROWCOL(i,i)] += 1;
+
+	Backend::multiply(IminusW, P, temp);
+	Backend::multiplyTransposed(temp, IminusW, out);
+
+	Backend::multiply(W, R, temp);
+	Backend::multiplyTransposed(temp, W, temp2);
+	for(i=0; i<FILTER_SIZE*FILTER_SIZE; i++)
+		out[i] += temp2[i];
+}
+
+/* One full filter step: propagate, compute both gains, update the
+   estimate and the covariance, then keep P healthy */
+template <class Backend>
+void kalmanStep(kalmanFilter *kf, float *meas_S1, float *meas_S2, float *predicted) {
+	int i, j;
+
+	kfcov temp[FILTER_SIZE * FILTER_SIZE];
+	kfcov temp2[FILTER_SIZE * FILTER_SIZE];
+	kfcov new_state[FILTER_SIZE];
+	kfcov state[FILTER_SIZE];
+
+	/**** 2. Propagate the Covariance Matrix ****/
+	/* P = Phi * P * Phi' + Q */
+	Backend::multiply(kf->Phi, kf->P, temp2);
+	Backend::multiplyTransposed(temp2, kf->Phi, temp);
+	for(i=0; i<FILTER_SIZE*FILTER_SIZE; i++)
+		kf->P[i] = temp[i] + kf->Q[i];
+
+	/**** 3. Propagate the model track estimate ****/
+	/* new_state = Phi * current_state */
+	for(i=0; i<FILTER_SIZE; i++)
+		state[i] = kf->current_state[i];
+	Backend::multiplyVector(kf->Phi, state, new_state);
+
+	for(i=0; i<3; i++) {
+	  kf->residual_s1[i] = meas_S1[i] - new_state[i];
+	  kf->residual_s2[i] = meas_S2[i] - new_state[i];
+	}
+	for(i=3; i<9; i++) {
+	  kf->residual_s1[i] = 0;
+	  kf->residual_s2[i] = 0;
+	}
+
+	/**** 4-5. Compute the gains, skipping a sensor if its gain can't be computed ****/
+	if(kalmanGain<Backend>(kf, kf->R1, kf->W1) != 0)
+		kf->health.inversionFailures++;
+	if(kalmanGain<Backend>(kf, kf->R2, kf->W2) != 0)
+		kf->health.inversionFailures++;
+
+	/**** 6. Update the estimate ****/
+	/* predicted = new_state + W1 * residual_s1' + W2 * residual_s2' */
+	for(i=0; i<FILTER_SIZE; i++) {
+		kfcov correction = 0;
+		for(j=0; j<FILTER_SIZE; j++)
+			correction += kf->W1[ROWCOL(i,j)] * kf->residual_s1[j] + kf->W2[ROWCOL(i,j)] * kf->residual_s2[j];
+		predicted[i] = new_state[i] + correction;
+		kf->current_state[i] = predicted[i];
+	}
+
+	/* P = Joseph(W1, R1) + Joseph(W2, R2), both from the propagated P */
+	kalmanJoseph<Backend>(kf->W1, kf->R1, kf->P, temp);
+	kalmanJoseph<Backend>(kf->W2, kf->R2, kf->P, temp2);
+	for(i=0; i<FILTER_SIZE*FILTER_SIZE; i++)
+		kf->P[i] = temp[i] + temp2[i];
+
+	/**** 7. Keep P symmetric positive semi-definite ****/
+	rovioKalmanFilterCheckHealth(kf);
+}
+
+#endif /* __KALMAN_STEP_H__ */
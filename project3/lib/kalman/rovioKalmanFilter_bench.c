@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "kalmanBlasBackend.h"
+#include "kalmanFixedBackend.h"
+#include "kalmanEigenBackend.h"
+#define MAX_SAMPLES 1024
+#define DEFAULT_REPS 2000
+
+/* runs the whole data set through a fresh filter reps times with the
+   given backend, leaving the last track in tracks. returns usec per step */
+template <class Backend>
+double bench(float NSdata[][3], float WEdata[][3], int samples, int reps, float tracks[][3]) {
+  kalmanFilter kf;
+  float initPose[3];
+  float vel[3] = { 350.0/54.0, 0, 0 };
+  float track[9];
+  struct timeval start, end;
+  int r, i;
+
+  for(i=0; i<3; i++)
+    initPose[i] = (NSdata[0][i] + WEdata[0][i])/2;
+
+  gettimeofday(&start, NULL);
+  for(r=0; r<reps; r++) {
+    initKalmanFilter(&kf, initPose, vel, 1);
+    for(i=1; i<samples; i++) {
+      kalmanStep<Backend>(&kf, NSdata[i], WEdata[i], track);
+      tracks[i][0] = track[0];
+      tracks[i][1] = track[1];
+      tracks[i][2] = track[2];
+    }
+  }
+  gettimeofday(&end, NULL);
+
+  return ((end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_usec - start.tv_usec)) /
+         ((double)reps * (samples - 1));
+}
+
+/* largest difference between two tracks */
+double difference(float a[][3], float b[][3], int samples) {
+  double worst = 0;
+  int i, j;
+  for(i=1; i<samples; i++)
+    for(j=0; j<3; j++)
+      if(fabs(a[i][j] - b[i][j]) > worst)
+        worst = fabs(a[i][j] - b[i][j]);
+  return worst;
+}
+
+int main(int argc, char **argv)
+{
+  static float NSdata[MAX_SAMPLES][3];
+  static float WEdata[MAX_SAMPLES][3];
+  static float blasTrack[MAX_SAMPLES][3];
+  static float fixedTrack[MAX_SAMPLES][3];
+  static float eigenTrack[MAX_SAMPLES][3];
+  FILE *NS, *WE;
+  char fname[256];
+  int samples, reps;
+  double blas, fixed, eigen;
+
+  if(argc < 2) {
+    printf("usage %s <filename-prefix> [repetitions]\n",argv[0]);
+    return 0;
+  }
+  reps = argc > 2 ? atoi(argv[2]) : DEFAULT_REPS;
+
+  sprintf(fname,"%s-NS.csv",argv[1]);
+  if( (NS = fopen(fname, "r")) == NULL) return -1;
+  sprintf(fname,"%s-WE.csv",argv[1]);
+  if( (WE = fopen(fname, "r")) == NULL) return -1;
+
+  for(samples=0; samples<MAX_SAMPLES; samples++) {
+    if(fscanf(NS, "%f,%f,%f", &NSdata[samples][0], &NSdata[samples][1], &NSdata[samples][2]) < 3) break;
+    if(fscanf(WE, "%f,%f,%f", &WEdata[samples][0], &WEdata[samples][1], &WEdata[samples][2]) < 3) break;
+  }
+  fclose(NS);
+  fclose(WE);
+
+  if(samples < 2) {
+    printf("not enough samples in %s\n", argv[1]);
+    return -1;
+  }
+
+  blas = bench<KalmanBlasBackend>(NSdata, WEdata, samples, reps, blasTrack);
+  fixed = bench<KalmanFixedBackend>(NSdata, WEdata, samples, reps, fixedTrack);
+  eigen = bench<KalmanEigenBackend>(NSdata, WEdata, samples, reps, eigenTrack);
+
+  printf("%d samples, %d repetitions, %s covariance\n", samples, reps,
+         sizeof(kfcov) == sizeof(double) ? "double" : "float");
+  printf("backend\tusec/step\tspeedup\tmax difference from blas\n");
+  printf("blas\t%f\t%f\t%f\n", blas, 1.0, 0.0);
+  printf("fixed\t%f\t%f\t%f\n", fixed, blas / fixed, difference(blasTrack, fixedTrack, samples));
+  printf("eigen\t%f\t%f\t%f\n", eigen, blas / eigen, difference(blasTrack, eigenTrack, samples));
+
+  return 0;
+}
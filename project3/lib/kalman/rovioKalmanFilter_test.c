@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>
-#include "kalmanFilterDef.h"
+extern "C" {
+	#include "kalmanFilterDef.h"
+}
 #define LINE_SZ	256
 
 
@@ -17,6 +19,7 @@ int main(int argc,  char **argv)
   char fname[256];
 
   float track[9];
+  kalmanHealth health;
   float NSdata[3];
   float WEdata[3];
 
@@ -59,6 +62,10 @@ int main(int argc,  char **argv)
     }
   }
   
+  rovioKalmanFilterGetHealth(&kf, &health);
+  printf("%d steps: %d failed inversions, %d asymmetric, %d not positive semi-definite\n",
+         health.steps, health.inversionFailures, health.asymmetryRepairs, health.definitenessRepairs);
+
   fclose(NS);
   fclose(WE);
   fclose(TR);
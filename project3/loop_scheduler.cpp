@@ -0,0 +1,194 @@
+/**
+ * loop_scheduler.cpp
+ *
+ * @brief
+ *      Paces a control loop at a fixed rate on the monotonic clock.
+ *      Each pass through the loop calls wait, which sleeps until the
+ *      next tick and returns the real time since the last one, so the
+ *      PID and kalman filter can use the actual dt. A pass that runs
+ *      past its deadline is counted as a miss and the schedule starts
+ *      over from then (rather than running several passes back to back
+ *      to catch up), and how late each wake up is gets tracked as jitter
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "loop_scheduler.h"
+
+#include <stdio.h>
+#include <errno.h>
+
+#ifdef USE_SIMULATOR
+#include "data/fakerobot/sim_clock.h"
+#endif
+
+/**************************************
+ * Definition: Sets up a scheduler for a loop
+ *
+ * Parameters: passes per second
+ **************************************/
+LoopScheduler::LoopScheduler(float rate)
+: _period(1.0 / rate), _started(false), _ticks(0), _misses(0),
+  _totalJitter(0), _maxJitter(0) {}
+
+/**************************************
+ * Definition: Starts the schedule and its stats over from now. Call
+ *             before entering a loop, so the time spent outside of
+ *             it doesn't count as a miss, and the stats are only
+ *             this loop's
+ **************************************/
+void LoopScheduler::start() {
+    clock_gettime(CLOCK_MONOTONIC, &_last);
+    _next = _last;
+    _started = false;
+    _ticks = 0;
+    _misses = 0;
+    _totalJitter = 0;
+    _maxJitter = 0;
+}
+
+/**************************************
+ * Definition: Sleeps until the next tick
+ *
+ * Returns:    the seconds since the last tick (the period on the
+ *             first one after start)
+ **************************************/
+float LoopScheduler::wait() {
+#ifdef USE_SIMULATOR
+    // the simulated clock never runs late, so every tick is a period
+    if (!_started) {
+        _started = true;
+        return _period;
+    }
+    SimClock::advance(_period);
+    _ticks++;
+    return _period;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (!_started) {
+        // the first pass runs right away
+        _started = true;
+        _last = now;
+        _next = now;
+        _add(&_next, _period);
+        return _period;
+    }
+
+    if (_seconds(&_next, &now) > 0) {
+        // we're already late, so go now and start the schedule
+        // over instead of trying to catch up
+        _misses++;
+        _next = now;
+    }
+    else {
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &_next, NULL) == EINTR) {
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        double jitter = _seconds(&_next, &now);
+        _totalJitter += jitter;
+        if (jitter > _maxJitter) {
+            _maxJitter = jitter;
+        }
+    }
+    _ticks++;
+    _add(&_next, _period);
+
+    float dt = _seconds(&_last, &now);
+    _last = now;
+    return dt;
+#endif
+}
+
+/**************************************
+ * Definition: Returns the time between ticks
+ *
+ * Returns:    the period in seconds
+ **************************************/
+float LoopScheduler::getPeriod() {
+    return _period;
+}
+
+/**************************************
+ * Definition: Returns how many ticks have been waited for (not
+ *             counting the first after each start)
+ *
+ * Returns:    an int with the number of ticks
+ **************************************/
+int LoopScheduler::getTicks() {
+    return _ticks;
+}
+
+/**************************************
+ * Definition: Returns how many ticks started late because the
+ *             pass before ran past its deadline
+ *
+ * Returns:    an int with the number of misses
+ **************************************/
+int LoopScheduler::getMisses() {
+    return _misses;
+}
+
+/**************************************
+ * Definition: Returns how late the ticks that weren't missed woke
+ *             up, on average
+ *
+ * Returns:    the mean jitter in seconds
+ **************************************/
+float LoopScheduler::getMeanJitter() {
+    int onTime = _ticks - _misses;
+    return onTime > 0 ? _totalJitter / onTime : 0;
+}
+
+/**************************************
+ * Definition: Returns the latest any tick that wasn't missed
+ *             woke up
+ *
+ * Returns:    the max jitter in seconds
+ **************************************/
+float LoopScheduler::getMaxJitter() {
+    return _maxJitter;
+}
+
+/**************************************
+ * Definition: Prints the tick, miss, and jitter counts
+ *
+ * Parameters: a name for the loop
+ **************************************/
+void LoopScheduler::printStats(const char *name) {
+    printf("%s loop: %d ticks at %.1f Hz, %d missed deadlines, jitter %.2f ms mean %.2f ms max\n",
+           name, _ticks, 1.0 / _period, _misses,
+           getMeanJitter() * 1000, getMaxJitter() * 1000);
+}
+
+/**************************************
+ * Definition: Returns the seconds from one time to another
+ *
+ * Parameters: the earlier and later times
+ *
+ * Returns:    seconds as a double (negative if "to" is earlier)
+ **************************************/
+double LoopScheduler::_seconds(struct timespec *from, struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/**************************************
+ * Definition: Moves a time forward
+ *
+ * Parameters: the time and how many seconds to add
+ **************************************/
+void LoopScheduler::_add(struct timespec *time, double seconds) {
+    long whole = (long) seconds;
+    time->tv_sec += whole;
+    time->tv_nsec += (long) ((seconds - whole) * 1e9);
+    while (time->tv_nsec >= 1000000000L) {
+        time->tv_nsec -= 1000000000L;
+        time->tv_sec++;
+    }
+}
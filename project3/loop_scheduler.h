@@ -0,0 +1,51 @@
+/**
+ * loop_scheduler.h
+ *
+ * @brief
+ *      Paces a control loop at a fixed rate on the monotonic clock.
+ *      Each pass through the loop calls wait, which sleeps until the
+ *      next tick and returns the real time since the last one, so the
+ *      PID and kalman filter can use the actual dt. A pass that runs
+ *      past its deadline is counted as a miss and the schedule starts
+ *      over from then (rather than running several passes back to back
+ *      to catch up), and how late each wake up is gets tracked as jitter
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_LOOPSCHEDULER_H
+#define CS1567_LOOPSCHEDULER_H
+
+#include <time.h>
+
+class LoopScheduler {
+public:
+    LoopScheduler(float rate);
+    void start();
+    float wait();
+    float getPeriod();
+    int getTicks();
+    int getMisses();
+    float getMeanJitter();
+    float getMaxJitter();
+    void printStats(const char *name);
+private:
+    double _period;
+    struct timespec _next;
+    struct timespec _last;
+    bool _started;
+
+    int _ticks;
+    int _misses;
+    double _totalJitter;
+    double _maxJitter;
+
+    static double _seconds(struct timespec *from, struct timespec *to);
+    static void _add(struct timespec *time, double seconds);
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * mailbox.h
+ *
+ * @brief
+ *      A single value handed from exactly one thread to exactly one other
+ *      without locking, where only the newest value matters. A new value
+ *      replaces one that hasn't been taken yet, so the consumer always
+ *      gets the latest and the producer never waits or gets turned away.
+ *      It's a triple buffer: the producer writes its own slot and then
+ *      swaps it with the shared one in one atomic exchange, and the
+ *      consumer swaps its own slot for the shared one the same way
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_MAILBOX_H
+#define CS1567_MAILBOX_H
+
+// set on the shared slot's index when it holds a value not yet taken
+#define MAILBOX_FRESH 4
+
+template <typename T>
+class Mailbox {
+public:
+    Mailbox();
+    void put(const T &value);
+    bool take(T *value);
+    int getReplaced();
+private:
+    T _slots[3];
+    // the producer's slot, the shared one (with MAILBOX_FRESH), and
+    // the consumer's. between them they always name all three slots
+    int _back;
+    volatile int _middle;
+    int _front;
+    // values replaced before they were taken (producer's)
+    volatile int _replaced;
+};
+
+template <typename T>
+Mailbox<T>::Mailbox()
+: _back(0), _middle(1), _front(2), _replaced(0) {}
+
+/**************************************
+ * Definition: Leaves a value for the consumer, replacing any it
+ *             hasn't taken yet. Only the producer thread may call this
+ *
+ * Parameters: the value
+ **************************************/
+template <typename T>
+void Mailbox<T>::put(const T &value) {
+    _slots[_back] = value;
+    // the slot has to be written before the consumer can see it
+    __sync_synchronize();
+    int old = __sync_lock_test_and_set(&_middle, _back | MAILBOX_FRESH);
+    _back = old & ~MAILBOX_FRESH;
+    if (old & MAILBOX_FRESH) {
+        _replaced++;
+    }
+}
+
+/**************************************
+ * Definition: Takes the newest value, if there's one that hasn't
+ *             been taken. Only the consumer thread may call this
+ *
+ * Parameters: where to put the value
+ *
+ * Returns: false (leaving value alone) if nothing new was left
+ **************************************/
+template <typename T>
+bool Mailbox<T>::take(T *value) {
+    if (!(_middle & MAILBOX_FRESH)) {
+        return false;
+    }
+    int old = __sync_lock_test_and_set(&_middle, _front);
+    _front = old & ~MAILBOX_FRESH;
+    // don't read the slot until we've seen the index that published it
+    __sync_synchronize();
+    *value = _slots[_front];
+    return true;
+}
+
+/**************************************
+ * Definition: Returns how many values were replaced by newer ones
+ *             before the consumer took them
+ *
+ * Returns: an int with the count
+ **************************************/
+template <typename T>
+int Mailbox<T>::getReplaced() {
+    return _replaced;
+}
+
+#endif
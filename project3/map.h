@@ -16,7 +16,7 @@
 #ifndef CS1567_MAP_H
 #define CS1567_MAP_H
 
-#include <robot_if++.h>
+#include "robot_interface.h"
 #include "cell.h"
 
 // game map size in cells
@@ -30,17 +30,37 @@ MapStrategy::~MapStrategy() {
  * Returns:    pointer to cell
  **************************************/
 Cell* MapStrategy::nextCell() {
+	Path *path = nextPath();
+	if (path == NULL) {
+		return NULL;
+	}
+
+	Cell *cell = path->getFirstCell();
+	delete path;
+	return cell;
+}
+
+/**************************************
+ * Definition: Returns the whole best path from the cell our
+ *             robot is in (which is the path's first cell)
+ *
+ * Returns:    pointer to a path the caller must delete, or
+ *             NULL if there's nothing worth going for
+ **************************************/
+Path* MapStrategy::nextPath() {
 	_map->update();
 
 	Path *path = _getBestPath(PATH_LENGTH);
 	if (path == NULL || path->getValue() == 0) {
+		delete path;
 		path = _getBestPath(10);
 		if (path == NULL || path->getValue() == 0) {
+			delete path;
 			return NULL;
 		}
 	}
 
-	return path->getFirstCell();
+	return path;
 }
 
 /**************************************
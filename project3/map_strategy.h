@@ -27,6 +27,7 @@ public:
 	MapStrategy(Map *map);
 	~MapStrategy();
 	Cell* nextCell();
+	Path* nextPath();
 	
 private:
 	Map *_map;
@@ -0,0 +1,177 @@
+/**
+ * motion_profile.cpp
+ *
+ * @brief
+ *      Plans trapezoidal speed profiles for moves and turns. Each control
+ *      loop pass gives it how far is left to go, and it ramps up at a
+ *      limited acceleration, cruises at the fastest speed the robot has,
+ *      and ramps down so it can stop right where it should. The speed it
+ *      wants is then turned into the integer robot speed (from one of the
+ *      measured speed tables) that goes as fast as it can without going
+ *      faster than that
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "motion_profile.h"
+#include "constants.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/**************************************
+ * Definition: Sets up a profile with no speed table, at rest
+ *
+ * Parameters: the most we can speed up and slow down (units per
+ *             second per second, in whatever units the table is)
+ **************************************/
+MotionProfile::MotionProfile(float maxAccel, float maxDecel)
+: _maxAccel(maxAccel), _maxDecel(maxDecel), _speeds(NULL),
+  _speedStride(1), _pulses(NULL), _velocity(0) {}
+
+/**************************************
+ * Definition: Sets the robot's speed at each integer robot speed
+ *             (like SPEED_FORWARD, or one column of SPEED_TURN)
+ *
+ * Parameters: NUM_SPEEDS speeds every stride floats apart, and
+ *             the stride
+ **************************************/
+void MotionProfile::setSpeeds(const float *speeds, int stride) {
+    _speeds = speeds;
+    _speedStride = stride;
+}
+
+/**************************************
+ * Definition: Sets how long the robot moves for each time it's told
+ *             to, for commands that stop on their own (like Robot's
+ *             turns). A pass that's longer than that only covers
+ *             the table speed for part of it
+ *
+ * Parameters: seconds at each integer robot speed, or NULL if the
+ *             robot keeps going until the next command
+ **************************************/
+void MotionProfile::setPulses(const float *pulses) {
+    _pulses = pulses;
+}
+
+/**************************************
+ * Definition: Starts a new move from rest
+ **************************************/
+void MotionProfile::start() {
+    _velocity = 0;
+}
+
+/**************************************
+ * Definition: Finds the speed we want to be going this pass: no
+ *             faster than we can get to from the last pass, than
+ *             the robot can go, than we can still stop from in
+ *             the distance that's left, or than covers all of it
+ *             in one pass. The command we send now won't take
+ *             effect until the next pass, so what we'll cover
+ *             until then comes off the distance first
+ *
+ * Parameters: how far is left to go (ignoring its sign) and the
+ *             seconds since the last pass
+ *
+ * Returns:    the speed we want, or 0 to stop
+ **************************************/
+float MotionProfile::velocity(float remaining, float dt) {
+    if (dt <= 0) {
+        dt = CONTROL_LOOP_PERIOD;
+    }
+
+    float stopping = fabs(remaining) - _velocity * dt;
+    if (stopping <= 0) {
+        return 0;
+    }
+
+    float fastest = 0;
+    for (int s = 1; s < NUM_SPEEDS; s++) {
+        fastest = fmax(fastest, _passSpeed(s, dt));
+    }
+
+    float velocity = _velocity + _maxAccel * dt;
+    velocity = fmin(velocity, fastest);
+    velocity = fmin(velocity, sqrt(2 * _maxDecel * stopping));
+    // passes can be long (a turn pulse and the wait after it), and
+    // one pass shouldn't take us past where we're stopping
+    velocity = fmin(velocity, stopping / dt);
+    return velocity;
+}
+
+/**************************************
+ * Definition: Finds the integer robot speed to go this pass (see
+ *             velocity). That's the fastest speed in the table
+ *             that isn't faster than we want, or the slowest one
+ *             if they all are, since the robot can't go slower
+ *
+ * Parameters: how far is left to go and the seconds since the
+ *             last pass
+ *
+ * Returns:    a robot speed from 1 (fastest) to 10, or 0 to stop
+ **************************************/
+int MotionProfile::speed(float remaining, float dt) {
+    if (dt <= 0) {
+        dt = CONTROL_LOOP_PERIOD;
+    }
+    float wanted = velocity(remaining, dt);
+    if (wanted <= 0 || _speeds == NULL) {
+        _velocity = 0;
+        return 0;
+    }
+
+    int best = 0;
+    int slowest = 0;
+    for (int s = 1; s < NUM_SPEEDS; s++) {
+        float speed = _passSpeed(s, dt);
+        if (speed <= wanted && (best == 0 || speed > _passSpeed(best, dt))) {
+            best = s;
+        }
+        if (slowest == 0 || speed < _passSpeed(slowest, dt)) {
+            slowest = s;
+        }
+    }
+    if (best == 0) {
+        best = slowest;
+    }
+
+    _velocity = _passSpeed(best, dt);
+    return best;
+}
+
+/**************************************
+ * Definition: Returns the speed we've been going
+ *
+ * Returns:    the average speed over the last pass (or 0 at rest)
+ **************************************/
+float MotionProfile::getVelocity() {
+    return _velocity;
+}
+
+float MotionProfile::_tableSpeed(int speed) {
+    if (_speeds == NULL) {
+        return 0;
+    }
+    return fabs(_speeds[speed * _speedStride]);
+}
+
+/**************************************
+ * Definition: Finds how fast a speed gets us along on average over
+ *             a pass, which is its table speed unless the command
+ *             stops on its own partway through
+ *
+ * Parameters: the integer robot speed and the pass's length
+ *
+ * Returns:    the average speed over the pass
+ **************************************/
+float MotionProfile::_passSpeed(int speed, float dt) {
+    float tableSpeed = _tableSpeed(speed);
+    if (_pulses == NULL || _pulses[speed] >= dt) {
+        return tableSpeed;
+    }
+    return tableSpeed * _pulses[speed] / dt;
+}
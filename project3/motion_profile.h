@@ -0,0 +1,48 @@
+/**
+ * motion_profile.h
+ *
+ * @brief
+ *      Plans trapezoidal speed profiles for moves and turns. Each control
+ *      loop pass gives it how far is left to go, and it ramps up at a
+ *      limited acceleration, cruises at the fastest speed the robot has,
+ *      and ramps down so it can stop right where it should. The speed it
+ *      wants is then turned into the integer robot speed (from one of the
+ *      measured speed tables) that goes as fast as it can without going
+ *      faster than that
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_MOTIONPROFILE_H
+#define CS1567_MOTIONPROFILE_H
+
+class MotionProfile {
+public:
+    MotionProfile(float maxAccel, float maxDecel);
+    void setSpeeds(const float *speeds, int stride);
+    void setPulses(const float *pulses);
+    void start();
+    float velocity(float remaining, float dt);
+    int speed(float remaining, float dt);
+    float getVelocity();
+private:
+    float _maxAccel;
+    float _maxDecel;
+    const float *_speeds;
+    int _speedStride;
+    // how long each command actually moves for at each speed before
+    // it stops on its own (seconds), or NULL if it keeps going
+    const float *_pulses;
+    // the speed we've been going (from the table), which the next
+    // pass ramps from
+    float _velocity;
+
+    float _tableSpeed(int speed);
+    float _passSpeed(int speed, float dt);
+};
+
+#endif
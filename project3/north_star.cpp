@@ -16,27 +16,53 @@
  **/
 
 #include "north_star.h"
+#include "fir_bank.h"
+#include "iir_bank.h"
 #include "constants.h"
 #include "logger.h"
 #include "utilities.h"
 #include "robot.h"
  
 NorthStar::NorthStar(Robot *robot)
-: PositionSensor(robot), _oldX(), _oldY() {
+: PositionSensor(robot) {
 	_lastRoom = -1;
+	_hasTheta = false;
+	_unwrappedTheta = 0;
+	_lastRawTheta = 0;
+
+	// the calibration file overrides constants.h for any rooms it has
+	NSCalibration calibration(robot->getName());
+	calibration.load(NS_CALIBRATION_FILE);
+	for (int room = 0; room < NUM_ROOMS; room++) {
+		_transforms[room].set(room, calibration.getRoom(room));
+	}
 
-	_filterX = new FIRFilter("filters/ns_x.ffc");
-	_filterY = new FIRFilter("filters/ns_y.ffc");
-	_filterTheta = new FIRFilter("filters/ns_theta.ffc");
+	if (NS_FILTER == FILTER_FIR) {
+		std::vector<std::string> fileNames(NUM_CHANNELS);
+		fileNames[CHANNEL_X] = "filters/ns_x.ffc";
+		fileNames[CHANNEL_Y] = "filters/ns_y.ffc";
+		fileNames[CHANNEL_THETA] = "filters/ns_theta.ffc";
+		_filters = new FIRBank(&fileNames);
+	}
+	else {
+		_filters = new IIRBank(NUM_CHANNELS, NS_FILTER, NS_IIR_CUTOFF);
+	}
 	
-	_oldX.resize(_filterX->getOrder(), 0);
-	_oldY.resize(_filterY->getOrder(), 0);
+	// keep enough history for whichever of x and y has the longer filter
+	int history = _filters->getOrder(CHANNEL_X);
+	if (_filters->getOrder(CHANNEL_Y) > history) {
+		history = _filters->getOrder(CHANNEL_Y);
+	}
+	_oldX = new RingBuffer<float>(history, 0);
+	_oldY = new RingBuffer<float>(history, 0);
+	_reseed = new PoseArray(history);
 }
 
 NorthStar::~NorthStar() {
-	delete _filterX;
-	delete _filterY;
-	delete _filterTheta;
+	delete _filters;
+	delete _oldX;
+	delete _oldY;
+	delete _reseed;
 }
 
 /**************************************************
@@ -46,106 +72,72 @@ NorthStar::~NorthStar() {
  * 		       Specific corrections for room changes and non-linearity are 
  *             included here as well
  *
- * Note:       Requires the interface be updated prior to calling 
+ * Parameters: the newest sensor sample
  *************************************************/
-void NorthStar::updatePose() {
-	int room = _robot->getRoom();
-	int name = _robot->getName();
+void NorthStar::updatePose(const SensorSample *sample) {
+	int room = sample->room;
 
 	// if we've changed rooms, prepare filters for this
 	if (_lastRoom != -1 && _lastRoom != room) {
-		// assume X and Y fir filters are of the same order
-		int order = _filterX->getOrder(); 
-		Pose *tempPose = new Pose(0.0, 0.0, 0.0);
-		// adjust old filtered values according to new room
-		for (int i = 0; i <= order; i++) {
-			tempPose->reset(_oldX[i], _oldY[i], 0.0);
-			
-			tempPose->translate(-COL_OFFSET[0] - NS_ROOM_ORIGINS_FROM_COL[name][room][0], 
-							    -COL_OFFSET[1] - NS_ROOM_ORIGINS_FROM_COL[name][room][1]);
-			tempPose->scale(1.0/NS_ROOM_SCALE[name][room][0], 1.0/NS_ROOM_SCALE[name][room][1]);
-			tempPose->rotate(-NS_ROOM_ROTATION[name][room]);
-		
-			_oldX[i] = tempPose->getX();
-			_oldY[i] = tempPose->getY();
-		}
-		// use these updated values to seed the filters in preparation
-		_filterX->seed(&_oldX);
-		_filterY->seed(&_oldY);
-		_filterTheta->seed(_robot->getInterface()->Theta());
+		// move the (global) history into the new room's coordinates,
+		// and use it to seed the filters in preparation
+		_oldX->copyTo(_reseed->getX());
+		_oldY->copyTo(_reseed->getY());
+		_transforms[room].toRoom(_reseed);
+		_filters->seed(CHANNEL_X, _reseed->getX());
+		_filters->seed(CHANNEL_Y, _reseed->getY());
+		_filters->seed(CHANNEL_THETA, sample->nsTheta);
+		_unwrappedTheta = sample->nsTheta;
+		_lastRawTheta = sample->nsTheta;
 	}
 
 	_lastRoom = room;
 
 	// get the newest filtered values from the robot
-	float x = _getFilteredX();
-	float y = _getFilteredY();
-	float theta = _getFilteredTheta();
+	float filtered[NUM_CHANNELS];
+	_getFiltered(sample, filtered);
+	float x = filtered[CHANNEL_X];
+	float y = filtered[CHANNEL_Y];
+	float theta = filtered[CHANNEL_THETA];
 
 	// transform the data into global coord system
-	Pose *estimate = new Pose(x, y, theta);
-	if (room == ROOM_2) {
-		// Apply specific linear transformation to Room 2, 
-		// to correct for theta skew
-		float xFitAngle = 0.0000204488 * x - 0.0804;
-		float yFitAngle = 0.0000204488 * y - 0.0804;
-		estimate->rotateEach(xFitAngle, yFitAngle, NS_ROOM_ROTATION[name][room]);
-	}
-	else {
-		estimate->rotate(NS_ROOM_ROTATION[name][room]);
-	}
-
-	estimate->rotateEach(0, 0, THETA_SHIFT[name][room]);
-
-	float sx = NS_ROOM_SCALE[name][room][0];
-	float sy = NS_ROOM_SCALE[name][room][1];
-	estimate->scale(sx, sy);
-
-	float tx = COL_OFFSET[0] + NS_ROOM_ORIGINS_FROM_COL[name][room][0];
-	float ty = COL_OFFSET[1] + NS_ROOM_ORIGINS_FROM_COL[name][room][1];
-	estimate->translate(tx, ty);
+	_transforms[room].toGlobal(&x, &y, &theta);
 
 	// update our pose with new global coords
-	_pose->setX(estimate->getX());
-	_pose->setY(estimate->getY());
-	_pose->setTheta(estimate->getTheta());
-	delete estimate;
+	_pose->setX(x);
+	_pose->setY(y);
+	_pose->setTheta(theta);
 
 	// store the global x and y for future use
-	_oldX.insert(_oldX.begin(), _pose->getX());
-	_oldX.pop_back();
-	_oldY.insert(_oldY.begin(), _pose->getY());
-	_oldY.pop_back();
-}
-
-/**************************************
- * Definition: Returns filtered x from north star sensor
- *
- * Returns: filtered float coordinate
- **************************************/
-float NorthStar::_getFilteredX() {
-    int x = _robot->getInterface()->X();
-    //return x;
-    return _filterX->filter((float) x);
-}
-
-/**************************************
- * Definition: Returns filtered y from north star sensor
- *
- * Returns: filtered float coordinate
- **************************************/
-float NorthStar::_getFilteredY() {
-    int y = _robot->getInterface()->Y();
-    //return y;
-    return _filterY->filter((float) y);
+	_oldX->push(_pose->getX());
+	_oldY->push(_pose->getY());
 }
 
 /**************************************
- * Definition: Returns filtered theta from north star sensor
+ * Definition: Filters the newest x, y, and theta from the north
+ *             star sensor together. Theta wraps at +/-pi, and
+ *             averaging across the wrap would come out pointing
+ *             the wrong way, so the filters get it unwrapped (each
+ *             new theta is the last one plus the shortest turn to
+ *             it) and it's wrapped again afterwards
  *
- * Returns: filtered float theta
+ * Parameters: the sensor sample to read, and a float array to put
+ *             the filtered x, y, and theta in
  **************************************/
-float NorthStar::_getFilteredTheta() {
-    float theta = _robot->getInterface()->Theta();
-    return _filterTheta->filter(theta);
+void NorthStar::_getFiltered(const SensorSample *sample, float *filtered) {
+    if (_hasTheta) {
+        _unwrappedTheta += Util::normalizeThetaError(sample->nsTheta - _lastRawTheta);
+    }
+    else {
+        _unwrappedTheta = sample->nsTheta;
+        _hasTheta = true;
+    }
+    _lastRawTheta = sample->nsTheta;
+
+    float raw[NUM_CHANNELS];
+    raw[CHANNEL_X] = sample->nsX;
+    raw[CHANNEL_Y] = sample->nsY;
+    raw[CHANNEL_THETA] = _unwrappedTheta;
+    _filters->filter(raw, filtered);
+    filtered[CHANNEL_THETA] = Util::normalizeThetaError(filtered[CHANNEL_THETA]);
 }
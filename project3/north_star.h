@@ -19,24 +19,36 @@
 #define CS1567_NORTHSTAR_H
 
 #include "position_sensor.h"
-#include "fir_filter.h"
+#include "sensor_filter.h"
+#include "ring_buffer.h"
+#include "room_transform.h"
+#include "constants.h"
 
 class NorthStar : public PositionSensor {
 public:
 	NorthStar(Robot *robot);
 	~NorthStar();
-	void updatePose();
+	void updatePose(const SensorSample *sample);
 private:
-	FIRFilter *_filterX;
-	FIRFilter *_filterY;
-	FIRFilter *_filterTheta;
+	enum { CHANNEL_X, CHANNEL_Y, CHANNEL_THETA, NUM_CHANNELS };
+
+	SensorFilter *_filters;
 	int _lastRoom;
-	std::vector<float> _oldX;
-	std::vector<float> _oldY;
+	// from each room's coordinates to global ones, for this robot
+	RoomTransform _transforms[NUM_ROOMS];
+	// the global x and y of the last few updates, newest first
+	RingBuffer<float> *_oldX;
+	RingBuffer<float> *_oldY;
+	// the history moved into a new room's coordinates, used to
+	// seed the filters after a room change
+	PoseArray *_reseed;
+	// the raw theta with its jumps at +/-pi taken out, so the
+	// filters never see it wrap, and the last raw theta
+	bool _hasTheta;
+	float _unwrappedTheta;
+	float _lastRawTheta;
 
-	float _getFilteredX();
-	float _getFilteredY();
-	float _getFilteredTheta();
+	void _getFiltered(const SensorSample *sample, float *filtered);
 };
 
 #endif
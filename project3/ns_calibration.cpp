@@ -0,0 +1,117 @@
+/**
+ * ns_calibration.cpp
+ *
+ * @brief
+ *      Holds the north star calibration (scale, rotation, origin, and
+ *      theta shift of each room) for one robot. It starts from the
+ *      tables in constants.h and then takes any entries for the robot
+ *      from a calibration file, so a robot can be recalibrated without
+ *      recompiling
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "ns_calibration.h"
+#include "utilities.h"
+
+#include <stdio.h>
+#include <fstream>
+
+// the room number north star reports for ROOM_2
+#define FIRST_ROOM_ID 2
+
+/**************************************
+ * Definition: Starts from the robot's calibration in constants.h
+ *
+ * Parameters: the robot's name
+ **************************************/
+NSCalibration::NSCalibration(int name)
+: _name(name) {
+    for (int room = 0; room < NUM_ROOMS; room++) {
+        _rooms[room].scaleX = NS_ROOM_SCALE[name][room][0];
+        _rooms[room].scaleY = NS_ROOM_SCALE[name][room][1];
+        _rooms[room].rotation = NS_ROOM_ROTATION[name][room];
+        _rooms[room].originX = NS_ROOM_ORIGINS_FROM_COL[name][room][0];
+        _rooms[room].originY = NS_ROOM_ORIGINS_FROM_COL[name][room][1];
+        _rooms[room].thetaShift = THETA_SHIFT[name][room];
+    }
+}
+
+/**************************************
+ * Definition: Replaces rooms with this robot's entries from a
+ *             calibration file. Rooms without an entry (or a
+ *             missing file) keep what they had
+ *
+ * Parameters: the calibration file's name
+ *
+ * Returns:    the number of rooms loaded
+ **************************************/
+int NSCalibration::load(std::string fileName) {
+    std::ifstream f(fileName.c_str());
+    std::string line;
+    int loaded = 0;
+    int lineNumber = 0;
+    while (std::getline(f, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        char robot[32];
+        int roomID;
+        RoomCalibration calibration;
+        int fields = sscanf(line.c_str(), "%31s %d %f %f %f %f %f %f", robot, &roomID,
+                            &calibration.scaleX, &calibration.scaleY,
+                            &calibration.rotation,
+                            &calibration.originX, &calibration.originY,
+                            &calibration.thetaShift);
+        if (fields < 0) {
+            continue; // blank
+        }
+        int room = roomID - FIRST_ROOM_ID;
+        if (fields != 8 || room < 0 || room >= NUM_ROOMS ||
+            calibration.scaleX == 0 || calibration.scaleY == 0) {
+            printf("%s:%d: ignoring bad calibration entry\n", fileName.c_str(), lineNumber);
+            continue;
+        }
+        if (ROBOTS[_name].compare(robot) != 0) {
+            continue;
+        }
+
+        _rooms[room] = calibration;
+        loaded++;
+    }
+    return loaded;
+}
+
+/**************************************
+ * Definition: Returns the calibration for a room
+ *
+ * Parameters: the room (ROOM_2 to ROOM_5)
+ *
+ * Returns:    a pointer to the room's calibration
+ **************************************/
+RoomCalibration* NSCalibration::getRoom(int room) {
+    return &_rooms[room];
+}
+
+/**************************************
+ * Definition: Formats a calibration as a line of the file
+ *
+ * Parameters: the robot's name, the room (ROOM_2 to ROOM_5), and
+ *             its calibration
+ *
+ * Returns:    the line, without a newline
+ **************************************/
+std::string NSCalibration::format(int name, int room, RoomCalibration *calibration) {
+    char line[256];
+    sprintf(line, "%s %d %.2f %.2f %.4f %.1f %.1f %.4f", ROBOTS[name].c_str(),
+            room + FIRST_ROOM_ID, calibration->scaleX, calibration->scaleY,
+            calibration->rotation, calibration->originX, calibration->originY,
+            calibration->thetaShift);
+    return std::string(line);
+}
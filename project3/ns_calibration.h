@@ -0,0 +1,52 @@
+/**
+ * ns_calibration.h
+ *
+ * @brief
+ *      Holds the north star calibration (scale, rotation, origin, and
+ *      theta shift of each room) for one robot. It starts from the
+ *      tables in constants.h and then takes any entries for the robot
+ *      from a calibration file, so a robot can be recalibrated without
+ *      recompiling. Each line of the file is
+ *
+ *          robot room scaleX scaleY rotation originX originY thetaShift
+ *
+ *      with the robot's name (rosie, bender, ...), the north star room
+ *      (2-5), and the origin measured from the column corner. Lines
+ *      starting with # are ignored
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_NSCALIBRATION_H
+#define CS1567_NSCALIBRATION_H
+
+#include <string>
+#include "constants.h"
+
+struct RoomCalibration {
+    // ticks per cm
+    float scaleX;
+    float scaleY;
+    float rotation;
+    // from the column corner, in cm
+    float originX;
+    float originY;
+    float thetaShift;
+};
+
+class NSCalibration {
+public:
+    NSCalibration(int name);
+    int load(std::string fileName);
+    RoomCalibration* getRoom(int room);
+    static std::string format(int name, int room, RoomCalibration *calibration);
+private:
+    int _name;
+    RoomCalibration _rooms[NUM_ROOMS];
+};
+
+#endif
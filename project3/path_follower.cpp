@@ -0,0 +1,197 @@
+/**
+ * path_follower.cpp
+ *
+ * @brief
+ *      Keeps track of where the robot is along a path of waypoints (the
+ *      centers of the cells it's going through, in global coordinates)
+ *      for pure pursuit. Each update finds how far along the path the
+ *      robot has gotten, which waypoints it has passed, and the point a
+ *      lookahead distance further along the path to steer toward
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "path_follower.h"
+
+#include <math.h>
+
+/**************************************
+ * Definition: Sets up a follower with no path
+ *
+ * Parameters: how far ahead (cm) along the path to steer toward
+ **************************************/
+PathFollower::PathFollower(float lookahead)
+: _lookahead(lookahead), _segment(0), _along(0), _distanceToEnd(0),
+  _lookaheadX(0), _lookaheadY(0) {}
+
+/**************************************
+ * Definition: Starts following a new path from its first waypoint
+ *
+ * Parameters: the waypoints' x and y (cm), and how many there are
+ **************************************/
+void PathFollower::setPath(const float *x, const float *y, int numWaypoints) {
+    _x.assign(x, x + numWaypoints);
+    _y.assign(y, y + numWaypoints);
+    _segment = 0;
+    _along = 0;
+    _distanceToEnd = 0;
+    if (numWaypoints > 0) {
+        _lookaheadX = x[numWaypoints - 1];
+        _lookaheadY = y[numWaypoints - 1];
+        // until the first update, assume we're at the first waypoint
+        _distanceToEnd = sqrt((x[0] - _lookaheadX) * (x[0] - _lookaheadX) +
+                              (y[0] - _lookaheadY) * (y[0] - _lookaheadY));
+    }
+}
+
+/**************************************
+ * Definition: Moves our place along the path up to where the robot
+ *             is (never back), and finds the lookahead point
+ *
+ * Parameters: the robot's x and y (cm)
+ **************************************/
+void PathFollower::update(float x, float y) {
+    int numSegments = (int)_x.size() - 1;
+    if (numSegments < 1) {
+        return;
+    }
+
+    // project the robot onto the current segment, moving on to the
+    // next one whenever it's past the end of this one
+    while (true) {
+        float dx = _x[_segment + 1] - _x[_segment];
+        float dy = _y[_segment + 1] - _y[_segment];
+        float length = dx * dx + dy * dy;
+        float along = 1;
+        if (length > 0) {
+            along = ((x - _x[_segment]) * dx + (y - _y[_segment]) * dy) / length;
+        }
+        if (along > _along) {
+            _along = (along < 1) ? along : 1;
+        }
+        // steering toward the lookahead cuts corners, so we may never
+        // get all the way to the end of a segment before turning
+        float toEndX = x - _x[_segment + 1];
+        float toEndY = y - _y[_segment + 1];
+        if (sqrt(toEndX * toEndX + toEndY * toEndY) < _lookahead / 2) {
+            _along = 1;
+        }
+        if (_along < 1 || _segment + 1 == numSegments) {
+            break;
+        }
+        _segment++;
+        _along = 0;
+    }
+
+    _distanceToEnd = sqrt((x - _x[numSegments]) * (x - _x[numSegments]) +
+                          (y - _y[numSegments]) * (y - _y[numSegments]));
+
+    // walk the lookahead distance along the path from our place on it
+    int segment = _segment;
+    float along = _along;
+    float left = _lookahead;
+    while (true) {
+        float length = _segmentLength(segment);
+        float rest = (1 - along) * length;
+        if (left <= rest || segment + 1 == numSegments) {
+            float t = 1;
+            if (length > 0 && left <= rest) {
+                t = along + left / length;
+            }
+            _lookaheadX = _x[segment] + t * (_x[segment + 1] - _x[segment]);
+            _lookaheadY = _y[segment] + t * (_y[segment + 1] - _y[segment]);
+            break;
+        }
+        left -= rest;
+        segment++;
+        along = 0;
+    }
+}
+
+/**************************************
+ * Definition: Returns the last waypoint we've gotten to. The first
+ *             waypoint (where we started) counts as reached
+ *
+ * Returns:    an int index into the waypoints
+ **************************************/
+int PathFollower::getReached() {
+    if (_along >= 1) {
+        return _segment + 1;
+    }
+    return _segment;
+}
+
+/**************************************
+ * Definition: Checks whether we've made it to the end of the path,
+ *             either passing the last waypoint or getting close to it
+ *
+ * Parameters: how close (cm) counts
+ *
+ * Returns:    true if we're done
+ **************************************/
+bool PathFollower::isDone(float tolerance) {
+    int numSegments = (int)_x.size() - 1;
+    if (numSegments < 1) {
+        return true;
+    }
+    return _segment + 1 == numSegments &&
+           (_along >= 1 || _distanceToEnd <= tolerance);
+}
+
+/**************************************
+ * Definition: Returns the point to steer toward
+ *
+ * Returns:    the lookahead point's x (cm)
+ **************************************/
+float PathFollower::getLookaheadX() {
+    return _lookaheadX;
+}
+
+/**************************************
+ * Definition: Returns the point to steer toward
+ *
+ * Returns:    the lookahead point's y (cm)
+ **************************************/
+float PathFollower::getLookaheadY() {
+    return _lookaheadY;
+}
+
+/**************************************
+ * Definition: Returns which way the current segment runs
+ *
+ * Returns:    a global theta (radians)
+ **************************************/
+float PathFollower::getSegmentHeading() {
+    if (_x.size() < 2) {
+        return 0;
+    }
+    return atan2(_y[_segment + 1] - _y[_segment],
+                 _x[_segment + 1] - _x[_segment]);
+}
+
+/**************************************
+ * Definition: Returns how far there is left to go along the path
+ *
+ * Returns:    a distance in cm
+ **************************************/
+float PathFollower::getRemaining() {
+    int numSegments = (int)_x.size() - 1;
+    if (numSegments < 1) {
+        return 0;
+    }
+    float remaining = (1 - _along) * _segmentLength(_segment);
+    for (int i = _segment + 1; i < numSegments; i++) {
+        remaining += _segmentLength(i);
+    }
+    return remaining;
+}
+
+float PathFollower::_segmentLength(int segment) {
+    float dx = _x[segment + 1] - _x[segment];
+    float dy = _y[segment + 1] - _y[segment];
+    return sqrt(dx * dx + dy * dy);
+}
@@ -0,0 +1,50 @@
+/**
+ * path_follower.h
+ *
+ * @brief
+ *      Keeps track of where the robot is along a path of waypoints (the
+ *      centers of the cells it's going through, in global coordinates)
+ *      for pure pursuit. Each update finds how far along the path the
+ *      robot has gotten, which waypoints it has passed, and the point a
+ *      lookahead distance further along the path to steer toward
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_PATHFOLLOWER_H
+#define CS1567_PATHFOLLOWER_H
+
+#include <vector>
+
+class PathFollower {
+public:
+    PathFollower(float lookahead);
+    void setPath(const float *x, const float *y, int numWaypoints);
+    void update(float x, float y);
+    int getReached();
+    bool isDone(float tolerance);
+    float getLookaheadX();
+    float getLookaheadY();
+    float getSegmentHeading();
+    float getRemaining();
+private:
+    float _lookahead;
+    std::vector<float> _x;
+    std::vector<float> _y;
+    // the segment we're on (from waypoint _segment to _segment + 1),
+    // and how far along it we are (0 to 1)
+    int _segment;
+    float _along;
+    // how far we are from the last waypoint
+    float _distanceToEnd;
+    float _lookaheadX;
+    float _lookaheadY;
+
+    float _segmentLength(int segment);
+};
+
+#endif
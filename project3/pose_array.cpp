@@ -0,0 +1,275 @@
+/**
+ * pose_array.cpp
+ *
+ * @brief
+ *      This class keeps many poses at once, stored as separate x, y,
+ *      and theta arrays, so rotating, scaling, translating, or comparing
+ *      all of them is a few passes over contiguous floats that run four
+ *      poses at a time with SSE (or one at a time without it). Single
+ *      poses go in and out through Pose, which works the same as before
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "pose_array.h"
+#include "utilities.h"
+
+#include <math.h>
+#if POSE_ARRAY_SSE
+#include <emmintrin.h>
+#endif
+
+PoseArray::PoseArray(int size)
+: _x(size, 0), _y(size, 0), _theta(size, 0) {}
+
+PoseArray::~PoseArray() {}
+
+/**************************************
+ * Definition: Returns the number of poses
+ *
+ * Returns:    an int with the number of poses
+ **************************************/
+int PoseArray::size() {
+    return _x.size();
+}
+
+/**************************************
+ * Definition: Changes the number of poses. New poses are zero
+ *
+ * Parameters: the new number of poses
+ **************************************/
+void PoseArray::resize(int size) {
+    _x.resize(size, 0);
+    _y.resize(size, 0);
+    _theta.resize(size, 0);
+}
+
+/**************************************
+ * Definition: Copies one pose out
+ *
+ * Parameters: its index and the pose to copy it into
+ **************************************/
+void PoseArray::get(int i, Pose *pose) {
+    pose->reset(_x[i], _y[i], _theta[i]);
+}
+
+/**************************************
+ * Definition: Copies a pose in
+ *
+ * Parameters: its index and the pose to copy
+ **************************************/
+void PoseArray::set(int i, Pose *pose) {
+    set(i, pose->getX(), pose->getY(), pose->getTheta());
+}
+
+/**************************************
+ * Definition: Sets one pose
+ *
+ * Parameters: its index, x, y, and theta
+ **************************************/
+void PoseArray::set(int i, float x, float y, float theta) {
+    _x[i] = x;
+    _y[i] = y;
+    _theta[i] = Util::normalizeTheta(theta);
+}
+
+/**************************************
+ * Definition: Returns every pose's x, in order
+ *
+ * Returns:    a pointer to the x values
+ **************************************/
+std::vector<float>* PoseArray::getX() {
+    return &_x;
+}
+
+/**************************************
+ * Definition: Returns every pose's y, in order
+ *
+ * Returns:    a pointer to the y values
+ **************************************/
+std::vector<float>* PoseArray::getY() {
+    return &_y;
+}
+
+/**************************************
+ * Definition: Returns every pose's theta, in order
+ *
+ * Returns:    a pointer to the theta values
+ **************************************/
+std::vector<float>* PoseArray::getTheta() {
+    return &_theta;
+}
+
+/**************************************
+ * Definition: Rotates every pose like Pose::rotate
+ *
+ * Parameters: angle as a float
+ **************************************/
+void PoseArray::rotate(float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    float matrix[6] = {c, -s, 0, s, c, 0};
+    transform(matrix);
+    _subtractTheta(angle);
+}
+
+/**************************************
+ * Definition: Scales every pose like Pose::scale (dividing by
+ *             the scales)
+ *
+ * Parameters: x and y scaling floats
+ **************************************/
+void PoseArray::scale(float sx, float sy) {
+    int n = size();
+    int i = 0;
+#if POSE_ARRAY_SSE
+    __m128 vsx = _mm_set1_ps(sx);
+    __m128 vsy = _mm_set1_ps(sy);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&_x[i], _mm_div_ps(_mm_loadu_ps(&_x[i]), vsx));
+        _mm_storeu_ps(&_y[i], _mm_div_ps(_mm_loadu_ps(&_y[i]), vsy));
+    }
+#endif
+    for (; i < n; i++) {
+        _x[i] /= sx;
+        _y[i] /= sy;
+    }
+}
+
+/**************************************
+ * Definition: Translates every pose like Pose::translate
+ *
+ * Parameters: x and y translation floats
+ **************************************/
+void PoseArray::translate(float tx, float ty) {
+    int n = size();
+    int i = 0;
+#if POSE_ARRAY_SSE
+    __m128 vtx = _mm_set1_ps(tx);
+    __m128 vty = _mm_set1_ps(ty);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&_x[i], _mm_add_ps(_mm_loadu_ps(&_x[i]), vtx));
+        _mm_storeu_ps(&_y[i], _mm_add_ps(_mm_loadu_ps(&_y[i]), vty));
+    }
+#endif
+    for (; i < n; i++) {
+        _x[i] += tx;
+        _y[i] += ty;
+    }
+}
+
+/**************************************
+ * Definition: Applies a 2x3 affine matrix to every x and y
+ *             (theta is left alone)
+ *
+ * Parameters: the matrix {a, b, c, d, e, f}, where
+ *             x' = a x + b y + c and y' = d x + e y + f
+ **************************************/
+void PoseArray::transform(const float *matrix) {
+    int n = size();
+    int i = 0;
+#if POSE_ARRAY_SSE
+    __m128 a = _mm_set1_ps(matrix[0]);
+    __m128 b = _mm_set1_ps(matrix[1]);
+    __m128 c = _mm_set1_ps(matrix[2]);
+    __m128 d = _mm_set1_ps(matrix[3]);
+    __m128 e = _mm_set1_ps(matrix[4]);
+    __m128 f = _mm_set1_ps(matrix[5]);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(&_x[i]);
+        __m128 y = _mm_loadu_ps(&_y[i]);
+        _mm_storeu_ps(&_x[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), c));
+        _mm_storeu_ps(&_y[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(d, x), _mm_mul_ps(e, y)), f));
+    }
+#endif
+    for (; i < n; i++) {
+        float x = _x[i];
+        float y = _y[i];
+        _x[i] = matrix[0] * x + matrix[1] * y + matrix[2];
+        _y[i] = matrix[3] * x + matrix[4] * y + matrix[5];
+    }
+}
+
+/**************************************
+ * Definition: Stores the difference between each pair of poses,
+ *             like Pose::difference. The destination may be either
+ *             of the others
+ *
+ * Parameters: pointers to two pose arrays of the same size, along
+ *             with a pointer to a result array (resized to match)
+ **************************************/
+void PoseArray::difference(PoseArray *poses1, PoseArray *poses2, PoseArray *destination) {
+    int n = poses1->size();
+    destination->resize(n);
+    if (n == 0) {
+        return;
+    }
+    const float *x1 = &poses1->_x[0];
+    const float *y1 = &poses1->_y[0];
+    const float *x2 = &poses2->_x[0];
+    const float *y2 = &poses2->_y[0];
+    float *x = &destination->_x[0];
+    float *y = &destination->_y[0];
+    int i = 0;
+#if POSE_ARRAY_SSE
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(&x[i], _mm_sub_ps(_mm_loadu_ps(&x2[i]), _mm_loadu_ps(&x1[i])));
+        _mm_storeu_ps(&y[i], _mm_sub_ps(_mm_loadu_ps(&y2[i]), _mm_loadu_ps(&y1[i])));
+    }
+#endif
+    for (; i < n; i++) {
+        x[i] = x2[i] - x1[i];
+        y[i] = y2[i] - y1[i];
+    }
+    for (i = 0; i < n; i++) {
+        destination->_theta[i] = Util::normalizeTheta(poses2->_theta[i] - poses1->_theta[i]);
+    }
+}
+
+/**************************************
+ * Definition: Finds the distance between each pair of poses,
+ *             like Pose::distance
+ *
+ * Parameters: pointers to two pose arrays of the same size, and
+ *             an array to put the distances in
+ **************************************/
+void PoseArray::distance(PoseArray *poses1, PoseArray *poses2, float *distances) {
+    int n = poses1->size();
+    if (n == 0) {
+        return;
+    }
+    const float *x1 = &poses1->_x[0];
+    const float *y1 = &poses1->_y[0];
+    const float *x2 = &poses2->_x[0];
+    const float *y2 = &poses2->_y[0];
+    int i = 0;
+#if POSE_ARRAY_SSE
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&x2[i]), _mm_loadu_ps(&x1[i]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&y2[i]), _mm_loadu_ps(&y1[i]));
+        __m128 squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        _mm_storeu_ps(&distances[i], _mm_sqrt_ps(squared));
+    }
+#endif
+    for (; i < n; i++) {
+        float dx = x2[i] - x1[i];
+        float dy = y2[i] - y1[i];
+        distances[i] = sqrt(dx * dx + dy * dy);
+    }
+}
+
+/**************************************
+ * Definition: Subtracts an angle from every theta, keeping each
+ *             one normalized like Pose::setTheta does
+ *
+ * Parameters: angle as a float
+ **************************************/
+void PoseArray::_subtractTheta(float angle) {
+    for (int i = 0; i < size(); i++) {
+        _theta[i] = Util::normalizeTheta(_theta[i] - angle);
+    }
+}
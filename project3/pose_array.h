@@ -0,0 +1,57 @@
+/**
+ * pose_array.h
+ *
+ * @brief
+ *      This class keeps many poses at once, stored as separate x, y,
+ *      and theta arrays, so rotating, scaling, translating, or comparing
+ *      all of them is a few passes over contiguous floats that run four
+ *      poses at a time with SSE (or one at a time without it). Single
+ *      poses go in and out through Pose, which works the same as before
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_POSEARRAY_H
+#define CS1567_POSEARRAY_H
+
+#include <vector>
+#include "pose.h"
+
+// build with -DPOSE_ARRAY_NO_SSE to use the plain loops everywhere
+#if defined(__SSE2__) && !defined(POSE_ARRAY_NO_SSE)
+#define POSE_ARRAY_SSE 1
+#else
+#define POSE_ARRAY_SSE 0
+#endif
+
+class PoseArray {
+public:
+    PoseArray(int size);
+    ~PoseArray();
+    int size();
+    void resize(int size);
+    void get(int i, Pose *pose);
+    void set(int i, Pose *pose);
+    void set(int i, float x, float y, float theta);
+    std::vector<float>* getX();
+    std::vector<float>* getY();
+    std::vector<float>* getTheta();
+    void rotate(float angle);
+    void scale(float sx, float sy);
+    void translate(float tx, float ty);
+    void transform(const float *matrix);
+    static void difference(PoseArray *poses1, PoseArray *poses2, PoseArray *destination);
+    static void distance(PoseArray *poses1, PoseArray *poses2, float *distances);
+private:
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _theta;
+
+    void _subtractTheta(float angle);
+};
+
+#endif
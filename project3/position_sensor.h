@@ -16,6 +16,7 @@
 #define CS1567_POSITIONSENSOR_H
 
 #include "pose.h"
+#include "sensor_sample.h"
 
 class Robot; // so we can avoid circular dependency
 
@@ -23,7 +24,7 @@ class PositionSensor {
 public:
 	PositionSensor(Robot *robot);
 	~PositionSensor();
-	virtual void updatePose() = 0;
+	virtual void updatePose(const SensorSample *sample) = 0;
 	void resetPose(Pose *pose);
 	float getX();
 	float getY();
@@ -0,0 +1,104 @@
+/**
+ * ring_buffer.h
+ *
+ * @brief
+ *      A fixed-capacity history of the most recent values. The storage
+ *      is allocated once, pushing a value overwrites the oldest one in
+ *      place, and values are read by age (0 is the newest), so keeping
+ *      a history costs no allocation or shifting per update
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_RINGBUFFER_H
+#define CS1567_RINGBUFFER_H
+
+#include <vector>
+
+template <typename T>
+class RingBuffer {
+public:
+    RingBuffer(int capacity, T value);
+    ~RingBuffer();
+    int size();
+    void push(T value);
+    T& operator[](int age);
+    void copyTo(std::vector<T> *values);
+private:
+    T *_values;
+    int _capacity;
+    // where the newest value is
+    int _newest;
+};
+
+template <typename T>
+RingBuffer<T>::RingBuffer(int capacity, T value)
+: _capacity(capacity), _newest(0) {
+    // keep one slot even if asked for none, so push always has somewhere to go
+    _values = new T[capacity > 0 ? capacity : 1];
+    for (int i = 0; i < capacity; i++) {
+        _values[i] = value;
+    }
+}
+
+template <typename T>
+RingBuffer<T>::~RingBuffer() {
+    delete[] _values;
+}
+
+/**************************************
+ * Definition: Returns how many values are kept
+ *
+ * Returns: an int with the capacity
+ **************************************/
+template <typename T>
+int RingBuffer<T>::size() {
+    return _capacity;
+}
+
+/**************************************
+ * Definition: Adds the newest value, replacing the oldest
+ *
+ * Parameters: the value to add
+ **************************************/
+template <typename T>
+void RingBuffer<T>::push(T value) {
+    if (_capacity == 0) {
+        return;
+    }
+    _newest = (_newest == 0) ? _capacity - 1 : _newest - 1;
+    _values[_newest] = value;
+}
+
+/**************************************
+ * Definition: Returns a value by its age
+ *
+ * Parameters: how many pushes ago it was added (0 is the newest)
+ *
+ * Returns: a reference to the value, so it can be changed in place
+ **************************************/
+template <typename T>
+T& RingBuffer<T>::operator[](int age) {
+    int i = _newest + age;
+    return _values[i >= _capacity ? i - _capacity : i];
+}
+
+/**************************************
+ * Definition: Copies the values into a vector, newest first. The
+ *             vector only grows if it is smaller than the buffer
+ *
+ * Parameters: a vector pointer to copy into
+ **************************************/
+template <typename T>
+void RingBuffer<T>::copyTo(std::vector<T> *values) {
+    values->resize(_capacity);
+    for (int i = 0; i < _capacity; i++) {
+        (*values)[i] = (*this)[i];
+    }
+}
+
+#endif
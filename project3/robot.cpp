@@ -27,12 +27,19 @@ Robot::Robot(std::string address, int id) {
     _numCellsTraveled = 0;
     _turnDirection = 0;
     _movingForward = true;
+    _diagonal = 0;
     _speed = 0;
     _heading = DIR_NORTH;
 
+    _pathFollower = new PathFollower(PURSUIT_LOOKAHEAD);
+    _anchorCell = NULL;
+    _anchorX = 0;
+    _anchorY = 0;
+
     setFailLimit(MAX_UPDATE_FAILS);
 
     _robotInterface = new RobotInterface(address, id);
+    _commands = new CommandLayer(_robotInterface);
 
     printf("robot interface loaded\n");
 
@@ -46,7 +53,12 @@ Robot::Robot(std::string address, int id) {
     // initialize global pose
     _pose = new Pose(0.0, 0.0, 0.0);
     // bind _pose to the kalman filter
-    _kalmanFilter = new KalmanFilter(_pose);
+    if (USE_EXTENDED_KALMAN) {
+        _kalmanFilter = new ExtendedKalmanFilter(_pose);
+    }
+    else {
+        _kalmanFilter = new KalmanFilter(_pose);
+    }
     _kalmanFilter->setUncertainty(PROC_X_UNCERTAIN,
                                   PROC_Y_UNCERTAIN,
                                   PROC_THETA_UNCERTAIN,
@@ -64,8 +76,23 @@ Robot::Robot(std::string address, int id) {
 
     _movePID = new PID(&movePIDConstants, MIN_MOVE_ERROR, MAX_MOVE_ERROR);
     _turnPID = new PID(&turnPIDConstants, MIN_TURN_ERROR, MAX_TURN_ERROR);
+    _movePID->setFeedForward(SPEED_FORWARD, 1);
+
+    _moveProfile = new MotionProfile(PROFILE_MOVE_ACCEL, PROFILE_MOVE_DECEL);
+    _turnProfile = new MotionProfile(PROFILE_TURN_ACCEL, PROFILE_TURN_DECEL);
+    _moveProfile->setSpeeds(SPEED_FORWARD, 1);
+    for (int speed = 0; speed < NUM_SPEEDS; speed++) {
+        _turnPulses[speed] = _turnPulse(speed);
+    }
+    _turnProfile->setPulses(_turnPulses);
 
     printf("pid controllers initialized\n");
+
+    _controlLoop = new LoopScheduler(CONTROL_LOOP_RATE);
+    _centerLoop = new LoopScheduler(CONTROL_LOOP_RATE);
+    _pipeline = new RobotPipeline(this);
+    _pipelined = false;
+    _controlUsesWheelEncoders = true;
     
     // Put robot head down for NorthStar use
     moveHead(RI_HEAD_DOWN);
@@ -100,6 +127,8 @@ Robot::Robot(std::string address, int id) {
 }
 
 Robot::~Robot() {
+    delete _pipeline;
+    delete _commands;
     delete _robotInterface;
     delete _camera;
     delete _wheelEncoders;
@@ -108,8 +137,13 @@ Robot::~Robot() {
     delete _kalmanFilter;
     delete _movePID;
     delete _turnPID;
+    delete _moveProfile;
+    delete _turnProfile;
     delete _centerTurnPID;
     delete _centerStrafePID;
+    delete _controlLoop;
+    delete _centerLoop;
+    delete _pathFollower;
     delete _map;
     delete _mapStrategy;
 }
@@ -122,6 +156,22 @@ Robot::~Robot() {
  *              the game is over.
  *************************************/
 void Robot::playGame() {
+    if (USE_PATH_FOLLOWING) {
+        Path *path = _mapStrategy->nextPath();
+        while (path != NULL) {
+            int cellsReached = followPath(path);
+            delete path;
+
+            // if we didn't get anywhere, the strategy will just give us
+            // the same path, so fall back on moving a cell at a time
+            if (cellsReached == 0) {
+                break;
+            }
+            path = _mapStrategy->nextPath();
+        }
+        stop();
+    }
+
     Cell *nextCell = _mapStrategy->nextCell();
 
     while (nextCell != NULL) {
@@ -150,6 +200,15 @@ void Robot::playGame() {
 
         nextCell = _mapStrategy->nextCell();
     }
+
+    // report how well the kalman covariance held up over the game
+    kalmanHealth health;
+    _kalmanFilter->getHealth(&health);
+    printf("kalman health: %d steps, %d failed inversions, "
+           "%d asymmetry repairs, %d definiteness repairs\n",
+           health.steps, health.inversionFailures,
+           health.asymmetryRepairs, health.definitenessRepairs);
+    _commands->printStats("robot interface");
 }
 
 /**************************************
@@ -382,54 +441,236 @@ float Robot::moveToUntil(float x, float y, float distErrorLimit, float thetaErro
     float distError;
 
     float moveGain;
+    Estimate estimate;
 
     printf("heading toward (%f, %f)\n", x, y);
+    _moveProfile->start();
+    _beginControl(true);
     do {
-        updatePose(true);
+        float dt = _nextEstimate(&estimate);
 
-        yError = y - _pose->getY();
-        xError = x - _pose->getX();
+        yError = y - estimate.y;
+        xError = x - estimate.x;
 
         switch (_heading) {
         case DIR_NORTH:
             thetaDesired = DEGREE_90;
-            distError = fabs(y - _pose->getY());
+            distError = fabs(y - estimate.y);
             break;
         case DIR_SOUTH:
             thetaDesired = DEGREE_270;
-            distError = fabs(y - _pose->getY());
+            distError = fabs(y - estimate.y);
             break;
         case DIR_EAST:
             thetaDesired = DEGREE_0;
-            distError = fabs(x - _pose->getX());
+            distError = fabs(x - estimate.x);
             break;
         case DIR_WEST:
             thetaDesired = DEGREE_180;
-            distError = fabs(x - _pose->getX());
+            distError = fabs(x - estimate.x);
             break;
         }
 
-        thetaError = thetaDesired - _northStar->getTheta();
+        thetaError = thetaDesired - estimate.nsTheta;
         thetaError = Util::normalizeThetaError(thetaError);
 
-        moveGain = _movePID->updatePID(distError);
-        _turnPID->updatePID(thetaError);
+        // the profile plans the move on its own, so the PIDs sit out
+        if (!USE_MOTION_PROFILE) {
+            moveGain = _movePID->updatePID(distError, dt, distError / PID_MOVE_FF_TIME);
+            _turnPID->updatePID(thetaError, dt);
+        }
 
         if (fabs(thetaError) > thetaErrorLimit) {
 			printf("theta error of %f too great\n", thetaError);
+            _endControl();
             return thetaError;
         }
         
-        int moveSpeed = (int)(10 - 9 * moveGain);
-        moveSpeed = Util::capSpeed(moveSpeed, 10);
+        int moveSpeed;
+        if (USE_MOTION_PROFILE) {
+            // aim for the middle of where we're allowed to stop
+            moveSpeed = _moveProfile->speed(distError - distErrorLimit / 2, dt);
+        }
+        else {
+            moveSpeed = (int)(10 - 9 * moveGain);
+            moveSpeed = Util::capSpeed(moveSpeed, 10);
+        }
 
-        moveForward(moveSpeed);
+        // sending nothing lets the rovio coast to a stop
+        if (moveSpeed != 0) {
+            _command(CMD_FORWARD, moveSpeed);
+        }
     } 
     while (distError > distErrorLimit);
 
+    _endControl();
     return 0; // no error when we've finished
 }
 
+/**************************************
+ * Definition: Follows a path from the map strategy without stopping,
+ *             steering toward a point a lookahead distance along the
+ *             path (pure pursuit). Centering is blended in by sliding
+ *             diagonally toward the path instead of stopping to center
+ *             in each cell, and we only turn in place when we're
+ *             facing well away from where we're going. Cells are
+ *             occupied as we pass their centers, reserving the next
+ *             one as we go
+ *
+ * Parameters: the path to follow (its first cell is the one we're in)
+ *
+ * Returns:    how many cells along the path we made it
+ **************************************/
+int Robot::followPath(Path *path) {
+    int numWaypoints = path->length();
+    if (numWaypoints < 2) {
+        return 0;
+    }
+
+    // pick up from where we think the end of the last path was if we
+    // made it there, since the pose wanders as we move through a cell
+    Cell *startCell = path->getCell(0);
+    if (_anchorCell != startCell) {
+        updatePose(true);
+        _anchorX = _pose->getX();
+        _anchorY = _pose->getY();
+    }
+
+    // cells further along in x are to the west (-x globally), and
+    // further along in y are to the north (+y globally)
+    float *waypointX = new float[numWaypoints];
+    float *waypointY = new float[numWaypoints];
+    for (int i = 0; i < numWaypoints; i++) {
+        Cell *cell = path->getCell(i);
+        waypointX[i] = _anchorX - (cell->x - startCell->x) * CELL_SIZE;
+        waypointY[i] = _anchorY + (cell->y - startCell->y) * CELL_SIZE;
+    }
+    _pathFollower->setPath(waypointX, waypointY, numWaypoints);
+
+    Cell *nextCell = path->getCell(1);
+    _reserveCell(nextCell);
+
+    int reached = 0;
+    int passes = 0;
+    int maxPasses = PURSUIT_PASSES_PER_CELL * (numWaypoints - 1);
+    // which way we're turning in place, or -1 if we're driving
+    int turnDirection = -1;
+    Estimate estimate;
+
+    printf("following a path through %d cells\n", numWaypoints - 1);
+    _movePID->flushPID();
+    _turnPID->flushPID();
+    _moveProfile->start();
+    _beginControl(true);
+    while (!_pathFollower->isDone(MAX_DIST_ERROR) && passes < maxPasses) {
+        float dt = _nextEstimate(&estimate);
+        passes++;
+
+        _pathFollower->update(estimate.x, estimate.y);
+
+        // claim every cell we've passed the center of
+        while (reached < _pathFollower->getReached()) {
+            reached++;
+            _occupyCell(path->getCell(reached));
+            _numCellsTraveled++;
+            printf("Made it to cell %d\n", _numCellsTraveled);
+            if (reached + 1 < numWaypoints) {
+                _reserveCell(path->getCell(reached + 1));
+            }
+        }
+
+        float headingError = _pathFollower->getSegmentHeading() - estimate.nsTheta;
+        headingError = Util::normalizeThetaError(headingError);
+        float bearing = atan2(_pathFollower->getLookaheadY() - estimate.y,
+                              _pathFollower->getLookaheadX() - estimate.x) - estimate.nsTheta;
+        bearing = Util::normalizeThetaError(bearing);
+
+        if (fabs(headingError) > PURSUIT_MAX_HEADING_ERROR ||
+            fabs(bearing) > DEGREE_90) {
+            // too far off to drive it out, so turn toward the segment
+            // the same way turnTo does, starting over from rest for
+            // each turn (and the PID too, since the error is only ever
+            // positive and its integral can't wind back down)
+            int direction = (headingError < 0) ? DIR_RIGHT : DIR_LEFT;
+            if (direction != turnDirection) {
+                _turnProfile->start();
+                _turnPID->flushPID();
+                turnDirection = direction;
+            }
+
+            int turnSpeed;
+            if (USE_MOTION_PROFILE) {
+                _turnProfile->setSpeeds(&SPEED_TURN[0][direction], 2);
+                turnSpeed = _turnProfile->speed(fabs(headingError), dt);
+                if (turnSpeed == 0) {
+                    // lined up with the segment but the lookahead is
+                    // still behind us, so keep creeping round
+                    turnSpeed = 10;
+                }
+            }
+            else {
+                _turnPID->setFeedForward(&SPEED_TURN[0][direction], 2);
+                float turnGain = _turnPID->updatePID(fabs(headingError), dt,
+                                                     headingError / PID_TURN_FF_TIME);
+                turnSpeed = (int)(10 - 9 * turnGain);
+                turnSpeed = Util::capSpeed(turnSpeed, 10);
+            }
+
+            _command((direction == DIR_RIGHT) ? CMD_TURN_RIGHT : CMD_TURN_LEFT, turnSpeed);
+            // and drive off from rest once we're lined up
+            _moveProfile->start();
+            continue;
+        }
+        turnDirection = -1;
+
+        float remaining = _pathFollower->getRemaining();
+        int moveSpeed;
+        if (USE_MOTION_PROFILE) {
+            moveSpeed = _moveProfile->speed(remaining - MAX_DIST_ERROR / 2, dt);
+        }
+        else {
+            float moveGain = _movePID->updatePID(remaining, dt, remaining / PID_MOVE_FF_TIME);
+            moveSpeed = (int)(10 - 9 * moveGain);
+            moveSpeed = Util::capSpeed(moveSpeed, 10);
+        }
+
+        if (moveSpeed == 0) {
+            // coast to a stop
+        }
+        else if (bearing > PURSUIT_DIAGONAL_ANGLE) {
+            _command(CMD_FORWARD_LEFT, moveSpeed);
+        }
+        else if (bearing < -PURSUIT_DIAGONAL_ANGLE) {
+            _command(CMD_FORWARD_RIGHT, moveSpeed);
+        }
+        else {
+            _command(CMD_FORWARD, moveSpeed);
+        }
+    }
+    _endControl();
+
+    // the last waypoint counts once we're close enough to it
+    if (_pathFollower->isDone(MAX_DIST_ERROR)) {
+        while (reached < numWaypoints - 1) {
+            reached++;
+            _occupyCell(path->getCell(reached));
+            _numCellsTraveled++;
+            printf("Made it to cell %d\n", _numCellsTraveled);
+        }
+        _anchorCell = path->getCell(reached);
+        _anchorX = waypointX[reached];
+        _anchorY = waypointY[reached];
+    }
+    else {
+        printf("gave up on the path after %d passes\n", passes);
+        _anchorCell = NULL;
+    }
+
+    delete[] waypointX;
+    delete[] waypointY;
+    return reached;
+}
+
 /**************************************
  * Definition: Turns the robot as close to the specified theta
  *             as possible. When theta is within the specified
@@ -442,32 +683,57 @@ void Robot::turnTo(float thetaGoal, float thetaErrorLimit) {
     float thetaError;
 
     float turnGain;
+    int lastDirection = -1;
+    Estimate estimate;
  
     printf("adjusting theta\n");
+    _beginControl(false);
     do {
-	    updatePose(false);
+        float dt = _nextEstimate(&estimate);
 
-        theta = _northStar->getTheta();
+        theta = estimate.nsTheta;
         thetaError = thetaGoal - theta;
         thetaError = Util::normalizeThetaError(thetaError);
 
-        turnGain = _turnPID->updatePID(thetaError);
+        // the sign only picks the direction, so the profile,
+        // PID, and feed-forward work on the size
+        int direction = (thetaError < 0) ? DIR_RIGHT : DIR_LEFT;
+
+        // turning back the other way starts over from rest. the PID
+        // starts over too, since the error it sees is only ever
+        // positive and its integral would never wind back down
+        if (direction != lastDirection) {
+            _turnProfile->start();
+            _turnPID->flushPID();
+            lastDirection = direction;
+        }
 
-        if (thetaError < -thetaErrorLimit) {
-            int turnSpeed = (int)(10 - 9 * turnGain);
+        int turnSpeed;
+        if (USE_MOTION_PROFILE) {
+            _turnProfile->setSpeeds(&SPEED_TURN[0][direction], 2);
+            turnSpeed = _turnProfile->speed(fabs(thetaError) - thetaErrorLimit / 2, dt);
+        }
+        else {
+            _turnPID->setFeedForward(&SPEED_TURN[0][direction], 2);
+            turnGain = _turnPID->updatePID(fabs(thetaError), dt,
+                                           thetaError / PID_TURN_FF_TIME);
+            turnSpeed = (int)(10 - 9 * turnGain);
             turnSpeed = Util::capSpeed(turnSpeed, 10);
+        }
 
-            turnRight(turnSpeed);
+        if (turnSpeed == 0) {
+            // coast to a stop
+        }
+        else if (thetaError < -thetaErrorLimit) {
+            _command(CMD_TURN_RIGHT, turnSpeed);
         }
         else if(thetaError > thetaErrorLimit){
-            int turnSpeed = (int)(10 - 9 * turnGain);
-            turnSpeed = Util::capSpeed(turnSpeed, 10);
-
-            turnLeft(turnSpeed);
+            _command(CMD_TURN_LEFT, turnSpeed);
         }
     } 
     while (fabs(thetaError) > thetaErrorLimit);
 
+    _endControl();
     printf("theta acceptable\n");
 }
 
@@ -567,7 +833,9 @@ void Robot::center() {
     int turnAttempts = 0;
 
     Camera::prevTagState = -1;
+    _centerLoop->start();
     while (true) {
+        _centerLoop->wait();
         bool turn = false;
 
         float centerError = _camera->centerError(COLOR_PINK, &turn);
@@ -623,50 +891,181 @@ void Robot::center() {
     }
 
     moveHead(RI_HEAD_DOWN);
+    _centerLoop->printStats("center");
 
     _centerTurnPID->flushPID();
     _centerStrafePID->flushPID();
 }
 
+/**************************************
+ * Definition: Gets ready to run a control loop, starting the
+ *             pipeline's threads if we're using them (and falling
+ *             back to one thread if they won't start)
+ *
+ * Parameters: whether the loop's estimates use the wheel encoders
+ **************************************/
+void Robot::_beginControl(bool useWheelEncoders) {
+    _controlUsesWheelEncoders = useWheelEncoders;
+    _pipelined = USE_PIPELINE && _pipeline->start(useWheelEncoders);
+    _controlLoop->start();
+}
+
+/**************************************
+ * Definition: Waits for the control loop's next pose estimate.
+ *             Without the pipeline, this waits for the next tick
+ *             and updates the pose itself
+ *
+ * Parameters: an estimate to fill
+ *
+ * Returns:    seconds since the last estimate
+ **************************************/
+float Robot::_nextEstimate(Estimate *estimate) {
+    if (_pipelined) {
+        return _pipeline->waitForEstimate(estimate);
+    }
+
+    float dt = _controlLoop->wait();
+    updatePose(_controlUsesWheelEncoders, dt);
+    getEstimate(estimate);
+    estimate->time = RobotPipeline::now();
+    return dt;
+}
+
+/**************************************
+ * Definition: Finishes a control loop, stopping the pipeline's
+ *             threads so the pose is ours again
+ **************************************/
+void Robot::_endControl() {
+    if (_pipelined) {
+        _pipeline->stop();
+        _pipelined = false;
+    }
+    else {
+        _controlLoop->printStats("control");
+    }
+}
+
+/**************************************
+ * Definition: Sends a motion command from a control loop, through
+ *             the act thread if the pipeline is running
+ *
+ * Parameters: the command type (CMD_*) and speed
+ **************************************/
+void Robot::_command(int type, int speed) {
+    if (_pipelined) {
+        _pipeline->command(type, speed);
+    }
+    else {
+        MotionCommand command = {type, speed};
+        issueCommand(&command);
+    }
+}
+
 /**************************************
  * Definition: Updates the robot pose in terms of the global
  *             coord system with the best estimate of its position
  *             using a kalman filter
  **************************************/
 void Robot::updatePose(bool useWheelEncoders) {
+    updatePose(useWheelEncoders, 0);
+}
+
+/**************************************
+ * Definition: Updates the robot pose in terms of the global
+ *             coord system with the best estimate of its position
+ *             using a kalman filter
+ *
+ * Parameters: whether to use the wheel encoders, and the seconds
+ *             since the last update (0 to let the filter time it)
+ **************************************/
+void Robot::updatePose(bool useWheelEncoders, float dt) {
+    SensorSample sample;
+    readSensors(&sample);
+    MotionState motion = getMotionState();
+    estimatePose(&sample, &motion, useWheelEncoders, dt);
+}
+
+/**************************************
+ * Definition: Updates the robot interface and copies out everything
+ *             the position sensors need, holding the interface lock
+ *             so it's safe from the pipeline's sense thread
+ *
+ * Parameters: a sensor sample to fill
+ *
+ * Returns:    false if the interface failed to update (the sample
+ *             then has the last values it did get)
+ **************************************/
+bool Robot::readSensors(SensorSample *sample) {
+    _commands->lock();
     // update the robot interface so wheel encoder
     // and north star have the same time-values
-    _updateInterface();
+    sample->updated = _updateInterface();
+    sample->room = _robotInterface->RoomID() - 2;
+    sample->nsX = (float) _robotInterface->X();
+    sample->nsY = (float) _robotInterface->Y();
+    sample->nsTheta = _robotInterface->Theta();
+    sample->wheelLeft = (float) _robotInterface->getWheelEncoder(RI_WHEEL_LEFT);
+    sample->wheelRight = (float) _robotInterface->getWheelEncoder(RI_WHEEL_RIGHT);
+    sample->wheelRear = (float) _robotInterface->getWheelEncoder(RI_WHEEL_REAR);
+    _commands->unlock();
+
+    sample->time = RobotPipeline::now();
+    return sample->updated;
+}
+
+/**************************************
+ * Definition: Runs a sensor sample through north star, the wheel
+ *             encoders, and the kalman filter to update the robot
+ *             pose in terms of the global coord system
+ *
+ * Parameters: the sensor sample, how the robot was last told to
+ *             move, whether to use the wheel encoders, and the
+ *             seconds since the last sample (0 to let the filter
+ *             time it)
+ **************************************/
+void Robot::estimatePose(const SensorSample *sample, const MotionState *motion,
+                         bool useWheelEncoders, float dt) {
+    if (dt > 0) {
+        _kalmanFilter->setTimeStep(dt);
+    }
     // update each pose estimate
-    _northStar->updatePose();
+    _northStar->updatePose(sample);
     if (useWheelEncoders) {
-    	_wheelEncoders->updatePose();
+    	_wheelEncoders->updatePose(sample);
     } 
     else {
         _wheelEncoders->setTheta(_northStar->getTheta());
     }
 
-    if (_speed <= 0) {
-        _speed=0;
-        _kalmanFilter->setVelocity(0.0, 0.0, 0.0);
+    // give the kalman filter our commanded velocity in the robot's
+    // frame, so it can rotate it by our heading
+    if (motion->speed <= 0) {
+        _kalmanFilter->setBodyVelocity(0.0, 0.0, 0.0);
     }
     else {
-        if (_movingForward) {
-            float speedX = SPEED_FORWARD[_speed];
-            float speedY = SPEED_FORWARD[_speed];
-
-            _kalmanFilter->setVelocity(speedX, speedY, 0.0);
+        if (motion->movingForward) {
+            float speedForward = SPEED_FORWARD[motion->speed];
+
+            if (motion->diagonal != 0) {
+                // we haven't measured diagonal speeds, so
+                // assume they're the same as going forward
+                _kalmanFilter->setBodyVelocity(speedForward * cos(DEGREE_45),
+                                               motion->diagonal * speedForward * sin(DEGREE_45),
+                                               0.0);
+            }
+            else {
+                _kalmanFilter->setBodyVelocity(speedForward, 0.0, 0.0);
+            }
         }
         else {
-            float speedTheta = SPEED_TURN[_turnDirection][_speed]; //Fetch turning speed in radians per second
+            float speedTheta = SPEED_TURN[motion->speed][(int)motion->turnDirection]; //Fetch turning speed in radians per second
 
-            //_kalmanFilter->setVelocity(0.0, 0.0, 0.0);
-            _kalmanFilter->setVelocity(0.0, 0.0, speedTheta);
+            _kalmanFilter->setBodyVelocity(0.0, 0.0, speedTheta);
         }
     }
 
     // if we're in room 2, don't trust north star so much
-    if (getRoom() == ROOM_2) {
+    if (sample->room == ROOM_2) {
         _kalmanFilter->setNSUncertainty(NS_X_UNCERTAIN+0.05, 
                                         NS_Y_UNCERTAIN+0.05, 
                                         NS_THETA_UNCERTAIN+0.025);
@@ -682,6 +1081,74 @@ void Robot::updatePose(bool useWheelEncoders) {
                           _wheelEncoders->getPose());
 }
 
+/**************************************
+ * Definition: Copies out the current pose estimate, along with
+ *             north star's own theta
+ *
+ * Parameters: an estimate to fill (its time is left alone)
+ **************************************/
+void Robot::getEstimate(Estimate *estimate) {
+    estimate->x = _pose->getX();
+    estimate->y = _pose->getY();
+    estimate->theta = _pose->getTheta();
+    estimate->nsTheta = _northStar->getTheta();
+}
+
+/**************************************
+ * Definition: Returns how the robot was last told to move
+ *
+ * Returns:    the speed, whether it's moving forward, and
+ *             which way it's turning if not
+ **************************************/
+MotionState Robot::getMotionState() {
+    MotionState motion = {_speed, _movingForward, _turnDirection, _diagonal};
+    if (motion.speed < 0) {
+        motion.speed = 0;
+    }
+    return motion;
+}
+
+/**************************************
+ * Definition: Sends a motion command, blocking as long as that
+ *             command does
+ *
+ * Parameters: the command (CMD_* type and speed)
+ *
+ * Returns:    how the robot is moving now
+ **************************************/
+MotionState Robot::issueCommand(const MotionCommand *command) {
+    switch (command->type) {
+    case CMD_FORWARD:
+        moveForward(command->speed);
+        break;
+    case CMD_BACKWARD:
+        moveBackward(command->speed);
+        break;
+    case CMD_TURN_LEFT:
+        turnLeft(command->speed);
+        break;
+    case CMD_TURN_RIGHT:
+        turnRight(command->speed);
+        break;
+    case CMD_STRAFE_LEFT:
+        strafeLeft(command->speed);
+        break;
+    case CMD_STRAFE_RIGHT:
+        strafeRight(command->speed);
+        break;
+    case CMD_STOP:
+        stop();
+        break;
+    case CMD_FORWARD_LEFT:
+        moveForwardLeft(command->speed);
+        break;
+    case CMD_FORWARD_RIGHT:
+        moveForwardRight(command->speed);
+        break;
+    }
+    return getMotionState();
+}
+
 /************************************
  * Definition: Returns the robot interface
  ***********************************/
@@ -720,10 +1187,10 @@ void Robot::prefillData() {
  * Definition: Moves the robot head (camera) to the position given as the argument
  * *****************************/
 void Robot::moveHead(int position){
-    _robotInterface->Move(position, 1);
-    sleep(1);
-    _robotInterface->Move(position, 1);
-    sleep(1);
+    _move(position, 1);
+    Util::pause(1);
+    _move(position, 1);
+    Util::pause(1);
 }
 
 /**************************************
@@ -734,8 +1201,9 @@ void Robot::moveHead(int position){
  **************************************/
 void Robot::moveForward(int speed) {
     _movingForward = true;
+    _diagonal = 0;
     _speed = speed;
-    _robotInterface->Move(RI_MOVE_FORWARD, speed);
+    _move(RI_MOVE_FORWARD, speed);
 }
 
 
@@ -747,8 +1215,37 @@ void Robot::moveForward(int speed) {
  **************************************/
 void Robot::moveBackward(int speed) {
     _movingForward = false;
+    _diagonal = 0;
     _speed = speed;
-    _robotInterface->Move(RI_MOVE_BACKWARD, speed);
+    _move(RI_MOVE_BACKWARD, speed);
+}
+
+/**************************************
+ * Definition: Moves the robot diagonally forward and to the left
+ *             (without turning), keeping track of movement.
+ *             (Wrapper around robot interface)
+ *
+ * Parameters: int specifying speed to move at
+ **************************************/
+void Robot::moveForwardLeft(int speed) {
+    _movingForward = true;
+    _diagonal = 1;
+    _speed = speed;
+    _move(RI_MOVE_FWD_LEFT, speed);
+}
+
+/**************************************
+ * Definition: Moves the robot diagonally forward and to the right
+ *             (without turning), keeping track of movement.
+ *             (Wrapper around robot interface)
+ *
+ * Parameters: int specifying speed to move at
+ **************************************/
+void Robot::moveForwardRight(int speed) {
+    _movingForward = true;
+    _diagonal = -1;
+    _speed = speed;
+    _move(RI_MOVE_FWD_RIGHT, speed);
 }
 
 /**************************************
@@ -760,16 +1257,12 @@ void Robot::moveBackward(int speed) {
 void Robot::turnLeft(int speed) {
 	_turnDirection = DIR_LEFT;
 	_movingForward = false;
+	_diagonal = 0;
 	_speed = speed;
-    int sleepLength = 300000; 
-    if(speed > 6) { 
-       _robotInterface->Move(RI_TURN_LEFT, 6);
-       sleepLength -= 50000*(speed-6);
-    } else {
-       _robotInterface->Move(RI_TURN_LEFT, speed);
-    }
-    usleep(sleepLength);
-    _robotInterface->Move(RI_STOP, 0);
+    // slower speeds are shorter turns at TURN_PULSE_SPEED
+    _move(RI_TURN_LEFT, (speed > TURN_PULSE_SPEED) ? TURN_PULSE_SPEED : speed);
+    Util::pause(_turnPulse(speed));
+    _move(RI_STOP, 0);
 }
 
 /**************************************
@@ -781,16 +1274,12 @@ void Robot::turnLeft(int speed) {
 void Robot::turnRight(int speed) {
 	_turnDirection = DIR_RIGHT;
 	_movingForward = false;
+	_diagonal = 0;
 	_speed = speed;
-    int sleepLength = 300000; 
-    if(speed > 6) { 
-       _robotInterface->Move(RI_TURN_RIGHT, 6);
-       sleepLength -= 50000*(speed-6);
-    } else {
-       _robotInterface->Move(RI_TURN_RIGHT, speed);
-    }
-    usleep(sleepLength);
-    _robotInterface->Move(RI_STOP, 0);
+    // slower speeds are shorter turns at TURN_PULSE_SPEED
+    _move(RI_TURN_RIGHT, (speed > TURN_PULSE_SPEED) ? TURN_PULSE_SPEED : speed);
+    Util::pause(_turnPulse(speed));
+    _move(RI_STOP, 0);
 }
 
 /**************************************
@@ -807,9 +1296,9 @@ void Robot::strafeLeft(int speed) {
     _speed = speed;
     int sleepLength = 500000-(45000*speed);
 
-    _robotInterface->Move(RI_MOVE_LEFT, 10);
-    usleep(sleepLength);
-    _robotInterface->Move(RI_STOP, 0);
+    _move(RI_MOVE_LEFT, 10);
+    Util::pause(sleepLength / 1000000.0);
+    _move(RI_STOP, 0);
 
     // no robot strafes nicely, so turn a bit to fix it
     turnLeft(10);
@@ -829,9 +1318,9 @@ void Robot::strafeRight(int speed) {
     _speed = speed;
     int sleepLength = 500000-(45000*speed);
 
-    _robotInterface->Move(RI_MOVE_RIGHT, 10);
-    usleep(sleepLength);
-    _robotInterface->Move(RI_STOP, 0);
+    _move(RI_MOVE_RIGHT, 10);
+    Util::pause(sleepLength / 1000000.0);
+    _move(RI_STOP, 0);
 
     // no robot strafes nicely, so turn a bit to fix it
     turnRight(10);
@@ -843,9 +1332,63 @@ void Robot::strafeRight(int speed) {
  **************************************/
 void Robot::stop() {
 	_movingForward = true;
+	_diagonal = 0;
 	_speed = 0;
-    _robotInterface->Move(RI_STOP, 0);
-    sleep(1);
+    _move(RI_STOP, 0);
+    Util::pause(1);
+}
+
+/**************************************
+ * Definition: Sends a move to the robot interface through the
+ *             command layer (which drops repeats and coalesces
+ *             bursts), holding the interface lock so it's safe
+ *             from the pipeline's sense thread
+ *
+ * Parameters: the RI_* command and speed
+ **************************************/
+void Robot::_move(int command, int speed) {
+    _commands->lock();
+    _commands->move(command, speed);
+    _commands->unlock();
+}
+
+/**************************************
+ * Definition: Finds how long turnLeft and turnRight turn for
+ *             before they stop
+ *
+ * Parameters: the speed of the turn
+ *
+ * Returns:    seconds
+ **************************************/
+float Robot::_turnPulse(int speed) {
+    if (speed > TURN_PULSE_SPEED) {
+        return TURN_PULSE_LENGTH - TURN_PULSE_STEP * (speed - TURN_PULSE_SPEED);
+    }
+    return TURN_PULSE_LENGTH;
+}
+
+/**************************************
+ * Definition: Reserves a cell with the game server, holding the
+ *             interface lock since the pipeline may be using it
+ *
+ * Parameters: the cell to reserve
+ **************************************/
+void Robot::_reserveCell(Cell *cell) {
+    _commands->lock();
+    _map->reserveCell(cell->x, cell->y);
+    _commands->unlock();
+}
+
+/**************************************
+ * Definition: Occupies a cell with the game server, holding the
+ *             interface lock since the pipeline may be using it
+ *
+ * Parameters: the cell to occupy
+ **************************************/
+void Robot::_occupyCell(Cell *cell) {
+    _commands->lock();
+    _map->occupyCell(cell->x, cell->y);
+    _commands->unlock();
 }
 
 /**************************************
@@ -906,23 +1449,13 @@ bool Robot::isThereABitchInMyWay() {
 
 /**************************************
  * Definition: Attempts to update the robot interface a certain
- *             amount of times. Returns true on success.
+ *             amount of times, backing off between tries (the
+ *             interface lock must be held). Returns true on success.
  *
  * Returns:    bool specifying if we succeeded
  **************************************/
 bool Robot::_updateInterface() {
-    int failCount = 0;
-    int failLimit = getFailLimit();
-
-    while (_robotInterface->update() != RI_RESP_SUCCESS &&
-           failCount < failLimit) {
-        failCount++;
-    }
-
-    if (failCount >= failLimit) {
-        return false;
-    }
-    return true;
+    return _commands->update(getFailLimit());
 }
 
 /**************************************
@@ -984,9 +1517,9 @@ void Robot::printFailPhrase() {
  **************************************/
 void Robot::rockOut() {
     for (int i = 0; i < 1; i++) {
-        _robotInterface->Move(RI_HEAD_UP, 1);
-        sleep(1);
-        _robotInterface->Move(RI_HEAD_DOWN, 1);
-        sleep(1);
+        _move(RI_HEAD_UP, 1);
+        Util::pause(1);
+        _move(RI_HEAD_DOWN, 1);
+        Util::pause(1);
     }
 }
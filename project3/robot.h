@@ -24,7 +24,14 @@
 #include "north_star.h"
 #include "fir_filter.h"
 #include "kalman_filter.h"
+#include "extended_kalman_filter.h"
 #include "PID.h"
+#include "loop_scheduler.h"
+#include "robot_pipeline.h"
+#include "sensor_sample.h"
+#include "path_follower.h"
+#include "motion_profile.h"
+#include "command_layer.h"
 #include "utilities.h"
 #include "constants.h"
 
@@ -32,7 +39,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <robot_if++.h>
+#include "robot_interface.h"
+#include <pthread.h>
 #include <string>
 
 #define GOOD_NS_STRENGTH 13222
@@ -40,45 +48,11 @@
 #define MAX_CAMERA_BRIGHTNESS (0x7F)
 #define CAMERA_FRAMERATE 5
 
-#define NUM_SPEEDS 11
-
 #define DIR_LEFT 0
 #define DIR_RIGHT 1
 
 #define CELL_SIZE 65
 
-const float TIME_DISTANCE = 116.0; // cm
-
-// average speed to move forward TIME_DISTANCE at integer robot speeds
-const float SPEED_FORWARD[NUM_SPEEDS] = {
-    0.0,
-    TIME_DISTANCE/2.8,
-    TIME_DISTANCE/2.8,
-    TIME_DISTANCE/2.8,
-    TIME_DISTANCE/3.0,
-    TIME_DISTANCE/3.0,
-    TIME_DISTANCE/3.2,
-    TIME_DISTANCE/3.9,
-    TIME_DISTANCE/3.9,
-    TIME_DISTANCE/4.1,
-    TIME_DISTANCE/4.2
-};
-
-// average speed for left and right turns at integer robot speeds
-const float SPEED_TURN[][NUM_SPEEDS] = {
-    {0.0, 0.0},
-    {(2*PI)/2.75, -(2*PI)/2.81},
-    {(2*PI)/2.8, -(2*PI)/2.59},
-    {(2*PI)/3.75, -(2*PI)/3.75},
-    {(2*PI)/3.90, -(2*PI)/3.75},
-    {(2*PI)/5.80, -(2*PI)/6.05},
-    {(2*PI)/5.60, -(2*PI)/5.45},
-    {(2*PI)/4.50, -(2*PI)/4.39},
-    {(2*PI)/4.60, -(2*PI)/4.45},
-    {(2*PI)/5.00, -(2*PI)/5.02},
-    {(2*PI)/10.00, -(2*PI)/8.8}
-};
-
 class Robot {
 public:
     Robot(std::string address, int id);
@@ -88,6 +62,7 @@ public:
     void turn(int direction);
     void turn(int relDirection, float radians);
     void moveTo(float x, float y, float distErrorLimit);
+    int followPath(Path *path);
     float moveToUntil(float x, float y, float distErrorLimit, float thetaErrorLimit);
     void turnTo(float theta, float thetaErrorLimit);
     void turnCenter();
@@ -97,8 +72,17 @@ public:
     void setCameraResolution(int resolution, int quality);
     void prefillData();
     void updatePose(bool useWheelEncoders);
+    void updatePose(bool useWheelEncoders, float dt);
+    bool readSensors(SensorSample *sample);
+    void estimatePose(const SensorSample *sample, const MotionState *motion,
+                      bool useWheelEncoders, float dt);
+    void getEstimate(Estimate *estimate);
+    MotionState getMotionState();
+    MotionState issueCommand(const MotionCommand *command);
     void moveForward(int speed);
     void moveBackward(int speed);
+    void moveForwardLeft(int speed);
+    void moveForwardRight(int speed);
     void turnLeft(int speed);
     void turnRight(int speed);
     void strafeLeft(int speed);
@@ -122,8 +106,19 @@ private:
     bool _updateInterface();
     bool _centerTurn(float centerError);
     bool _centerStrafe(float centerError);
+    void _beginControl(bool useWheelEncoders);
+    float _nextEstimate(Estimate *estimate);
+    void _endControl();
+    void _command(int type, int speed);
+    void _move(int command, int speed);
+    float _turnPulse(int speed);
+    void _reserveCell(Cell *cell);
+    void _occupyCell(Cell *cell);
 
     RobotInterface *_robotInterface;
+    // held around every update, sensor read, and move, since the
+    // pipeline's sense and act threads share the interface
+    CommandLayer *_commands;
     int _name;
     
     int _failLimit;
@@ -131,15 +126,36 @@ private:
 	int _speed;	
 	char _turnDirection;
 	bool _movingForward;
+	char _diagonal;
     int _heading;
 
     int _numCellsTraveled;
 
+    PathFollower *_pathFollower;
+    // where we think the center of the cell at the end of the last
+    // path is, so the next path can pick up from it
+    Cell *_anchorCell;
+    float _anchorX;
+    float _anchorY;
+
     PID* _movePID;
     PID* _turnPID;
+    MotionProfile* _moveProfile;
+    MotionProfile* _turnProfile;
+    // how long a turn goes at each speed before it stops (seconds)
+    float _turnPulses[NUM_SPEEDS];
     PID* _centerTurnPID;
     PID* _centerStrafePID;
 
+    // paces the move and turn loops, and center's own loop (which
+    // turns with turnTo partway through)
+    LoopScheduler *_controlLoop;
+    LoopScheduler *_centerLoop;
+    // runs the move and turn loops on threads when USE_PIPELINE is set
+    RobotPipeline *_pipeline;
+    bool _pipelined;
+    bool _controlUsesWheelEncoders;
+
     Pose *_pose;
 
     KalmanFilter *_kalmanFilter;
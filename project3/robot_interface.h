@@ -0,0 +1,27 @@
+/**
+ * robot_interface.h
+ *
+ * @brief
+ *      Where everything gets RobotInterface from. Normally it's robot_if's,
+ *      talking to a real rovio. Building with USE_SIMULATOR (make sim)
+ *      swaps in data/fakerobot's SimRobotInterface instead, which has the
+ *      same calls but simulates the rovio and the game field
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_ROBOTINTERFACE_H
+#define CS1567_ROBOTINTERFACE_H
+
+#include <robot_if++.h>
+
+#ifdef USE_SIMULATOR
+#include "data/fakerobot/sim_robot_interface.h"
+#define RobotInterface SimRobotInterface
+#endif
+
+#endif
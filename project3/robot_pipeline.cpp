@@ -0,0 +1,279 @@
+/**
+ * robot_pipeline.cpp
+ *
+ * @brief
+ *      Runs a control loop's sensing, estimation, and motion commands on
+ *      three threads of their own, so a slow network update or a turn
+ *      command that blocks for half a second doesn't hold up the others.
+ *      The sense thread polls the robot interface and hands each sample
+ *      to the estimate thread, which runs the filters and the kalman
+ *      filter and hands each pose estimate to the control loop. The
+ *      control loop's commands go to the act thread, which only ever
+ *      sends the newest one. Samples go through a lock-free single
+ *      producer, single consumer queue, so none are skipped, and the
+ *      estimates and commands through lock-free mailboxes that only
+ *      keep the newest
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "robot_pipeline.h"
+#include "robot.h"
+#include "loop_scheduler.h"
+#include "constants.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef USE_SIMULATOR
+#include "data/fakerobot/sim_clock.h"
+#endif
+
+RobotPipeline::RobotPipeline(Robot *robot)
+: _robot(robot), _useWheelEncoders(true), _running(false),
+  _lastEstimate(0), _senseFailures(0) {
+    _samples = new SPSCQueue<SensorSample>(PIPELINE_QUEUE_SIZE);
+    _estimates = new Mailbox<Estimate>();
+    _commands = new Mailbox<MotionCommand>();
+    _issued = new Mailbox<MotionState>();
+}
+
+RobotPipeline::~RobotPipeline() {
+    stop();
+    delete _samples;
+    delete _estimates;
+    delete _commands;
+    delete _issued;
+}
+
+/**************************************
+ * Definition: Starts the sense, estimate, and act threads. Until
+ *             stop is called, only they may use the robot's sensors,
+ *             filters, and pose, and the control loop should only
+ *             use waitForEstimate and command
+ *
+ * Parameters: whether the estimate should use the wheel encoders
+ *
+ * Returns: false if the threads couldn't be started
+ **************************************/
+bool RobotPipeline::start(bool useWheelEncoders) {
+    if (_running) {
+        return true;
+    }
+
+    // nothing is running, so we can empty the queues from here
+    SensorSample sample;
+    Estimate estimate;
+    MotionCommand command;
+    MotionState state;
+    while (_samples->pop(&sample));
+    while (_estimates->take(&estimate));
+    while (_commands->take(&command));
+    while (_issued->take(&state));
+
+    _useWheelEncoders = useWheelEncoders;
+    _startMotion = _robot->getMotionState();
+    _lastEstimate = 0;
+    _senseFailures = 0;
+    _running = true;
+    __sync_synchronize();
+
+    if (pthread_create(&_senseThread, NULL, _sense, this) != 0) {
+        printf("couldn't start the sense thread\n");
+        _running = false;
+        return false;
+    }
+    if (pthread_create(&_estimateThread, NULL, _estimate, this) != 0) {
+        printf("couldn't start the estimate thread\n");
+        _running = false;
+        pthread_join(_senseThread, NULL);
+        return false;
+    }
+    if (pthread_create(&_actThread, NULL, _act, this) != 0) {
+        printf("couldn't start the act thread\n");
+        _running = false;
+        pthread_join(_senseThread, NULL);
+        pthread_join(_estimateThread, NULL);
+        return false;
+    }
+    return true;
+}
+
+/**************************************
+ * Definition: Stops the threads and waits for them to finish (the
+ *             act thread finishes the command it's sending first).
+ *             Afterward the robot's pose is the last estimate
+ **************************************/
+void RobotPipeline::stop() {
+    if (!_running) {
+        return;
+    }
+    _running = false;
+    __sync_synchronize();
+
+    pthread_join(_senseThread, NULL);
+    pthread_join(_estimateThread, NULL);
+    pthread_join(_actThread, NULL);
+
+    printf("pipeline: %d failed updates, %d samples dropped, %d estimates "
+           "and %d commands replaced\n",
+           _senseFailures, _samples->getDropped(),
+           _estimates->getReplaced(), _commands->getReplaced());
+}
+
+/**************************************
+ * Definition: Returns whether the threads are running
+ *
+ * Returns: true if they've been started and not stopped
+ **************************************/
+bool RobotPipeline::isRunning() {
+    return _running;
+}
+
+/**************************************
+ * Definition: Waits until there's an estimate newer than the last
+ *             one we returned, and skips to the newest if several
+ *             have piled up
+ *
+ * Parameters: where to put the estimate
+ *
+ * Returns: seconds between the samples behind this estimate
+ *          and the last one
+ **************************************/
+float RobotPipeline::waitForEstimate(Estimate *estimate) {
+    while (!_estimates->take(estimate)) {
+        _idle();
+    }
+
+    float dt = CONTROL_LOOP_PERIOD;
+    if (_lastEstimate > 0) {
+        dt = estimate->time - _lastEstimate;
+    }
+    _lastEstimate = estimate->time;
+    return dt;
+}
+
+/**************************************
+ * Definition: Leaves a motion command for the act thread. If it's
+ *             still busy sending an older one, this replaces any
+ *             other it hasn't started yet
+ *
+ * Parameters: the command type (CMD_*) and speed
+ **************************************/
+void RobotPipeline::command(int type, int speed) {
+    MotionCommand command = {type, speed};
+    _commands->put(command);
+}
+
+/**************************************
+ * Definition: Returns the time on the monotonic clock (or the
+ *             simulator's clock)
+ *
+ * Returns: seconds as a double
+ **************************************/
+double RobotPipeline::now() {
+#ifdef USE_SIMULATOR
+    return SimClock::now();
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1000000000.0;
+#endif
+}
+
+/**************************************
+ * Definition: The sense thread. Updates the robot interface at the
+ *             control loop rate and passes on every sample
+ *
+ * Parameters: the pipeline
+ **************************************/
+void *RobotPipeline::_sense(void *pipeline) {
+    RobotPipeline *self = (RobotPipeline *)pipeline;
+    LoopScheduler schedule(CONTROL_LOOP_RATE);
+
+    schedule.start();
+    while (self->_running) {
+        schedule.wait();
+
+        SensorSample sample;
+        if (!self->_robot->readSensors(&sample)) {
+            self->_senseFailures++;
+        }
+        self->_samples->push(sample);
+    }
+
+    schedule.printStats("sense");
+    return NULL;
+}
+
+/**************************************
+ * Definition: The estimate thread. Runs every sample through the
+ *             filters in order, using the newest command the act
+ *             thread has sent, and passes on each estimate
+ *
+ * Parameters: the pipeline
+ **************************************/
+void *RobotPipeline::_estimate(void *pipeline) {
+    RobotPipeline *self = (RobotPipeline *)pipeline;
+    // until the act thread sends something
+    MotionState motion = self->_startMotion;
+    double lastSample = 0;
+
+    while (self->_running) {
+        SensorSample sample;
+        if (!self->_samples->pop(&sample)) {
+            _idle();
+            continue;
+        }
+        self->_issued->take(&motion);
+
+        float dt = 0;
+        if (lastSample > 0) {
+            dt = sample.time - lastSample;
+        }
+        lastSample = sample.time;
+
+        self->_robot->estimatePose(&sample, &motion, self->_useWheelEncoders, dt);
+
+        Estimate estimate;
+        self->_robot->getEstimate(&estimate);
+        estimate.time = sample.time;
+        self->_estimates->put(estimate);
+    }
+    return NULL;
+}
+
+/**************************************
+ * Definition: The act thread. Sends the newest motion command,
+ *             however long it takes, and tells the estimate thread
+ *             how the robot is moving now
+ *
+ * Parameters: the pipeline
+ **************************************/
+void *RobotPipeline::_act(void *pipeline) {
+    RobotPipeline *self = (RobotPipeline *)pipeline;
+
+    while (self->_running) {
+        MotionCommand command;
+        if (!self->_commands->take(&command)) {
+            _idle();
+            continue;
+        }
+        MotionState motion = self->_robot->issueCommand(&command);
+        self->_issued->put(motion);
+    }
+    return NULL;
+}
+
+/**************************************
+ * Definition: Gives up the processor for a moment while a
+ *             thread waits on an empty queue
+ **************************************/
+void RobotPipeline::_idle() {
+    usleep(PIPELINE_IDLE_USEC);
+}
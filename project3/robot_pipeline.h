@@ -0,0 +1,110 @@
+/**
+ * robot_pipeline.h
+ *
+ * @brief
+ *      Runs a control loop's sensing, estimation, and motion commands on
+ *      three threads of their own, so a slow network update or a turn
+ *      command that blocks for half a second doesn't hold up the others.
+ *      The sense thread polls the robot interface and hands each sample
+ *      to the estimate thread, which runs the filters and the kalman
+ *      filter and hands each pose estimate to the control loop. The
+ *      control loop's commands go to the act thread, which only ever
+ *      sends the newest one. Samples go through a lock-free single
+ *      producer, single consumer queue, since every one is filtered.
+ *      The other handoffs only care about the newest value, so they go
+ *      through lock-free mailboxes, where a new value replaces one that
+ *      hasn't been taken yet
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_ROBOTPIPELINE_H
+#define CS1567_ROBOTPIPELINE_H
+
+#include "sensor_sample.h"
+#include "spsc_queue.h"
+#include "mailbox.h"
+
+#include <pthread.h>
+
+class Robot; // so we can avoid circular dependency
+
+// motion commands the act thread can send
+#define CMD_FORWARD 0
+#define CMD_BACKWARD 1
+#define CMD_TURN_LEFT 2
+#define CMD_TURN_RIGHT 3
+#define CMD_STRAFE_LEFT 4
+#define CMD_STRAFE_RIGHT 5
+#define CMD_STOP 6
+#define CMD_FORWARD_LEFT 7
+#define CMD_FORWARD_RIGHT 8
+
+struct MotionCommand {
+    int type;
+    int speed;
+};
+
+// how the robot was last told to move, for the kalman filter's prediction
+struct MotionState {
+    int speed;
+    bool movingForward;
+    char turnDirection;
+    // 1 if moving forward is diagonal to the left, -1 to the right
+    char diagonal;
+};
+
+// a pose estimate, with north star's own theta alongside the kalman one
+struct Estimate {
+    double time;
+    float x;
+    float y;
+    float theta;
+    float nsTheta;
+};
+
+class RobotPipeline {
+public:
+    RobotPipeline(Robot *robot);
+    ~RobotPipeline();
+    bool start(bool useWheelEncoders);
+    void stop();
+    bool isRunning();
+    float waitForEstimate(Estimate *estimate);
+    void command(int type, int speed);
+    static double now();
+private:
+    Robot *_robot;
+    bool _useWheelEncoders;
+    // how the robot was moving when we started
+    MotionState _startMotion;
+    volatile bool _running;
+
+    pthread_t _senseThread;
+    pthread_t _estimateThread;
+    pthread_t _actThread;
+
+    // sense -> estimate
+    SPSCQueue<SensorSample> *_samples;
+    // estimate -> control loop
+    Mailbox<Estimate> *_estimates;
+    // control loop -> act, only the newest
+    Mailbox<MotionCommand> *_commands;
+    // act -> estimate, each time a command has been sent
+    Mailbox<MotionState> *_issued;
+
+    double _lastEstimate;
+    // written only by the sense thread while running
+    int _senseFailures;
+
+    static void *_sense(void *pipeline);
+    static void *_estimate(void *pipeline);
+    static void *_act(void *pipeline);
+    static void _idle();
+};
+
+#endif
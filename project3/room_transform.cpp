@@ -0,0 +1,125 @@
+/**
+ * room_transform.cpp
+ *
+ * @brief
+ *      Converts north star readings from one room's coordinates into the
+ *      global coordinate system and back. The rotation, theta shift,
+ *      scale, and translation of a room's calibration are combined once
+ *      into a single 2x3 affine matrix (and its inverse), so a reading
+ *      only costs a few multiply-adds. Room 2's position-dependent skew
+ *      can't be folded in, so it is kept as its own step, and stands in
+ *      for the rotation on x and y (room 2's rotation only turns theta)
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#include "room_transform.h"
+#include "constants.h"
+
+#include <math.h>
+
+RoomTransform::RoomTransform()
+: _thetaOffset(0), _skew(false) {
+    // the identity until set
+    for (int i = 0; i < 6; i++) {
+        _toGlobal[i] = (i == 0 || i == 4) ? 1 : 0;
+        _toRoom[i] = _toGlobal[i];
+    }
+}
+
+/**************************************
+ * Definition: Builds the transforms for a room: rotate by the
+ *             room's rotation (room 2 is skewed instead), divide by
+ *             its scale, then translate by its origin
+ *
+ * Parameters: the room and its calibration
+ **************************************/
+void RoomTransform::set(int room, RoomCalibration *calibration) {
+    float c = cos(calibration->rotation);
+    float s = sin(calibration->rotation);
+    float sx = calibration->scaleX;
+    float sy = calibration->scaleY;
+    float tx = COL_OFFSET[0] + calibration->originX;
+    float ty = COL_OFFSET[1] + calibration->originY;
+
+    _skew = (room == ROOM_2);
+    // room 2's skew takes the place of the rotation for x and y, so
+    // its rotation only turns theta
+    if (_skew) {
+        c = 1;
+        s = 0;
+    }
+
+    _toGlobal[0] = c / sx;
+    _toGlobal[1] = -s / sx;
+    _toGlobal[2] = tx;
+    _toGlobal[3] = s / sy;
+    _toGlobal[4] = c / sy;
+    _toGlobal[5] = ty;
+
+    // the inverse of the rotation, scale, and translation
+    _toRoom[0] = c * sx;
+    _toRoom[1] = s * sy;
+    _toRoom[2] = -(c * sx * tx + s * sy * ty);
+    _toRoom[3] = -s * sx;
+    _toRoom[4] = c * sy;
+    _toRoom[5] = s * sx * tx - c * sy * ty;
+
+    _thetaOffset = -calibration->rotation - calibration->thetaShift;
+}
+
+/**************************************
+ * Definition: Converts a reading into global coordinates in place.
+ *             Theta is left for the caller to normalize
+ *
+ * Parameters: pointers to the x, y, and theta to convert
+ **************************************/
+void RoomTransform::toGlobal(float *x, float *y, float *theta) {
+    if (_skew) {
+        // each axis is rotated by an angle fit to where we are
+        float xAngle = NS_ROOM_2_SKEW_SLOPE * (*x) + NS_ROOM_2_SKEW_OFFSET;
+        float yAngle = NS_ROOM_2_SKEW_SLOPE * (*y) + NS_ROOM_2_SKEW_OFFSET;
+        float skewX = (*x) * cos(xAngle) - (*y) * sin(xAngle);
+        float skewY = (*x) * sin(yAngle) + (*y) * cos(yAngle);
+        *x = skewX;
+        *y = skewY;
+    }
+    _apply(_toGlobal, x, y);
+    *theta += _thetaOffset;
+}
+
+/**************************************
+ * Definition: Converts a global x and y back into room coordinates
+ *             in place (without undoing room 2's skew)
+ *
+ * Parameters: pointers to the x and y to convert
+ **************************************/
+void RoomTransform::toRoom(float *x, float *y) {
+    _apply(_toRoom, x, y);
+}
+
+/**************************************
+ * Definition: Converts many global x and y back into room
+ *             coordinates in place (without undoing room 2's skew)
+ *
+ * Parameters: the poses to convert
+ **************************************/
+void RoomTransform::toRoom(PoseArray *poses) {
+    poses->transform(_toRoom);
+}
+
+/**************************************
+ * Definition: Applies a 2x3 affine matrix to x and y in place
+ *
+ * Parameters: the matrix and pointers to x and y
+ **************************************/
+void RoomTransform::_apply(const float *matrix, float *x, float *y) {
+    float newX = matrix[0] * (*x) + matrix[1] * (*y) + matrix[2];
+    float newY = matrix[3] * (*x) + matrix[4] * (*y) + matrix[5];
+    *x = newX;
+    *y = newY;
+}
@@ -0,0 +1,44 @@
+/**
+ * room_transform.h
+ *
+ * @brief
+ *      Converts north star readings from one room's coordinates into the
+ *      global coordinate system and back. The rotation, theta shift,
+ *      scale, and translation of a room's calibration are combined once
+ *      into a single 2x3 affine matrix (and its inverse), so a reading
+ *      only costs a few multiply-adds. Room 2's position-dependent skew
+ *      can't be folded in, so it is kept as its own step
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_ROOMTRANSFORM_H
+#define CS1567_ROOMTRANSFORM_H
+
+#include "ns_calibration.h"
+#include "pose_array.h"
+
+class RoomTransform {
+public:
+    RoomTransform();
+    void set(int room, RoomCalibration *calibration);
+    void toGlobal(float *x, float *y, float *theta);
+    void toRoom(float *x, float *y);
+    void toRoom(PoseArray *poses);
+private:
+    // {a, b, c, d, e, f}: x' = a x + b y + c, y' = d x + e y + f
+    float _toGlobal[6];
+    float _toRoom[6];
+    // added to theta (before normalizing)
+    float _thetaOffset;
+    // whether to correct for room 2's skew before _toGlobal
+    bool _skew;
+
+    static void _apply(const float *matrix, float *x, float *y);
+};
+
+#endif
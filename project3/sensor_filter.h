@@ -0,0 +1,34 @@
+/**
+ * sensor_filter.h
+ *
+ * @brief
+ *      The interface north star and the wheel encoders smooth their
+ *      readings through, so each can use either FIR filters (FIRBank)
+ *      or IIR ones (IIRBank) depending on constants.h. Every channel
+ *      (x, y, theta, or one wheel) is filtered on its own, but all of a
+ *      sensor's channels are filtered in one call
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_SENSORFILTER_H
+#define CS1567_SENSORFILTER_H
+
+#include <vector>
+
+class SensorFilter {
+public:
+    virtual ~SensorFilter() {}
+    virtual int getNumChannels() = 0;
+    virtual int getOrder(int channel) = 0;
+    virtual void seed(int channel, std::vector<float> *samples) = 0;
+    virtual void seed(int channel, float value) = 0;
+    virtual void filter(const float *values, float *filtered) = 0;
+    virtual float getValue(int channel) = 0;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * sensor_sample.h
+ *
+ * @brief
+ *      One reading of everything the position sensors use, copied out of
+ *      the robot interface right after an update. North star and the
+ *      wheel encoders work from a sample rather than asking the interface
+ *      themselves, so the sensing and estimation can run on different
+ *      threads without both touching the interface
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_SENSORSAMPLE_H
+#define CS1567_SENSORSAMPLE_H
+
+struct SensorSample {
+    // seconds on the monotonic clock when the update finished
+    double time;
+    // false if the interface never updated (the values are the old ones)
+    bool updated;
+    // north star room, starting at 0
+    int room;
+    // raw north star reading
+    float nsX;
+    float nsY;
+    float nsTheta;
+    // raw wheel encoder ticks
+    float wheelLeft;
+    float wheelRight;
+    float wheelRear;
+};
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * spsc_queue.h
+ *
+ * @brief
+ *      A fixed size queue for handing data from exactly one thread to
+ *      exactly one other without locking. The producer only ever moves
+ *      the tail and the consumer only ever moves the head, so each
+ *      index has one writer, and a memory barrier between writing a
+ *      slot and publishing its index makes sure the other side never
+ *      sees an index before the data behind it
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_SPSCQUEUE_H
+#define CS1567_SPSCQUEUE_H
+
+template <typename T>
+class SPSCQueue {
+public:
+    SPSCQueue(int capacity);
+    ~SPSCQueue();
+    bool push(const T &value);
+    bool pop(T *value);
+    bool popNewest(T *value);
+    bool isEmpty();
+    int getDropped();
+private:
+    // one slot is always left empty, so a full queue
+    // can be told apart from an empty one
+    int _size;
+    T *_slots;
+    // next slot to read (consumer's) and to write (producer's)
+    volatile int _head;
+    volatile int _tail;
+    // pushes turned away because the queue was full (producer's)
+    volatile int _dropped;
+
+    int _advance(int index);
+};
+
+template <typename T>
+SPSCQueue<T>::SPSCQueue(int capacity)
+: _size(capacity + 1), _head(0), _tail(0), _dropped(0) {
+    _slots = new T[_size];
+}
+
+template <typename T>
+SPSCQueue<T>::~SPSCQueue() {
+    delete[] _slots;
+}
+
+/**************************************
+ * Definition: Adds a value to the back of the queue. Only the
+ *             producer thread may call this
+ *
+ * Parameters: the value to add
+ *
+ * Returns: false (and drops the value) if the queue was full
+ **************************************/
+template <typename T>
+bool SPSCQueue<T>::push(const T &value) {
+    int next = _advance(_tail);
+    if (next == _head) {
+        _dropped++;
+        return false;
+    }
+    _slots[_tail] = value;
+    // the slot has to be written before the consumer can see it
+    __sync_synchronize();
+    _tail = next;
+    return true;
+}
+
+/**************************************
+ * Definition: Takes the value at the front of the queue. Only the
+ *             consumer thread may call this
+ *
+ * Parameters: where to put the value
+ *
+ * Returns: false (leaving value alone) if the queue was empty
+ **************************************/
+template <typename T>
+bool SPSCQueue<T>::pop(T *value) {
+    if (_head == _tail) {
+        return false;
+    }
+    // don't read the slot until we've seen the tail that published it
+    __sync_synchronize();
+    *value = _slots[_head];
+    // and finish reading it before the producer can reuse it
+    __sync_synchronize();
+    _head = _advance(_head);
+    return true;
+}
+
+/**************************************
+ * Definition: Empties the queue, keeping only the newest value, for
+ *             consumers that only care about the latest. Only the
+ *             consumer thread may call this
+ *
+ * Parameters: where to put the value
+ *
+ * Returns: false (leaving value alone) if the queue was empty
+ **************************************/
+template <typename T>
+bool SPSCQueue<T>::popNewest(T *value) {
+    bool popped = false;
+    while (pop(value)) {
+        popped = true;
+    }
+    return popped;
+}
+
+/**************************************
+ * Definition: Checks whether there's anything to pop
+ *
+ * Returns: true if the queue was empty when we looked
+ **************************************/
+template <typename T>
+bool SPSCQueue<T>::isEmpty() {
+    return _head == _tail;
+}
+
+/**************************************
+ * Definition: Returns how many pushes were dropped because
+ *             the consumer fell behind
+ *
+ * Returns: an int with the count
+ **************************************/
+template <typename T>
+int SPSCQueue<T>::getDropped() {
+    return _dropped;
+}
+
+template <typename T>
+int SPSCQueue<T>::_advance(int index) {
+    return (index + 1 == _size) ? 0 : index + 1;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * test_check.h
+ *
+ * @brief
+ *      How the tests report. check prints one named check and counts it
+ *      if it failed, checkWithin does the same for a worst difference
+ *      against a tolerance, and finish prints PASSED or FAILED for the
+ *      whole test and gives main what to return
+ *
+ * @author
+ *      Shawn Hanna
+ *      Tom Nason
+ *      Joel Griffith
+ *
+ **/
+
+#ifndef CS1567_TESTCHECK_H
+#define CS1567_TESTCHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static inline void check(const char *name, bool passed) {
+    printf("%s: %s\n", name, passed ? "ok" : "FAILED");
+    if (!passed) {
+        failures++;
+    }
+}
+
+static inline void checkWithin(const char *name, double worst, double tolerance) {
+    printf("%s: worst difference %g\n", name, worst);
+    check(name, worst <= tolerance);
+}
+
+static inline int finish() {
+    if (failures > 0) {
+        printf("FAILED (%d)\n", failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,149 @@
+// built with USE_SIMULATOR, so the command layer runs on the simulator's
+// clock and talks to SimRobotInterface. this file stands in for the
+// simulator's interface with just the calls the command layer makes,
+// recording every command that reaches the rovio
+#include "../command_layer.h"
+#include "../constants.h"
+#include "../data/fakerobot/sim_clock.h"
+#include "test_check.h"
+#include <stdio.h>
+
+#define MAX_SENT 1000
+
+// how many pulses each sequence sends
+#define NUM_PULSES 20
+// how long a control loop pass takes between pulses through the
+// pipeline's act thread (seconds), well inside COMMAND_MIN_INTERVAL
+#define PULSE_GAP 0.01
+
+int sentCommands[MAX_SENT];
+int numSent = 0;
+
+SimRobotInterface::SimRobotInterface(std::string address, int id) {}
+SimRobotInterface::~SimRobotInterface() {}
+
+int SimRobotInterface::Move(int movement, int speed) {
+    if (numSent < MAX_SENT) {
+        sentCommands[numSent] = movement;
+    }
+    numSent++;
+    return RI_RESP_SUCCESS;
+}
+
+int SimRobotInterface::update(void) {
+    return RI_RESP_SUCCESS;
+}
+
+// what Robot::turnLeft and turnRight do: a drive command, a pause
+// while it turns, and a stop
+void turnPulse(CommandLayer *commands, int direction, int speed, float length) {
+    commands->move(direction, speed);
+    SimClock::advance(length);
+    commands->move(RI_STOP, 0);
+}
+
+// and Robot::strafeLeft and strafeRight: a strafe, a stop, and then
+// straight into a short turn to fix the heading
+void strafePulse(CommandLayer *commands, int direction, int turn, int speed) {
+    commands->move(direction, 10);
+    SimClock::advance((500000 - 45000 * speed) / 1000000.0);
+    commands->move(RI_STOP, 0);
+    turnPulse(commands, turn, TURN_PULSE_SPEED,
+              TURN_PULSE_LENGTH - TURN_PULSE_STEP * (10 - TURN_PULSE_SPEED));
+}
+
+// counts how many times each command reached the rovio, and makes
+// sure no two drive commands went out without a stop in between
+void checkSent(const char *name, int first, int firstCount,
+               int second, int secondCount) {
+    int counts[2] = {0, 0};
+    bool stopped = true;
+    bool paired = true;
+    for (int i = 0; i < numSent && i < MAX_SENT; i++) {
+        int command = sentCommands[i];
+        if (command == first) {
+            counts[0]++;
+        }
+        else if (command == second) {
+            counts[1]++;
+        }
+
+        if (command == RI_STOP) {
+            stopped = true;
+        }
+        else {
+            paired = paired && stopped;
+            stopped = false;
+        }
+    }
+
+    printf("%s: %d sent, %d and %d of the drive commands\n",
+           name, numSent, counts[0], counts[1]);
+    char label[128];
+    sprintf(label, "%s sends every drive command", name);
+    check(label, counts[0] == firstCount && counts[1] == secondCount);
+    sprintf(label, "%s stops after each one", name);
+    check(label, paired && stopped);
+}
+
+int main() {
+    SimRobotInterface robotInterface("sim", 1);
+
+    // turnTo through the pipeline: a pulse every pass, the same way
+    // each time, with the next one right on the last one's stop
+    CommandLayer turns(&robotInterface);
+    numSent = 0;
+    for (int i = 0; i < NUM_PULSES; i++) {
+        turnPulse(&turns, RI_TURN_LEFT, 5, TURN_PULSE_LENGTH);
+        SimClock::advance(PULSE_GAP);
+    }
+    checkSent("turn pulses", RI_TURN_LEFT, NUM_PULSES, RI_TURN_RIGHT, 0);
+
+    // slow turns are shorter pulses, and turning back and forth
+    // changes the command every pass
+    CommandLayer slowTurns(&robotInterface);
+    numSent = 0;
+    for (int i = 0; i < NUM_PULSES; i++) {
+        int direction = (i % 2 == 0) ? RI_TURN_LEFT : RI_TURN_RIGHT;
+        turnPulse(&slowTurns, direction, TURN_PULSE_SPEED,
+                  TURN_PULSE_LENGTH - TURN_PULSE_STEP * (10 - TURN_PULSE_SPEED));
+        SimClock::advance(PULSE_GAP);
+    }
+    checkSent("slow turn pulses", RI_TURN_LEFT, NUM_PULSES / 2,
+              RI_TURN_RIGHT, NUM_PULSES / 2);
+
+    // centering by strafing, at the fastest (shortest) strafe
+    CommandLayer strafes(&robotInterface);
+    numSent = 0;
+    for (int i = 0; i < NUM_PULSES; i++) {
+        strafePulse(&strafes, RI_MOVE_LEFT, RI_TURN_LEFT, 10);
+        SimClock::advance(PULSE_GAP);
+    }
+    checkSent("strafe pulses", RI_MOVE_LEFT, NUM_PULSES, RI_TURN_LEFT, NUM_PULSES);
+
+    // a drive command right on the heels of another one waits, but
+    // the stop after it still lets it out first
+    CommandLayer burst(&robotInterface);
+    numSent = 0;
+    burst.move(RI_MOVE_FORWARD, 5);
+    SimClock::advance(PULSE_GAP);
+    turnPulse(&burst, RI_TURN_LEFT, 5, TURN_PULSE_LENGTH);
+    printf("turn just after a drive: %d sent\n", numSent);
+    check("turn just after a drive goes out before the stop",
+          numSent == 3 && sentCommands[0] == RI_MOVE_FORWARD &&
+          sentCommands[1] == RI_TURN_LEFT && sentCommands[2] == RI_STOP);
+
+    // while a burst of drive commands only sends the newest
+    CommandLayer coalesced(&robotInterface);
+    numSent = 0;
+    coalesced.move(RI_MOVE_FORWARD, 5);
+    coalesced.move(RI_TURN_LEFT, 5);
+    coalesced.move(RI_TURN_RIGHT, 5);
+    SimClock::advance(COMMAND_MIN_INTERVAL);
+    coalesced.flush();
+    check("a burst sends the first and newest",
+          numSent == 2 && sentCommands[1] == RI_TURN_RIGHT &&
+          coalesced.getCoalesced() == 1);
+
+    return finish();
+}
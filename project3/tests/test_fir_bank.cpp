@@ -0,0 +1,87 @@
+#include "../fir_bank.h"
+#include "../fir_filter.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define NUM_SAMPLES 2000
+#define NUM_FILES 4
+
+// runs the same samples through a bank and through a separate
+// FIRFilter per channel, reseeding channels at different times with a
+// value and with long, short, and empty vectors, and returns the worst
+// difference (which should be none at all)
+float compare(std::vector<std::string> *fileNames) {
+    FIRBank bank(fileNames);
+    int numChannels = fileNames->size();
+    std::vector<FIRFilter*> filters;
+    for (int c = 0; c < numChannels; c++) {
+        filters.push_back(new FIRFilter((*fileNames)[c]));
+    }
+
+    std::vector<float> longSeed(20);
+    for (int i = 0; i < 20; i++) {
+        longSeed[i] = i * 1.5 - 4;
+    }
+    std::vector<float> shortSeed(2, -7.25);
+    std::vector<float> emptySeed;
+
+    std::vector<float> values(numChannels);
+    std::vector<float> filtered(numChannels);
+    srand(1567);
+    float worst = 0;
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        for (int c = 0; c < numChannels; c++) {
+            // each channel gets reseeded on its own schedule
+            switch ((i + 53 * c) % 300) {
+            case 37:
+                bank.seed(c, 12.5);
+                filters[c]->seed(12.5);
+                break;
+            case 91:
+                bank.seed(c, &longSeed);
+                filters[c]->seed(&longSeed);
+                break;
+            case 143:
+                bank.seed(c, &shortSeed);
+                filters[c]->seed(&shortSeed);
+                break;
+            case 201:
+                bank.seed(c, &emptySeed);
+                filters[c]->seed(&emptySeed);
+                break;
+            }
+            values[c] = rand() % 2000 - 1000;
+        }
+
+        bank.filter(&values[0], &filtered[0]);
+        for (int c = 0; c < numChannels; c++) {
+            float expected = filters[c]->filter(values[c]);
+            worst = fmax(worst, fabs(filtered[c] - expected));
+            worst = fmax(worst, fabs(bank.getValue(c) - expected));
+        }
+    }
+
+    for (int c = 0; c < numChannels; c++) {
+        delete filters[c];
+    }
+    return worst;
+}
+
+int main() {
+    // one shared file, like the wheel encoders
+    std::vector<std::string> shared(3, "../filters/we.ffc");
+    checkWithin("three channels of we.ffc", compare(&shared), 0);
+
+    // a different length on every channel, like north star, so the
+    // shorter ones are padded with zero taps
+    const char *files[NUM_FILES] = {
+        "../filters/we.ffc", "../filters/ns_x.ffc",
+        "../filters/ns_theta.ffc", "../filters/ns_y_old.ffc"
+    };
+    std::vector<std::string> mixed(files, files + NUM_FILES);
+    checkWithin("8, 3, 1, and 7 tap channels", compare(&mixed), 0);
+
+    return finish();
+}
@@ -0,0 +1,71 @@
+#include "../fir_filter.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define NUM_SAMPLES 5000
+#define LONG_TAPS 100
+#define LONG_FILE "test_fir_block.ffc"
+#define FFT_TOLERANCE 1e-3
+
+// filters the same data one sample at a time and in uneven runs,
+// switching back to single samples partway, and returns the worst
+// difference between the two
+float compare(std::string fileName) {
+    FIRFilter *single = new FIRFilter(fileName);
+    FIRFilter *block = new FIRFilter(fileName);
+    float values[NUM_SAMPLES];
+    float expected[NUM_SAMPLES];
+    float filtered[NUM_SAMPLES];
+
+    srand(1567);
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        values[i] = rand() % 2000 - 1000;
+        expected[i] = single->filter(values[i]);
+    }
+
+    int i = 0;
+    int run = 1;
+    while (i < NUM_SAMPLES) {
+        if (run % 5 == 0) {
+            filtered[i] = block->filter(values[i]);
+            i++;
+        }
+        else {
+            int length = run * 37 % 700 + 1;
+            if (i + length > NUM_SAMPLES) {
+                length = NUM_SAMPLES - i;
+            }
+            block->filter(&values[i], &filtered[i], length);
+            i += length;
+        }
+        run++;
+    }
+
+    float worst = 0;
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        worst = fmax(worst, fabs(filtered[i] - expected[i]));
+    }
+    delete single;
+    delete block;
+    return worst;
+}
+
+int main() {
+    FILE *f = fopen(LONG_FILE, "w");
+    for (int i = 0; i < LONG_TAPS; i++) {
+        fprintf(f, "%f\n", (i % 7 - 3) / 50.0);
+    }
+    fclose(f);
+
+    float we = compare("../filters/we.ffc");
+    float cam = compare("../filters/cam_slope_error.ffc");
+    float longTaps = compare(LONG_FILE);
+    remove(LONG_FILE);
+
+    checkWithin("we.ffc (8 taps)", we, 0);
+    checkWithin("cam_slope_error.ffc (5 taps)", cam, 0);
+    checkWithin("long filter (fft)", longTaps, FFT_TOLERANCE);
+    return finish();
+}
@@ -0,0 +1,109 @@
+#include "../fir_filter.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <math.h>
+
+#define NUM_SAMPLES 2000
+
+// FIRFilter as it was before the fixed size filters, for comparing
+// against: a plain ring buffer with its seeding quirks (seeding with
+// a value fills all but the last sample, seeding with a vector only
+// fills as many as it has, and both start the ring over)
+class BaselineFIR {
+public:
+    BaselineFIR(std::string fileName) : _nextSample(0) {
+        std::ifstream f(fileName.c_str());
+        std::string line;
+        while (std::getline(f, line)) {
+            _coefficients.push_back(atof(line.c_str()));
+        }
+        _samples.resize(_coefficients.size());
+    }
+
+    void seed(std::vector<float> *samples) {
+        int numSamples = _samples.size();
+        if ((int)samples->size() < numSamples) {
+            numSamples = samples->size();
+        }
+        for (int i = 0; i < numSamples; i++) {
+            _samples[i] = (*samples)[i];
+        }
+        _nextSample = 0;
+    }
+
+    void seed(float value) {
+        for (int i = 0; i < (int)_samples.size() - 1; i++) {
+            _samples[i] = value;
+        }
+    }
+
+    float filter(float val) {
+        int numTaps = _samples.size();
+        float sum = 0;
+        _samples[_nextSample] = val;
+        for (int i = 0, j = _nextSample; i < numTaps; i++) {
+            sum += _coefficients[i] * _samples[j++];
+            if (j == numTaps) {
+                j = 0;
+            }
+        }
+        if (++_nextSample == numTaps) {
+            _nextSample = 0;
+        }
+        return sum;
+    }
+
+private:
+    std::vector<float> _coefficients;
+    std::vector<float> _samples;
+    int _nextSample;
+};
+
+// runs the same samples through both, reseeding partway with a value,
+// with more samples than there are taps, with fewer, and with none,
+// and returns the worst difference (which should be none at all)
+float compare(std::string fileName) {
+    FIRFilter filter(fileName);
+    BaselineFIR baseline(fileName);
+
+    std::vector<float> longSeed(20, 3.5);
+    std::vector<float> shortSeed(2, -7.25);
+    std::vector<float> emptySeed;
+
+    srand(1567);
+    float worst = 0;
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        switch (i % 250) {
+        case 37:
+            filter.seed(12.5);
+            baseline.seed(12.5);
+            break;
+        case 91:
+            filter.seed(&longSeed);
+            baseline.seed(&longSeed);
+            break;
+        case 143:
+            filter.seed(&shortSeed);
+            baseline.seed(&shortSeed);
+            break;
+        case 201:
+            filter.seed(&emptySeed);
+            baseline.seed(&emptySeed);
+            break;
+        }
+
+        float value = rand() % 2000 - 1000;
+        worst = fmax(worst, fabs(filter.filter(value) - baseline.filter(value)));
+    }
+    return worst;
+}
+
+int main() {
+    checkWithin("we.ffc (8 taps, fixed)", compare("../filters/we.ffc"), 0);
+    checkWithin("ns_x.ffc (3 taps, fixed)", compare("../filters/ns_x.ffc"), 0);
+    checkWithin("ns_theta.ffc (1 tap, fixed)", compare("../filters/ns_theta.ffc"), 0);
+    checkWithin("ns_y_old.ffc (7 taps)", compare("../filters/ns_y_old.ffc"), 0);
+    return finish();
+}
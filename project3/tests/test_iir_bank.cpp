@@ -0,0 +1,45 @@
+#include "../iir_bank.h"
+#include "../constants.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <math.h>
+
+#define NUM_STEPS 200
+#define CUTOFF 0.1
+#define TOLERANCE 1e-3
+
+int main() {
+    int types[3] = {FILTER_ONE_POLE, FILTER_BIQUAD, FILTER_ALPHA_BETA};
+    const char *names[3] = {"one-pole", "biquad", "alpha-beta"};
+    for (int t = 0; t < 3; t++) {
+        // channel 0 stays where it was seeded, channel 1 ramps
+        IIRBank *bank = new IIRBank(2, types[t], CUTOFF);
+        bank->seed(0, 50.0f);
+        bank->seed(1, 0.0f);
+
+        float values[2];
+        float filtered[2];
+        float worstHold = 0;
+        for (int i = 0; i < NUM_STEPS; i++) {
+            values[0] = 50;
+            values[1] = i;
+            bank->filter(values, filtered);
+            worstHold = fmax(worstHold, fabs(filtered[0] - 50));
+        }
+        float rampLag = values[1] - filtered[1];
+        printf("%s:\t seeded drift %f, ramp lag %f samples\n", names[t], worstHold, rampLag);
+
+        char label[64];
+        sprintf(label, "%s holds its seed", names[t]);
+        checkWithin(label, worstHold, TOLERANCE);
+        sprintf(label, "%s doesn't lead a ramp", names[t]);
+        check(label, rampLag >= -TOLERANCE);
+        // the alpha-beta tracker follows a ramp exactly
+        if (types[t] == FILTER_ALPHA_BETA) {
+            checkWithin("alpha-beta follows a ramp", fabs(rampLag), TOLERANCE);
+        }
+        delete bank;
+    }
+
+    return finish();
+}
@@ -0,0 +1,82 @@
+#include "../kalman_bank.h"
+#include "../extended_kalman_filter.h"
+#include "../utilities.h"
+#include "../constants.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <math.h>
+
+#define BANK_ROBOTS 5
+#define NUM_STEPS 200
+#define DT 0.2
+#define TOLERANCE 1e-2
+
+int main() {
+    KalmanBank *bank = new KalmanBank(BANK_ROBOTS);
+    ExtendedKalmanFilter *filters[BANK_ROBOTS];
+    Pose *poses[BANK_ROBOTS];
+
+    for (int r = 0; r < BANK_ROBOTS; r++) {
+        poses[r] = new Pose(10 * r, 5 * r, 0.5 * r);
+        filters[r] = new ExtendedKalmanFilter(poses[r]);
+        filters[r]->setUncertainty(0.05, 0.05, 0.05,
+                                   0.5, 0.5, 0.1,
+                                   0.05, 0.05, 0.05);
+        bank->reset(r, poses[r]);
+        bank->setUncertainty(r, 0.05, 0.05, 0.05,
+                             0.5, 0.5, 0.1,
+                             0.05, 0.05, 0.05);
+    }
+
+    float worst = 0;
+    for (int i = 0; i < NUM_STEPS; i++) {
+        // the loop's time steps aren't all the same length
+        float dt = DT * (1 + 0.5 * sin(0.7 * i));
+        for (int r = 0; r < BANK_ROBOTS; r++) {
+            // each robot drives a different circle, with measurements
+            // wobbling around the truth
+            float forward = 20 + 5 * r;
+            float turn = 0.1 * (r - 2);
+            float t = i * DT;
+            Pose ns(forward * t * cos(0.5 * r) + 3 * sin(t * (r + 1)),
+                    forward * t * sin(0.5 * r) - 2 * cos(t),
+                    0.5 * r + turn * t + 0.1 * sin(3 * t));
+            Pose we(forward * t * cos(0.5 * r),
+                    forward * t * sin(0.5 * r),
+                    0.5 * r + turn * t);
+            ns.setTheta(fmod(ns.getTheta() + 20 * PI, 2 * PI));
+            we.setTheta(fmod(we.getTheta() + 20 * PI, 2 * PI));
+
+            filters[r]->setBodyVelocity(forward, 0, turn);
+            filters[r]->setTimeStep(dt);
+            filters[r]->filter(&ns, &we);
+
+            bank->setBodyVelocity(r, forward, 0, turn);
+            bank->setMeasurements(r, &ns, &we);
+        }
+        bank->step(dt);
+
+        for (int r = 0; r < BANK_ROBOTS; r++) {
+            Pose banked(0, 0, 0);
+            bank->getPose(r, &banked);
+            float dx = fabs(banked.getX() - poses[r]->getX());
+            float dy = fabs(banked.getY() - poses[r]->getY());
+            float dtheta = fabs(Util::normalizeThetaError(banked.getTheta() - poses[r]->getTheta()));
+            worst = fmax(worst, fmax(dx, fmax(dy, dtheta)));
+        }
+    }
+
+    for (int r = 0; r < BANK_ROBOTS; r++) {
+        Pose banked(0, 0, 0);
+        bank->getPose(r, &banked);
+        kalmanHealth health;
+        bank->getHealth(r, &health);
+        printf("robot %d\t bank: %f, %f, %f\t ekf: %f, %f, %f\t steps: %d, failures: %d, repairs: %d\n",
+               r, banked.getX(), banked.getY(), banked.getTheta(),
+               poses[r]->getX(), poses[r]->getY(), poses[r]->getTheta(),
+               health.steps, health.inversionFailures, health.definitenessRepairs);
+    }
+
+    checkWithin("bank against the extended kalman filter", worst, TOLERANCE);
+    return finish();
+}
@@ -0,0 +1,65 @@
+#include "../mailbox.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_VALUES 1000000
+
+// a value big enough that a torn read would show
+struct Pair {
+    int a;
+    int b;
+};
+
+Mailbox<Pair> mailbox;
+
+// puts 0, 1, 2, ... as fast as it can, never waiting on the consumer
+void *produce(void *unused) {
+    for (int i = 0; i < NUM_VALUES; i++) {
+        Pair pair = {i, -i};
+        mailbox.put(pair);
+        if (i % 64 == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// takes from another thread while the producer runs, and makes sure
+// values only ever get newer, are never torn, the last one always
+// gets through, and every one was either taken or replaced
+int main() {
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, NULL);
+
+    int last = -1;
+    int taken = 0;
+    int older = 0;
+    int torn = 0;
+    while (last < NUM_VALUES - 1) {
+        Pair pair;
+        if (mailbox.take(&pair)) {
+            taken++;
+            if (pair.a <= last) {
+                older++;
+            }
+            if (pair.b != -pair.a) {
+                torn++;
+            }
+            last = pair.a;
+        }
+        else {
+            sched_yield();
+        }
+    }
+    pthread_join(producer, NULL);
+
+    Pair pair;
+    printf("%d values, %d taken, %d replaced\n", NUM_VALUES, taken, mailbox.getReplaced());
+    check("only newer values come out", older == 0);
+    check("no value is torn", torn == 0);
+    check("nothing is left after the last", !mailbox.take(&pair));
+    check("every value is taken or replaced", taken + mailbox.getReplaced() == NUM_VALUES);
+    return finish();
+}
@@ -0,0 +1,101 @@
+#include "../motion_profile.h"
+#include "../constants.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <math.h>
+
+#define DIST_LIMIT 20.0
+#define THETA_LIMIT 0.2
+#define MAX_PASSES 100
+
+// a cell is 65 cm across (CELL_SIZE in robot.h)
+#define CELL 65.0
+
+// SPEED_TURN's columns are DIR_LEFT (0) and DIR_RIGHT (1) from robot.h
+#define DIR_RIGHT_COLUMN 1
+
+// a turn pass in Robot is the turn pulse plus waiting on the next
+// estimate, so it's longer than the control loop period
+#define TURN_PASS 0.5
+
+// runs a move like Robot's loops do: each pass sees how far is left,
+// and the speed it sends takes effect over the next pass (for as long
+// as its pulse lasts, if it has one). makes sure it stops inside the
+// limit without ever overshooting past it, and never speeds up by
+// more than the acceleration limit (other than starting off at the
+// slowest speed the robot has)
+void move(const char *name, MotionProfile *profile, const float *speeds,
+          int stride, const float *pulses, float dt, float accel,
+          float goal, float limit) {
+    float position = 0;
+    float velocity = 0;
+    float worstOvershoot = 0;
+    bool accelOk = true;
+    int passes = 0;
+
+    profile->start();
+    while (fabs(goal - position) > limit && passes < MAX_PASSES) {
+        int speed = profile->speed(goal - position - limit / 2, dt);
+        float next = (speed == 0) ? 0 : fabs(speeds[speed * stride]);
+        if (pulses != NULL && pulses[speed] < dt) {
+            next *= pulses[speed] / dt;
+        }
+        if (velocity > 0 && next - velocity > accel * dt + 1e-3) {
+            accelOk = false;
+        }
+        velocity = next;
+        position += velocity * dt;
+        worstOvershoot = fmax(worstOvershoot, position - goal);
+        passes++;
+    }
+
+    printf("%s: %d passes, ended %.2f from the goal, worst overshoot %.2f\n",
+           name, passes, goal - position, worstOvershoot);
+    char label[128];
+    sprintf(label, "%s finishes", name);
+    check(label, passes < MAX_PASSES);
+    sprintf(label, "%s doesn't overshoot", name);
+    check(label, worstOvershoot <= limit);
+    sprintf(label, "%s keeps to the acceleration limit", name);
+    check(label, accelOk);
+}
+
+int main() {
+    // the pulses Robot's turns make (see Robot::_turnPulse)
+    float turnPulses[NUM_SPEEDS];
+    for (int speed = 0; speed < NUM_SPEEDS; speed++) {
+        turnPulses[speed] = TURN_PULSE_LENGTH;
+        if (speed > TURN_PULSE_SPEED) {
+            turnPulses[speed] -= TURN_PULSE_STEP * (speed - TURN_PULSE_SPEED);
+        }
+    }
+
+    MotionProfile moveProfile(PROFILE_MOVE_ACCEL, PROFILE_MOVE_DECEL);
+    moveProfile.setSpeeds(SPEED_FORWARD, 1);
+    move("short move", &moveProfile, SPEED_FORWARD, 1, NULL,
+         CONTROL_LOOP_PERIOD, PROFILE_MOVE_ACCEL, 30, DIST_LIMIT);
+    move("one cell", &moveProfile, SPEED_FORWARD, 1, NULL,
+         CONTROL_LOOP_PERIOD, PROFILE_MOVE_ACCEL, CELL, DIST_LIMIT);
+    move("three cells", &moveProfile, SPEED_FORWARD, 1, NULL,
+         CONTROL_LOOP_PERIOD, PROFILE_MOVE_ACCEL, 3 * CELL, DIST_LIMIT);
+
+    MotionProfile turnProfile(PROFILE_TURN_ACCEL, PROFILE_TURN_DECEL);
+    turnProfile.setSpeeds(&SPEED_TURN[0][DIR_RIGHT_COLUMN], 2);
+    move("quarter turn", &turnProfile, &SPEED_TURN[0][DIR_RIGHT_COLUMN], 2, NULL,
+         CONTROL_LOOP_PERIOD, PROFILE_TURN_ACCEL, DEGREE_90, THETA_LIMIT);
+    move("half turn", &turnProfile, &SPEED_TURN[0][DIR_RIGHT_COLUMN], 2, NULL,
+         CONTROL_LOOP_PERIOD, PROFILE_TURN_ACCEL, DEGREE_180, THETA_LIMIT);
+
+    // and again with turns that stop partway through each pass
+    turnProfile.setPulses(turnPulses);
+    move("quarter turn in pulses", &turnProfile, &SPEED_TURN[0][DIR_RIGHT_COLUMN], 2,
+         turnPulses, TURN_PASS, PROFILE_TURN_ACCEL, DEGREE_90, THETA_LIMIT);
+    move("half turn in pulses", &turnProfile, &SPEED_TURN[0][DIR_RIGHT_COLUMN], 2,
+         turnPulses, TURN_PASS, PROFILE_TURN_ACCEL, DEGREE_180, THETA_LIMIT);
+
+    // at rest with nothing left, it should stop
+    moveProfile.start();
+    check("stops with nothing left", moveProfile.speed(0, CONTROL_LOOP_PERIOD) == 0);
+
+    return finish();
+}
@@ -0,0 +1,72 @@
+#include "../path_follower.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <math.h>
+
+#define LOOKAHEAD 40.0
+#define STEP 5.0
+#define MAX_STEPS 500
+#define TOLERANCE 20.0
+
+// an L through four cell centers: two cells east, then two north
+const float PATH_X[] = {0, 65, 130, 130, 130};
+const float PATH_Y[] = {0, 0, 0, 65, 130};
+#define NUM_WAYPOINTS 5
+
+// drives a point robot straight at the lookahead point a step at a
+// time (starting off the path), and makes sure it passes every
+// waypoint in order, stays near the path, and finishes
+int main() {
+    PathFollower follower(LOOKAHEAD);
+    follower.setPath(PATH_X, PATH_Y, NUM_WAYPOINTS);
+
+    float x = 0;
+    float y = -15;
+    int reached = 0;
+    bool inOrder = true;
+    float remaining = follower.getRemaining();
+    bool shrinking = true;
+    float worstOffPath = 0;
+    int steps = 0;
+
+    follower.update(x, y);
+    while (!follower.isDone(TOLERANCE) && steps < MAX_STEPS) {
+        float dx = follower.getLookaheadX() - x;
+        float dy = follower.getLookaheadY() - y;
+        float distance = sqrt(dx * dx + dy * dy);
+        if (distance > STEP) {
+            dx *= STEP / distance;
+            dy *= STEP / distance;
+        }
+        x += dx;
+        y += dy;
+        follower.update(x, y);
+        steps++;
+
+        if (follower.getReached() < reached || follower.getReached() > reached + 1) {
+            inOrder = false;
+        }
+        reached = follower.getReached();
+        if (follower.getRemaining() > remaining + 1e-3) {
+            shrinking = false;
+        }
+        remaining = follower.getRemaining();
+
+        // off the L: distance to the nearer leg, once we're past the start
+        if (steps > 10) {
+            float offEast = (x <= 130) ? fabs(y) : sqrt((x - 130) * (x - 130) + y * y);
+            float offNorth = (y >= 0) ? fabs(x - 130) : sqrt((x - 130) * (x - 130) + y * y);
+            worstOffPath = fmax(worstOffPath, fmin(offEast, offNorth));
+        }
+    }
+
+    printf("%d steps, reached waypoint %d, %.1f cm left, worst %.1f cm off the path\n",
+           steps, follower.getReached(), follower.getRemaining(), worstOffPath);
+
+    check("reaches the end", follower.isDone(TOLERANCE));
+    check("reaches the waypoints in order", inOrder);
+    check("the distance left only shrinks", shrinking);
+    check("passes the waypoints", follower.getReached() >= NUM_WAYPOINTS - 2);
+    checkWithin("stays on the path", worstOffPath, LOOKAHEAD / 2);
+    return finish();
+}
@@ -1,5 +1,8 @@
 #include "../PID.h"
+#include "../constants.h"
+#include "test_check.h"
 #include <stdio.h>
+#include <math.h>
 
 #define PID_KP 0.8
 #define PID_KI 0.25
@@ -8,6 +11,17 @@
 #define MIN_ERROR -1.0
 #define MAX_ERROR 1.0
 
+// SPEED_TURN's columns are DIR_LEFT (0) and DIR_RIGHT (1) from robot.h
+#define DIR_RIGHT_COLUMN 1
+
+#define TOLERANCE 1e-5
+
+// a PID with only the given term
+PID *only(float kp, float ki, float kd) {
+    PIDConstants constants = {kp, ki, kd};
+    return new PID(&constants, MIN_ERROR, MAX_ERROR);
+}
+
 int main() {
     float error, gain, speed;
 
@@ -36,6 +50,53 @@ int main() {
         printf("Error: %f\t Gain: %f\t Speed: %f\n",
                error, gain, speed);
     }
-    
-    return 0;
+    delete pid;
+
+    // the integral goes by time, not by how many updates there were
+    PID *twice = only(0, 0.1, 0);
+    PID *once = only(0, 0.1, 0);
+    twice->updatePID(0.5, CONTROL_LOOP_PERIOD / 2);
+    twice->updatePID(0.5, CONTROL_LOOP_PERIOD / 2);
+    once->updatePID(0.5, CONTROL_LOOP_PERIOD);
+    check("integral scales with dt",
+          fabs(twice->currentIntegratorError() - once->currentIntegratorError()) < TOLERANCE);
+    delete twice;
+    delete once;
+
+    // held at full gain, the integral stops growing, so the
+    // gain drops as soon as the error changes sign
+    PID *windup = only(0.8, 0.25, 0);
+    for (int i = 0; i < 50; i++) {
+        windup->updatePID(MAX_ERROR);
+    }
+    check("integral doesn't wind up",
+          windup->currentIntegratorError() <= MAX_ERROR + TOLERANCE);
+    check("gain drops right after overshooting",
+          windup->updatePID(-0.5) < 0.5);
+    delete windup;
+
+    // a step in the error only comes through the derivative partway,
+    // and the first update doesn't count as a step from 0
+    PID *derivative = only(0, 0, 0.5);
+    check("no derivative kick on the first update",
+          derivative->updatePID(0.8) == 0);
+    derivative->flushPID();
+    derivative->updatePID(0);
+    gain = derivative->updatePID(1.0);
+    check("derivative is low-passed", gain > 0 && gain < 0.5);
+    delete derivative;
+
+    // feed-forward picks the slowest robot speed that's fast enough
+    PID *forward = only(0, 0, 0);
+    forward->setFeedForward(SPEED_FORWARD, 1);
+    check("feed-forward gain for speed 6",
+          fabs(forward->feedForward(SPEED_FORWARD[6]) - 4 / 9.0) < TOLERANCE);
+    check("feed-forward asks for full speed past the fastest",
+          forward->updatePID(0, CONTROL_LOOP_PERIOD, 1000) == 1.0);
+    forward->setFeedForward(&SPEED_TURN[0][DIR_RIGHT_COLUMN], 2);
+    check("feed-forward works on a turn column",
+          fabs(forward->feedForward(SPEED_TURN[10][DIR_RIGHT_COLUMN])) < TOLERANCE);
+    delete forward;
+
+    return finish();
 }
@@ -0,0 +1,76 @@
+#include "../pose_array.h"
+#include "../utilities.h"
+#include "../constants.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define MAX_POSES 13
+#define TOLERANCE 1e-3
+
+float worst = 0;
+
+void compare(float expected, float actual) {
+    worst = fmax(worst, fabs(expected - actual) / fmax(1, fabs(expected)));
+}
+
+float thetaDifference(float a, float b) {
+    float d = fabs(a - b);
+    return fmin(d, 2 * PI - d);
+}
+
+// runs the same operations on Poses one at a time and on a PoseArray,
+// for every size up to MAX_POSES so the SSE loops and their tails are
+// both covered
+int main() {
+    srand(1567);
+    for (int n = 0; n <= MAX_POSES; n++) {
+        PoseArray first(n);
+        PoseArray second(n);
+        PoseArray difference(0);
+        Pose *poses[MAX_POSES];
+        Pose *others[MAX_POSES];
+        for (int i = 0; i < n; i++) {
+            poses[i] = new Pose(rand() % 2000 - 1000, rand() % 2000 - 1000, (rand() % 628) / 100.0);
+            others[i] = new Pose(rand() % 2000 - 1000, rand() % 2000 - 1000, (rand() % 628) / 100.0);
+            first.set(i, poses[i]);
+            second.set(i, others[i]);
+        }
+
+        first.rotate(0.7);
+        first.scale(49.2, 37.1);
+        first.translate(223, 59);
+        for (int i = 0; i < n; i++) {
+            poses[i]->rotate(0.7);
+            poses[i]->scale(49.2, 37.1);
+            poses[i]->translate(223, 59);
+        }
+
+        float distances[MAX_POSES];
+        PoseArray::difference(&first, &second, &difference);
+        PoseArray::distance(&first, &second, distances);
+
+        Pose pose(0, 0, 0);
+        Pose expected(0, 0, 0);
+        for (int i = 0; i < n; i++) {
+            first.get(i, &pose);
+            compare(poses[i]->getX(), pose.getX());
+            compare(poses[i]->getY(), pose.getY());
+            worst = fmax(worst, thetaDifference(poses[i]->getTheta(), pose.getTheta()));
+
+            poses[i]->difference(poses[i], others[i], &expected);
+            difference.get(i, &pose);
+            compare(expected.getX(), pose.getX());
+            compare(expected.getY(), pose.getY());
+            worst = fmax(worst, thetaDifference(expected.getTheta(), pose.getTheta()));
+            compare(poses[i]->distance(poses[i], others[i]), distances[i]);
+
+            delete poses[i];
+            delete others[i];
+        }
+    }
+
+    checkWithin(POSE_ARRAY_SSE ? "PoseArray (sse)" : "PoseArray (scalar)", worst, TOLERANCE);
+    return finish();
+}
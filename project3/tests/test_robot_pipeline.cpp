@@ -0,0 +1,138 @@
+// runs the pipeline's threads against this file's stand-in for the
+// robot, with just the calls the pipeline makes: sensors that count
+// up, an estimate that is the last sample it saw, and drive commands
+// that block like a rovio's turn does
+#include "../robot.h"
+#include "../robot_pipeline.h"
+#include "../constants.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAX_ISSUED 100
+
+// how long (microseconds) a drive command keeps the act thread busy
+#define COMMAND_USEC 1000000
+
+volatile int numSensed = 0;
+volatile int numEstimated = 0;
+volatile bool inOrder = true;
+volatile int lastSpeed = -1;
+
+volatile int issued[MAX_ISSUED];
+volatile int numIssued = 0;
+volatile bool issuing = false;
+
+Robot::Robot(std::string address, int id) {}
+Robot::~Robot() {}
+
+bool Robot::readSensors(SensorSample *sample) {
+    sample->time = RobotPipeline::now();
+    sample->updated = true;
+    sample->room = 0;
+    sample->nsX = ++numSensed;
+    sample->nsY = 0;
+    sample->nsTheta = 0;
+    sample->wheelLeft = 0;
+    sample->wheelRight = 0;
+    sample->wheelRear = 0;
+    return true;
+}
+
+void Robot::estimatePose(const SensorSample *sample, const MotionState *motion,
+                         bool useWheelEncoders, float dt) {
+    if (sample->nsX != numEstimated + 1) {
+        inOrder = false;
+    }
+    numEstimated = (int) sample->nsX;
+    lastSpeed = motion->speed;
+}
+
+void Robot::getEstimate(Estimate *estimate) {
+    estimate->x = numEstimated;
+    estimate->y = 0;
+    estimate->theta = 0;
+    estimate->nsTheta = 0;
+}
+
+MotionState Robot::getMotionState() {
+    MotionState motion = {0, false, 0, 0};
+    return motion;
+}
+
+MotionState Robot::issueCommand(const MotionCommand *command) {
+    issuing = true;
+    if (numIssued < MAX_ISSUED) {
+        issued[numIssued] = command->type;
+    }
+    numIssued++;
+    usleep(COMMAND_USEC);
+    issuing = false;
+
+    MotionState motion = {command->speed, command->type == CMD_FORWARD, 0, 0};
+    return motion;
+}
+
+int main() {
+    Robot robot("fake", 1);
+    RobotPipeline pipeline(&robot);
+
+    check("starts", pipeline.start(true) && pipeline.isRunning());
+
+    // estimates come at the control loop's rate, each one newer
+    Estimate estimate;
+    float lastX = 0;
+    bool newer = true;
+    double worstDt = 0;
+    for (int i = 0; i < 5; i++) {
+        float dt = pipeline.waitForEstimate(&estimate);
+        newer = newer && estimate.x > lastX;
+        lastX = estimate.x;
+        if (i > 0) {
+            worstDt = fmax(worstDt, fabs(dt - CONTROL_LOOP_PERIOD));
+        }
+    }
+    check("estimates only get newer", newer);
+    checkWithin("estimates come every control loop period", worstDt,
+                CONTROL_LOOP_PERIOD / 2);
+
+    // a command that blocks holds up only the act thread, and the ones
+    // sent while it's busy are replaced by the newest
+    pipeline.command(CMD_TURN_LEFT, 5);
+    while (!issuing) {
+        usleep(1000);
+    }
+    pipeline.command(CMD_TURN_RIGHT, 5);
+    pipeline.command(CMD_BACKWARD, 4);
+    pipeline.command(CMD_FORWARD, 3);
+    int during = 0;
+    while (issuing) {
+        pipeline.waitForEstimate(&estimate);
+        during++;
+    }
+    printf("%d estimates while a command blocked\n", during);
+    check("estimates keep coming while a command blocks", during >= 3);
+
+    while (numIssued < 2 || issuing) {
+        usleep(1000);
+    }
+    usleep(COMMAND_USEC / 2);
+    printf("%d commands issued\n", numIssued);
+    check("only the first and newest commands are issued",
+          numIssued == 2 && issued[0] == CMD_TURN_LEFT &&
+          issued[1] == CMD_FORWARD);
+
+    // the estimate thread hears how the robot is moving now
+    pipeline.waitForEstimate(&estimate);
+    pipeline.waitForEstimate(&estimate);
+    check("estimates use the newest command's motion", lastSpeed == 3);
+
+    pipeline.stop();
+    int sensed = numSensed;
+    usleep(COMMAND_USEC / 2);
+    check("stops", !pipeline.isRunning() && numSensed == sensed);
+    check("every sample is estimated in order", inOrder);
+
+    return finish();
+}
@@ -0,0 +1,54 @@
+#include "../spsc_queue.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_VALUES 1000000
+#define CAPACITY 8
+
+SPSCQueue<int> queue(CAPACITY);
+
+// pushes 0, 1, 2, ... retrying whenever the queue is full (yielding,
+// in case both threads share one processor)
+void *produce(void *unused) {
+    for (int i = 0; i < NUM_VALUES; i++) {
+        while (!queue.push(i)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// pops from another thread while the producer runs, and makes
+// sure every value comes out exactly once and in order
+int main() {
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, NULL);
+
+    int expected = 0;
+    int outOfOrder = 0;
+    while (expected < NUM_VALUES) {
+        int value;
+        if (queue.pop(&value)) {
+            if (value != expected) {
+                outOfOrder++;
+            }
+            expected = value + 1;
+        }
+        else {
+            sched_yield();
+        }
+    }
+    pthread_join(producer, NULL);
+
+    int value;
+    bool empty = !queue.pop(&value);
+
+    printf("%d values, %d out of order, %d full pushes retried\n",
+           NUM_VALUES, outOfOrder, queue.getDropped());
+
+    check("values come out in order", outOfOrder == 0);
+    check("the queue ends empty", empty);
+    return finish();
+}
@@ -18,6 +18,11 @@
 #include <stdlib.h>
 #include <math.h>
 #include <algorithm>
+#include <unistd.h>
+
+#ifdef USE_SIMULATOR
+#include "data/fakerobot/sim_clock.h"
+#endif
 
 namespace Util {
     /**************************************
@@ -128,4 +133,41 @@ namespace Util {
     int capSpeed(int speed, int cap) {
         return std::min(std::max(speed, 1), cap);
     }
+
+    /**************************************
+     * Definition: Returns the time since the given time, and resets
+     *             the given time to now
+     *
+     * Parameters: pointer to a timeval to measure from
+     *
+     * Returns:    elapsed seconds as a float
+     **************************************/
+    float elapsedSeconds(struct timeval *since) {
+        struct timeval now;
+#ifdef USE_SIMULATOR
+        double simulated = SimClock::now();
+        now.tv_sec = (time_t) simulated;
+        now.tv_usec = (suseconds_t) ((simulated - now.tv_sec) * 1000000);
+#else
+        gettimeofday(&now, NULL);
+#endif
+        float elapsed = (now.tv_sec - since->tv_sec) + 
+                        (now.tv_usec - since->tv_usec) / 1000000.0;
+        *since = now;
+        return elapsed;
+    }
+
+    /**************************************
+     * Definition: Waits a while, for the robot to finish something.
+     *             In the simulator, the simulated clock just moves on
+     *
+     * Parameters: how long in seconds
+     **************************************/
+    void pause(float seconds) {
+#ifdef USE_SIMULATOR
+        SimClock::advance(seconds);
+#else
+        usleep((useconds_t) (seconds * 1000000));
+#endif
+    }
 };
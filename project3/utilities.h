@@ -15,6 +15,7 @@
 #define CS1567_UTILITIES_H
 
 #include <string>
+#include <sys/time.h>
 
 #define NUM_ROBOTS 6
 
@@ -54,6 +55,10 @@ namespace Util {
 	float mapValue(float value, float leftMin, float leftMax, float rightMin, float rightMax);
 
     int capSpeed(int speed, int cap);
+
+    float elapsedSeconds(struct timeval *since);
+
+    void pause(float seconds);
     
     int nameFrom(std::string);
 };
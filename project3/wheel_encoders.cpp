@@ -7,6 +7,8 @@
  *      (except for when to update the data). It keeps a pose, stores 
  *      the raw and filtered wheel encoder data, and contains functions for converting 
  *      the data into global coordinates to be stored back in the pose.
+ *      The three omni wheels' ticks are turned into the robot's strafe,
+ *      forward motion, and turn all at once by inverting their kinematics.
  * 
  * @author
  * 		Shawn Hanna
@@ -16,127 +18,142 @@
  **/
 
 #include "wheel_encoders.h"
+#include "fir_bank.h"
+#include "iir_bank.h"
+#include "extended_kalman_filter.h"
 #include "constants.h"
 #include "utilities.h"
 #include "logger.h"
-#include <robot_if++.h>
+#include "robot_interface.h"
 #include "robot.h"
 
 WheelEncoders::WheelEncoders(Robot *robot)
 : PositionSensor(robot) {
-	_filterLeft = new FIRFilter("filters/we.ffc");
-	_filterRight = new FIRFilter("filters/we.ffc");
-	_filterRear = new FIRFilter("filters/we.ffc");
+	// all three wheels share the same filter
+	if (WE_FILTER == FILTER_FIR) {
+		_filters = new FIRBank(NUM_CHANNELS, "filters/we.ffc");
+	}
+	else {
+		_filters = new IIRBank(NUM_CHANNELS, WE_FILTER, WE_IIR_CUTOFF);
+	}
+	_setKinematics(robot->getName());
 }
 
 WheelEncoders::~WheelEncoders() {
-	delete _filterLeft;
-	delete _filterRight;
-	delete _filterRear;
+	delete _filters;
 }
 
 /************************************************
 * Definition: Translates incremental wheel encoder data to 
 *             global coordinate system and updates robot pose
 *
-* Note:       Requires the interface be updated prior to calling 
+* Parameters: the newest sensor sample
 ************************************************/
-void WheelEncoders::updatePose() {
-	float x = getX() + _getDeltaX();
-	float y = getY() + _getDeltaY();
-	float theta = Util::normalizeTheta(getTheta() + _getDeltaTheta());
+void WheelEncoders::updatePose(const SensorSample *sample) {
+	// read and filter every wheel exactly once per update
+	float raw[NUM_CHANNELS];
+	float filtered[NUM_CHANNELS];
+	_getDeltas(sample, raw, filtered);
 
-	_pose->setX(x);
-	_pose->setY(y);
-	_pose->setTheta(theta);
-}
+	// x and y come from the filtered ticks, but theta comes from the
+	// raw ones so it doesn't lag behind north star when spinning
+	float filteredMotion[3];
+	float rawMotion[3];
+	_getBodyMotion(filtered, filteredMotion);
+	_getBodyMotion(raw, rawMotion);
+	float strafe = filteredMotion[0];
+	float forward = filteredMotion[1];
+	float turn = rawMotion[2];
 
-/************************************************
- * Definition: Translates wheel encoder motion from robot axis 
- *             into the corresponding change in X in the global coordinate system  
- *
- * Returns:    delta x in terms of global coordinate system 
- ***********************************************/
-float WheelEncoders::_getDeltaX() {
-	float scaledDeltaX = _getRobotDeltaY() / WE_SCALE;
-	float rotatedDeltaX = scaledDeltaX * cos(getTheta());
-    return rotatedDeltaX;
-}
+	// forward is along theta, and strafing is to its right
+	float theta = getTheta();
+	float x = getX() + forward * cos(theta) + strafe * sin(theta);
+	float y = getY() + forward * sin(theta) - strafe * cos(theta);
 
-/************************************************
- * Definition: Translates wheel encoder motion from robot axis 
- *             into the corresponding change in Y in the global coordinate system  
- *
- * Returns:    delta y in terms of global coordinate system 
- ***********************************************/
-float WheelEncoders::_getDeltaY() {
-	float scaledDeltaY = _getRobotDeltaY() / WE_SCALE;
-	float rotatedDeltaY = scaledDeltaY * sin(getTheta());
-    return rotatedDeltaY;
-}
-
-/************************************************
- * Definition: Translates wheel encoder motion from robot axis 
- *             into the corresponding change in theta in the global coordinate system  
- *
- * Returns:    delta theta in terms of global coordinate system 
- ***********************************************/
-float WheelEncoders::_getDeltaTheta() {
-	float rearRobotDeltaX = _getFilteredDeltaRear();
-	float scaledRobotDeltaX = rearRobotDeltaX / WE_SCALE;
-	return -scaledRobotDeltaX / (ROBOT_DIAMETER / 2.0);
+	_pose->setX(x);
+	_pose->setY(y);
+	_pose->setTheta(Util::normalizeTheta(theta + turn));
 }
 
 /************************************************
- * Definition: Translates wheel encoder ticks into the robot coordinate system  
+ * Definition: Builds the matrix that turns the wheels' motion into
+ *             the robot's. Each wheel rolls along its own direction
+ *             (the left and right wheels 60 degrees either side of
+ *             straight ahead, the rear one sideways) and a turn rolls
+ *             all of them around the robot's edge. A wheel that can't
+ *             be trusted has its row swapped for an assumption about
+ *             the motion instead
  *
- * Returns:    delta y in robot coordinate system
+ * Parameters: the robot's name
  ***********************************************/
-float WheelEncoders::_getRobotDeltaY() {
-    float leftRobotDeltaY = -_getFilteredDeltaLeft() * cos(DEGREE_150);
-    float rightRobotDeltaY = _getFilteredDeltaRight() * cos(DEGREE_30);
-    
-    // some robots have bad wheel encoders for one side,
-    // so account for this by faking the data on the opposite
-    // wheel
-    switch (_robot->getName()) {
-    case ROSIE:
-    	rightRobotDeltaY = leftRobotDeltaY;
-    	break;
-    case OPTIMUS:
-    	leftRobotDeltaY = rightRobotDeltaY;
-    	break;
-    }
-    float avgRobotDeltaY = (leftRobotDeltaY + rightRobotDeltaY) / 2.0;
-    return avgRobotDeltaY;
-}
+void WheelEncoders::_setKinematics(int name) {
+	float radius = ROBOT_DIAMETER / 2.0;
+	// cm each wheel rolls per cm of {strafe right, forward} and radian of turn
+	float wheels[NUM_CHANNELS][3] = {
+		{(float) cos(DEGREE_60), (float) sin(DEGREE_60), -radius},
+		{(float) -cos(DEGREE_60), (float) sin(DEGREE_60), radius},
+		{-1, 0, -radius}
+	};
+	// no strafing, no turning, or no driving forward, most likely first
+	float assumptions[3][3] = {
+		{1, 0, 0},
+		{0, 0, 1},
+		{0, 1, 0}
+	};
+	// the orders to try the assumptions in, in case the first
+	// ones don't pin the motion down
+	int orders[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
 
-/************************************************
- * Definition: Returns filtered wheel encoder ticks for left wheel
- *
- * Returns:    delta left ticks
- ***********************************************/
-float WheelEncoders::_getFilteredDeltaLeft() {
-    int left = _robot->getInterface()->getWheelEncoder(RI_WHEEL_LEFT);
-    return _filterLeft->filter((float) left);
+	for (int order = 0; order < 6; order++) {
+		float kinematics[9];
+		int next = 0;
+		for (int w = 0; w < NUM_CHANNELS; w++) {
+			_healthy[w] = WE_WHEEL_HEALTHY[name][w];
+			float *row = _healthy[w] ? wheels[w] : assumptions[orders[order][next++]];
+			for (int j = 0; j < 3; j++) {
+				kinematics[w * 3 + j] = row[j];
+			}
+		}
+		if (ExtendedKalmanFilter::invert3(kinematics, _inverse)) {
+			return;
+		}
+	}
+	// every order is always invertible, but never move rather than guess
+	for (int i = 0; i < 9; i++) {
+		_inverse[i] = 0;
+	}
 }
 
 /************************************************
- * Definition: Returns filtered wheel encoder ticks for right wheel
+ * Definition: Turns wheel ticks into the robot's motion
  *
- * Returns:    delta right ticks
+ * Parameters: delta ticks for the left, right, and rear wheels, and
+ *             an array to put the strafe right and forward motion
+ *             (in cm) and the counter-clockwise turn (in radians) in
  ***********************************************/
-float WheelEncoders::_getFilteredDeltaRight() {
-    int right = _robot->getInterface()->getWheelEncoder(RI_WHEEL_RIGHT);
-    return _filterRight->filter((float) right);
+void WheelEncoders::_getBodyMotion(const float *ticks, float *motion) {
+	float wheels[NUM_CHANNELS];
+	for (int w = 0; w < NUM_CHANNELS; w++) {
+		// an assumption's row says that motion is zero
+		wheels[w] = _healthy[w] ? ticks[w] / WE_SCALE : 0;
+	}
+	for (int i = 0; i < 3; i++) {
+		motion[i] = _inverse[i * 3] * wheels[0] + 
+		            _inverse[i * 3 + 1] * wheels[1] + 
+		            _inverse[i * 3 + 2] * wheels[2];
+	}
 }
 
 /************************************************
- * Definition: Returns filtered wheel encoder ticks for rear wheel
+ * Definition: Takes the newest ticks for all three wheels from a
+ *             sensor sample and filters them together
  *
- * Returns:    delta rear ticks
+ * Parameters: the sensor sample, and float arrays to put the raw
+ *             and filtered left, right, and rear delta ticks in
  ***********************************************/
-float WheelEncoders::_getFilteredDeltaRear() {
-    int rear = _robot->getInterface()->getWheelEncoder(RI_WHEEL_REAR);
-    return _filterRear->filter((float) rear);
+void WheelEncoders::_getDeltas(const SensorSample *sample, float *raw, float *filtered) {
+    raw[CHANNEL_LEFT] = sample->wheelLeft;
+    raw[CHANNEL_RIGHT] = sample->wheelRight;
+    raw[CHANNEL_REAR] = sample->wheelRear;
+    _filters->filter(raw, filtered);
 }
@@ -7,6 +7,8 @@
  *      (except for when to update the data). It keeps a pose, stores 
  *      the raw and filtered wheel encoder data, and contains functions for converting 
  *      the data into global coordinates to be stored back in the pose.
+ *      The three omni wheels' ticks are turned into the robot's strafe,
+ *      forward motion, and turn all at once by inverting their kinematics.
  * 
  * @author
  * 		Shawn Hanna
@@ -19,25 +21,24 @@
 #define CS1567_WHEELENCODERS_H
 
 #include "position_sensor.h"
-#include "fir_filter.h"
+#include "sensor_filter.h"
 
 class WheelEncoders : public PositionSensor {
 public:
 	WheelEncoders(Robot *robot);
 	~WheelEncoders();
-	void updatePose();
+	void updatePose(const SensorSample *sample);
 private:
-	FIRFilter *_filterLeft;
-	FIRFilter *_filterRight;
-	FIRFilter *_filterRear;
+	enum { CHANNEL_LEFT, CHANNEL_RIGHT, CHANNEL_REAR, NUM_CHANNELS };
 
-	float _getDeltaX();
-	float _getDeltaY();
-	float _getDeltaTheta();
-	float _getRobotDeltaY();
-	float _getFilteredDeltaLeft();
-	float _getFilteredDeltaRight();
-	float _getFilteredDeltaRear();
+	SensorFilter *_filters;
+	// body motion {strafe right, forward (cm), turn (radians)} = _inverse * wheel motion (cm)
+	float _inverse[9];
+	bool _healthy[NUM_CHANNELS];
+
+	void _setKinematics(int name);
+	void _getBodyMotion(const float *ticks, float *motion);
+	void _getDeltas(const SensorSample *sample, float *raw, float *filtered);
 };
 
 #endif
\ No newline at end of file